@@ -0,0 +1,204 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "AnimationFrames.h"
+#include "Common/ChunkData.h"
+#include "Common/Helpers.h"
+#include "ImageLoader.h"
+#include "QuadImage.h"
+#include "Renderer.h"
+
+#include <algorithm>
+
+cAnimationFrames::cAnimationFrames(ImageFactory factory)
+    : m_factory(std::move(factory))
+{
+}
+
+cAnimationFrames::~cAnimationFrames()
+{
+    stop();
+}
+
+uint32_t cAnimationFrames::calculateDepth(uint32_t width, uint32_t height, uint32_t bpp, uint32_t images, size_t budget)
+{
+    // Tiled canvases keep an overview that sub-rect updates can't follow.
+    if (images < 2 || width == 0 || height == 0
+        || width > render::calculateTextureSize(width)
+        || height > render::calculateTextureSize(height))
+    {
+        return 0;
+    }
+
+    // Texture with its mip chain.
+    const size_t slotBytes = static_cast<size_t>(helpers::calculatePitch(width, bpp)) * height * 4 / 3;
+    const size_t depth     = std::min<size_t>(images, budget / slotBytes);
+
+    return depth < 2 ? 0 : static_cast<uint32_t>(depth);
+}
+
+void cAnimationFrames::start(uint32_t depth, uint32_t images, uint32_t frame, uint32_t delay)
+{
+    stop();
+
+    m_depth  = depth;
+    m_images = images;
+    m_shown  = 0;
+    m_filled = 0;
+    m_slots.resize(depth);
+
+    // Slot 0 is on screen, its image stays with the caller.
+    auto& slot = m_slots[0];
+    slot.frame = frame;
+    slot.delay = delay;
+    slot.ready = true;
+}
+
+void cAnimationFrames::stop()
+{
+    for (auto& slot : m_slots)
+    {
+        if (slot.image != nullptr)
+        {
+            slot.image->clear();
+        }
+    }
+    m_slots.clear();
+
+    m_depth  = 0;
+    m_images = 0;
+}
+
+bool cAnimationFrames::update(cImageLoader& loader, const sChunkData& canvas)
+{
+    if (isActive() == false)
+    {
+        return true;
+    }
+
+    for (auto& slot : m_slots)
+    {
+        if (slot.pixels.empty() == false && slot.image->upload(canvas.height))
+        {
+            slot.pixels = {};
+            slot.ready  = true;
+        }
+    }
+
+    bool taken = false;
+    while (m_filled + 1 < m_shown + m_depth)
+    {
+        auto& slot = m_slots[(m_filled + 1) % m_depth];
+        if (slot.pixels.empty() == false)
+        {
+            break; // previous frame of the slot still uploading
+        }
+
+        cImageLoader::Frame frame;
+        if (loader.popFrame(frame) == false)
+        {
+            break;
+        }
+        taken = true;
+
+        const auto& rect = frame.rect;
+        if (rect.w == canvas.width && rect.h == canvas.height)
+        {
+            if (slot.image == nullptr)
+            {
+                slot.image = m_factory();
+                slot.image->useFilter(m_filter);
+            }
+            slot.pixels = std::move(frame.pixels);
+            slot.image->setBuffer(canvas.width, canvas.height, frame.pitch, canvas.format, canvas.bpp, slot.pixels.data(), 0, canvas.effects);
+            if (canvas.palette.empty() == false)
+            {
+                slot.image->setPaletteData(canvas.palette);
+            }
+            slot.ready = false;
+            if (slot.image->upload(canvas.height))
+            {
+                slot.pixels = {};
+                slot.ready  = true;
+            }
+        }
+        else if (slot.image == nullptr || slot.image->updateRect(rect.x, rect.y, rect.w, rect.h, frame.pixels.data(), frame.pitch) == false)
+        {
+            return false;
+        }
+        else
+        {
+            slot.ready = true;
+        }
+
+        m_filled++;
+        slot.sequence = m_filled;
+        slot.frame    = frame.index;
+        slot.delay    = frame.delay;
+    }
+
+    if (taken)
+    {
+        loader.decodeAhead();
+    }
+
+    return true;
+}
+
+bool cAnimationFrames::isUploading() const
+{
+    for (const auto& slot : m_slots)
+    {
+        if (slot.pixels.empty() == false)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool cAnimationFrames::isNextReady() const
+{
+    if (isActive() == false)
+    {
+        return false;
+    }
+
+    // Once every frame has its own slot they are reused round after round.
+    const auto next  = m_shown + 1;
+    const auto& slot = m_slots[next % m_depth];
+    return slot.ready && slot.image != nullptr
+        && (slot.sequence == next || isResident());
+}
+
+void cAnimationFrames::flip(std::unique_ptr<cQuadImage>& shown, uint32_t& frame, uint32_t& delay)
+{
+    auto& prev = m_slots[m_shown % m_depth];
+    m_shown++;
+    auto& next = m_slots[m_shown % m_depth];
+
+    prev.image = std::move(shown);
+    shown      = std::move(next.image);
+
+    frame = next.frame;
+    delay = next.delay;
+}
+
+void cAnimationFrames::useFilter(bool filter)
+{
+    m_filter = filter;
+    for (auto& slot : m_slots)
+    {
+        if (slot.image != nullptr)
+        {
+            slot.image->useFilter(filter);
+        }
+    }
+}
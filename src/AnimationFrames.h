@@ -0,0 +1,79 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include "Common/Buffer.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class cImageLoader;
+class cQuadImage;
+struct sChunkData;
+
+// Ring of GPU images the frames decoded ahead by cImageLoader rotate
+// through. Frame sequence n lives in slot n % depth; the shown slot's image
+// is owned by the caller and traded on flip().
+class cAnimationFrames final
+{
+public:
+    using ImageFactory = std::function<std::unique_ptr<cQuadImage>()>;
+
+    explicit cAnimationFrames(ImageFactory factory);
+    ~cAnimationFrames();
+
+    // Slots that fit into budget bytes, or 0 if the animation should take
+    // the frame-by-frame path.
+    static uint32_t calculateDepth(uint32_t width, uint32_t height, uint32_t bpp, uint32_t images, size_t budget);
+
+    void start(uint32_t depth, uint32_t images, uint32_t frame, uint32_t delay);
+    void stop();
+    bool isActive() const
+    {
+        return m_depth != 0;
+    }
+
+    // Uploads the frames the loader has ready into free slots. Returns
+    // false if a frame couldn't be applied, the ring is unusable then.
+    bool update(cImageLoader& loader, const sChunkData& canvas);
+    bool isUploading() const;
+    bool isNextReady() const;
+    void flip(std::unique_ptr<cQuadImage>& shown, uint32_t& frame, uint32_t& delay);
+
+    void useFilter(bool filter);
+
+private:
+    bool isResident() const
+    {
+        return m_depth >= m_images;
+    }
+
+private:
+    ImageFactory m_factory;
+
+    struct Slot
+    {
+        std::unique_ptr<cQuadImage> image;
+        uint64_t sequence = 0;
+        uint32_t frame    = 0;
+        uint32_t delay    = 0;
+        bool ready        = false;
+        Buffer pixels; // source of a whole-frame upload in progress
+    };
+    std::vector<Slot> m_slots;
+
+    uint32_t m_depth  = 0;
+    uint32_t m_images = 0;
+    uint64_t m_shown  = 0; // sequence on screen
+    uint64_t m_filled = 0; // last sequence put into a slot
+    bool m_filter     = true;
+};
@@ -0,0 +1,129 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "BitmapCache.h"
+
+#include <cstdlib>
+#include <sys/stat.h>
+
+bool cBitmapCache::Key::operator==(const Key& other) const
+{
+    return fileSize == other.fileSize
+        && mtime == other.mtime
+        && subImage == other.subImage
+        && targetWidth == other.targetWidth
+        && targetHeight == other.targetHeight
+        && path == other.path;
+}
+
+bool cBitmapCache::makeKey(const char* path, Key& key)
+{
+    struct stat st;
+    if (::stat(path, &st) != 0)
+    {
+        return false;
+    }
+
+    auto fullPath = ::realpath(path, nullptr);
+    if (fullPath == nullptr)
+    {
+        return false;
+    }
+
+    key          = {};
+    key.path     = fullPath;
+    key.fileSize = static_cast<uint64_t>(st.st_size);
+    key.mtime    = static_cast<int64_t>(st.st_mtime);
+
+    ::free(fullPath);
+
+    return true;
+}
+
+cBitmapCache::cBitmapCache(size_t budget)
+    : m_budget(budget)
+{
+}
+
+const sFormatEntry* cBitmapCache::take(const Key& key, sChunkData& chunk, sImageInfo& info)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = find(key);
+    if (it == m_entries.end())
+    {
+        m_misses++;
+        return nullptr;
+    }
+
+    m_hits++;
+
+    auto format = it->format;
+    chunk.moveFrom(it->chunk);
+    info = std::move(it->info);
+
+    m_bytes -= it->bytes;
+    m_entries.erase(it);
+
+    return format;
+}
+
+void cBitmapCache::put(const Key& key, const sFormatEntry* format, sChunkData& chunk, const sImageInfo& info, bool copy)
+{
+    const size_t bytes = chunk.bitmap.size() + chunk.lutData.size() + chunk.palette.size();
+    if (m_budget == 0 || bytes == 0 || bytes > m_budget)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = find(key);
+    if (it != m_entries.end())
+    {
+        m_bytes -= it->bytes;
+        m_entries.erase(it);
+    }
+
+    while (m_entries.empty() == false && m_bytes + bytes > m_budget)
+    {
+        m_bytes -= m_entries.back().bytes;
+        m_entries.pop_back();
+    }
+
+    m_entries.emplace_front();
+    auto& entry  = m_entries.front();
+    entry.key    = key;
+    entry.format = format;
+    entry.info   = info;
+    entry.bytes  = bytes;
+    if (copy)
+    {
+        entry.chunk.copyFrom(chunk);
+    }
+    else
+    {
+        entry.chunk.moveFrom(chunk);
+    }
+
+    m_bytes += bytes;
+}
+
+std::list<cBitmapCache::Entry>::iterator cBitmapCache::find(const Key& key)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        if (it->key == key)
+        {
+            return it;
+        }
+    }
+
+    return m_entries.end();
+}
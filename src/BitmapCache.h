@@ -0,0 +1,81 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include "Common/ChunkData.h"
+#include "Common/ImageInfo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+
+struct sFormatEntry;
+
+// LRU cache of decoded bitmaps with a byte budget.
+class cBitmapCache final
+{
+public:
+    struct Key
+    {
+        std::string path; // realpath
+        uint64_t fileSize     = 0;
+        int64_t mtime         = 0;
+        uint32_t subImage     = 0;
+        uint32_t targetWidth  = 0; // re-rasterization size, 0 = native
+        uint32_t targetHeight = 0;
+
+        bool operator==(const Key& other) const;
+    };
+
+    // Fills path, size and mtime of a local file.
+    static bool makeKey(const char* path, Key& key);
+
+    explicit cBitmapCache(size_t budget);
+
+    // Move a bitmap out of the cache. Returns the format it was decoded
+    // with, or nullptr on miss.
+    const sFormatEntry* take(const Key& key, sChunkData& chunk, sImageInfo& info);
+
+    // Store a complete bitmap, moving the pixels out of chunk unless copy is set.
+    void put(const Key& key, const sFormatEntry* format, sChunkData& chunk, const sImageInfo& info, bool copy);
+
+    size_t getHits() const
+    {
+        return m_hits;
+    }
+
+    size_t getMisses() const
+    {
+        return m_misses;
+    }
+
+private:
+    struct Entry
+    {
+        Key key;
+        const sFormatEntry* format = nullptr;
+        sChunkData chunk;
+        sImageInfo info;
+        size_t bytes = 0;
+    };
+
+    std::list<Entry>::iterator find(const Key& key);
+
+private:
+    const size_t m_budget;
+
+    std::mutex m_mutex;
+    std::list<Entry> m_entries; // most recently used first
+    size_t m_bytes  = 0;
+    size_t m_hits   = 0;
+    size_t m_misses = 0;
+};
@@ -30,4 +30,19 @@ struct sCallbacks
     std::function<void(float progress)> doProgress;
     std::function<void()> endLoading;
     std::function<void(sPreviewData&&)> onPreviewReady;
+    std::function<void()> onFrameDecoded; // animation frame decoded ahead
+
+    // No-op set for decodes nobody watches (prefetch, cache priming).
+    static sCallbacks makeSilent()
+    {
+        sCallbacks callbacks;
+        callbacks.startLoading      = []() {};
+        callbacks.onImageInfo       = [](const sChunkData&, const sImageInfo&) {};
+        callbacks.onBitmapAllocated = [](const sChunkData&) {};
+        callbacks.doProgress        = [](float) {};
+        callbacks.endLoading        = []() {};
+        callbacks.onPreviewReady    = [](sPreviewData&&) {};
+        callbacks.onFrameDecoded    = []() {};
+        return callbacks;
+    }
 };
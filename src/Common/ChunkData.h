@@ -10,8 +10,10 @@
 #pragma once
 
 #include "Bitmap.h"
+#include "CompressedFormat.h"
 #include "Effects.h"
 #include "Helpers.h"
+#include "YCbCr.h"
 
 #include <atomic>
 #include <vector>
@@ -31,9 +33,12 @@ struct sChunkData : sBitmap
         effects = eEffect::None;
 
         isCompressedTexture = false;
+        compressedFormat    = eCompressedFormat::None;
         compressedSize      = 0;
 
         lutData.clear();
+        palette.clear();
+        dirty = {};
 
         readyHeight.store(0, std::memory_order_relaxed);
         consumedHeight.store(0, std::memory_order_relaxed);
@@ -55,10 +60,61 @@ struct sChunkData : sBitmap
         bpp        = bitsPerPixel;
         format     = fmt;
         pitch      = helpers::calculatePitch(w, bitsPerPixel);
-        bandHeight = (bandRows > 0 && bandRows < h) ? bandRows : h;
+        bandHeight = getBandHeight(bandRows);
         resizeBitmap(pitch, bandHeight);
     }
 
+    // Allocate an Indexed8 bitmap with an empty 256-entry palette and the
+    // Palette effect set.
+    void allocateIndexed(uint32_t w, uint32_t h, uint32_t bandRows = 0)
+    {
+        allocate(w, h, 8, ePixelFormat::Indexed8, bandRows);
+        palette.assign(256 * 4, 0);
+        effects |= eEffect::Palette;
+    }
+
+    // Allocate a planar YCbCr bitmap with the row layout of ycbcr::getLayout().
+    // bpp is the nominal one of the subsampled planes.
+    void allocatePlanar(uint32_t w, uint32_t h, ePixelFormat fmt, uint32_t bandRows = 0)
+    {
+        width      = w;
+        height     = h;
+        bpp        = fmt == ePixelFormat::YCbCr420 ? 12 : 16;
+        format     = fmt;
+        pitch      = ycbcr::getLayout(fmt, w).pitch;
+        bandHeight = getBandHeight(bandRows);
+        resizeBitmap(pitch, bandHeight);
+    }
+
+    // Band height for the requested ring size, honoring fullBitmap.
+    uint32_t getBandHeight(uint32_t bandRows) const
+    {
+        return (fullBitmap == false && bandRows > 0 && bandRows < height) ? bandRows : height;
+    }
+
+    // Take over decoded pixels and metadata from another chunk (atomics are not movable).
+    void moveFrom(sChunkData& other)
+    {
+        sBitmap::operator=(std::move(other));
+        lutData = std::move(other.lutData);
+        palette = std::move(other.palette);
+        assignState(other);
+    }
+
+    // Deep copy of a complete chunk (sBitmap is move-only).
+    void copyFrom(const sChunkData& other)
+    {
+        bitmap  = other.bitmap;
+        format  = other.format;
+        bpp     = other.bpp;
+        pitch   = other.pitch;
+        width   = other.width;
+        height  = other.height;
+        lutData = other.lutData;
+        palette = other.palette;
+        assignState(other);
+    }
+
     // Get pointer to row in the band buffer (modular for ring access).
     uint8_t* rowPtr(uint32_t row)
     {
@@ -70,18 +126,48 @@ struct sChunkData : sBitmap
         return bitmap.data() + static_cast<size_t>(row % bandHeight) * pitch;
     }
 
+private:
+    void assignState(const sChunkData& other)
+    {
+        bandHeight          = other.bandHeight;
+        effects             = other.effects;
+        isCompressedTexture = other.isCompressedTexture;
+        compressedFormat    = other.compressedFormat;
+        compressedSize      = other.compressedSize;
+        dirty               = other.dirty;
+
+        readyHeight.store(other.readyHeight.load(std::memory_order_acquire), std::memory_order_relaxed);
+        consumedHeight.store(0, std::memory_order_relaxed);
+    }
+
+public:
     // Streaming progress
     std::atomic<uint32_t> readyHeight{ 0 };    // rows decoded so far (decoder → viewer)
     std::atomic<uint32_t> consumedHeight{ 0 }; // rows uploaded to GPU (viewer → decoder)
     uint32_t bandHeight = 0;                   // band buffer height (== height when no banding)
+    bool fullBitmap     = false;               // never band (no consumer, e.g. background prefetch)
 
     // GPU post-processing effects (CMYK conversion, unpremultiply, LUT)
     eEffect effects = eEffect::None;
 
     // GPU-compressed texture (ASTC, ETC2, BC)
-    bool isCompressedTexture = false;
-    uint32_t compressedSize  = 0; // size of compressed texture data in bytes
+    bool isCompressedTexture           = false;
+    eCompressedFormat compressedFormat = eCompressedFormat::None;
+    uint32_t compressedSize            = 0; // size of compressed texture data in bytes
 
     // 3D LUT for GPU ICC color correction (LutGridSize³ × 3 RGB bytes)
     std::vector<uint8_t> lutData;
+
+    // Palette of an ePixelFormat::Indexed8 bitmap (256 × 4 RGBA bytes)
+    std::vector<uint8_t> palette;
+
+    // Canvas area changed by the last composited sub-image (w == 0: all)
+    struct DirtyRect
+    {
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t w = 0;
+        uint32_t h = 0;
+    };
+    DirtyRect dirty;
 };
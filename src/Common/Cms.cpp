@@ -56,6 +56,11 @@ namespace
             case ePixelFormat::RGBA:
             case ePixelFormat::BGR:
             case ePixelFormat::BGRA:
+            case ePixelFormat::RGB16:
+            case ePixelFormat::RGBA16:
+            case ePixelFormat::YCbCr420: // the LUT follows the conversion to RGB
+            case ePixelFormat::YCbCr422:
+            case ePixelFormat::Indexed8: // and the palette lookup
                 break;
             default:
                 cmsCloseProfile(inProfile);
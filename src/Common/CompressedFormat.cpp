@@ -0,0 +1,67 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "CompressedFormat.h"
+
+#include <atomic>
+
+namespace
+{
+    constexpr uint32_t FormatsCount = static_cast<uint32_t>(eCompressedFormat::Count);
+
+    constexpr compressed::sBlockInfo BlockInfos[FormatsCount] = {
+        { 1, 1, 0 },  // None
+        { 4, 4, 8 },  // BC1
+        { 4, 4, 16 }, // BC2
+        { 4, 4, 16 }, // BC3
+        { 4, 4, 8 },  // BC4
+        { 4, 4, 16 }, // BC5
+        { 4, 4, 16 }, // BC7
+        { 4, 4, 8 },  // ETC2_RGB
+        { 4, 4, 16 }, // ETC2_RGBA
+        { 4, 4, 8 },  // ETC2_RGBA1
+        { 4, 4, 8 },  // EAC_R11
+        { 4, 4, 16 }, // EAC_RG11
+        { 4, 4, 16 }, // ASTC_4x4
+        { 6, 6, 16 }, // ASTC_6x6
+        { 8, 8, 16 }, // ASTC_8x8
+    };
+
+    // Written once on the main thread, read by decoder threads.
+    std::atomic<bool> Supported[FormatsCount];
+
+} // namespace
+
+namespace compressed
+{
+    const sBlockInfo& getBlockInfo(eCompressedFormat format)
+    {
+        return BlockInfos[static_cast<uint32_t>(format)];
+    }
+
+    size_t getDataSize(eCompressedFormat format, uint32_t width, uint32_t height)
+    {
+        const auto& block    = getBlockInfo(format);
+        const size_t blocksW = (width + block.width - 1) / block.width;
+        const size_t blocksH = (height + block.height - 1) / block.height;
+        return blocksW * blocksH * block.bytes;
+    }
+
+    void setSupported(eCompressedFormat format, bool supported)
+    {
+        Supported[static_cast<uint32_t>(format)].store(supported, std::memory_order_relaxed);
+    }
+
+    bool isSupported(eCompressedFormat format)
+    {
+        return format != eCompressedFormat::None
+            && Supported[static_cast<uint32_t>(format)].load(std::memory_order_relaxed);
+    }
+
+} // namespace compressed
@@ -0,0 +1,54 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// GPU block-compressed formats. Readers keep such data as is when the GL
+// context can sample it and decode it to RGBA on the CPU otherwise.
+enum class eCompressedFormat : uint32_t
+{
+    None,
+    BC1,
+    BC2,
+    BC3,
+    BC4,
+    BC5,
+    BC7,
+    ETC2_RGB,
+    ETC2_RGBA,
+    ETC2_RGBA1,
+    EAC_R11,
+    EAC_RG11,
+    ASTC_4x4,
+    ASTC_6x6,
+    ASTC_8x8,
+
+    Count
+};
+
+namespace compressed
+{
+    struct sBlockInfo
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t bytes;
+    };
+
+    const sBlockInfo& getBlockInfo(eCompressedFormat format);
+    size_t getDataSize(eCompressedFormat format, uint32_t width, uint32_t height);
+
+    // Filled by the renderer from the GL context capabilities at init.
+    void setSupported(eCompressedFormat format, bool supported);
+    bool isSupported(eCompressedFormat format);
+
+} // namespace compressed
@@ -212,6 +212,17 @@ void cConfig::read(sConfig& config) const
 
     readValue(m_ini, CommonSection, "minSvgSize", config.minSvgSize);
 
+    readValue(m_ini, CommonSection, "prefetch_ahead", config.prefetchAhead);
+    readValue(m_ini, CommonSection, "prefetch_behind", config.prefetchBehind);
+    readValue(m_ini, CommonSection, "prefetch_memory_mb", config.prefetchMemoryMb);
+    readValue(m_ini, CommonSection, "bitmap_cache_mb", config.bitmapCacheMb);
+    readValue(m_ini, CommonSection, "preview_cache_mb", config.previewCacheMb);
+    readValue(m_ini, CommonSection, "worker_threads", config.workerThreads);
+    readValue(m_ini, CommonSection, "upload_budget_ms", config.uploadBudgetMs);
+    readValue(m_ini, CommonSection, "upload_budget_mb", config.uploadBudgetMb);
+    readValue(m_ini, CommonSection, "gpu_memory_mb", config.gpuMemoryMb);
+    readValue(m_ini, CommonSection, "animation_memory_mb", config.animationMemoryMb);
+
     readValue(m_ini, PositionSection, "window_x", config.windowPos.x);
     readValue(m_ini, PositionSection, "window_y", config.windowPos.y);
 
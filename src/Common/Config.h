@@ -53,6 +53,17 @@ struct sConfig
 
     float minSvgSize = 256.0f;
 
+    uint32_t prefetchAhead = 2;       // files decoded ahead in navigation direction
+    uint32_t prefetchBehind = 1;      // files decoded behind
+    uint32_t prefetchMemoryMb = 512;  // prefetch cache ceiling, 0 = disabled
+    uint32_t bitmapCacheMb = 256;     // decoded bitmap LRU ceiling, 0 = disabled
+    uint32_t previewCacheMb = 64;     // on-disk preview cache ceiling, 0 = disabled
+    uint32_t workerThreads = 0;       // shared decode pool size, 0 = hardware concurrency
+    uint32_t uploadBudgetMs = 8;      // texture upload time per frame, 0 = unlimited
+    uint32_t uploadBudgetMb = 64;     // texture upload volume per frame, 0 = unlimited
+    uint32_t gpuMemoryMb = 1024;      // image tile texture ceiling, 0 = unlimited
+    uint32_t animationMemoryMb = 256; // texture ceiling for animation frames, 0 = no frame cache
+
     Vectori windowSize{ 0, 0 };
     Vectori windowPos{ 0, 0 };
 
@@ -13,13 +13,17 @@
 
 // GPU post-processing effect flags.
 // Set by format readers in sChunkData::effects, forwarded to the renderer.
-// Ordered by shader application: CMYK→RGB, then unpremultiply, then LUT.
+// Ordered by shader application: YCbCr→RGB or palette lookup, CMYK→RGB,
+// then unpremultiply, then tone mapping, then LUT.
 enum class eEffect : uint32_t
 {
     None          = 0,
     Cmyk          = 1 << 0, // Convert CMYK to RGB
     Unpremultiply = 1 << 1, // Unpremultiply alpha
     Lut           = 1 << 2, // Apply ICC 3D LUT color correction
+    ToneMap       = 1 << 3, // Expose and tone map scene-linear HDR to sRGB
+    YCbCr         = 1 << 4, // Convert planar YCbCr to RGB
+    Palette       = 1 << 5, // Look indices up in the palette
 };
 
 inline eEffect operator|(eEffect a, eEffect b)
@@ -10,10 +10,13 @@
 #include "Helpers.h"
 
 #include <GLFW/glfw3.h>
+#include <cerrno>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <string>
+#include <sys/stat.h>
 
 namespace helpers
 {
@@ -247,4 +250,45 @@ namespace helpers
         return ".";
     }
 
+    std::string getCacheDirectory(const char* name)
+    {
+        std::string path;
+
+        auto xdgCacheHome = ::getenv("XDG_CACHE_HOME");
+        if (xdgCacheHome != nullptr && xdgCacheHome[0] != '\0')
+        {
+            path = xdgCacheHome;
+        }
+        else
+        {
+            auto home = ::getenv("HOME");
+            if (home == nullptr)
+            {
+                return {};
+            }
+            path = home;
+            path += "/.cache";
+        }
+
+        path += "/sviewgl/";
+        path += name;
+
+        // Create every missing component.
+        for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1))
+        {
+            const auto dir = path.substr(0, pos);
+            if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+            {
+                return {};
+            }
+
+            if (pos == std::string::npos)
+            {
+                break;
+            }
+        }
+
+        return path;
+    }
+
 } // namespace helpers
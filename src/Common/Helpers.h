@@ -47,4 +47,8 @@ namespace helpers
 
     std::string getDirectoryFromPath(const char* path);
 
+    // Per-user cache directory ($XDG_CACHE_HOME/sviewgl/<name>), created on
+    // demand. Returns an empty string if it can't be created.
+    std::string getCacheDirectory(const char* name);
+
 } // namespace helpers
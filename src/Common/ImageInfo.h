@@ -24,8 +24,30 @@ struct sImageInfo
 
     bool isAnimation = false;
     bool isVector = false; // vector format that supports re-rasterization at different sizes
+    uint32_t fullWidth = 0;  // natural size of a raster decoded scaled down, 0 if at full size
+    uint32_t fullHeight = 0;
     uint32_t delay = 0; // frame animation delay
 
+    struct Level
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+    std::vector<Level> levels; // resolutions of a pyramidal image, finest first
+
+    // Part of a pyramid level read for the view, in level pixels. Empty
+    // when the raster is a whole image.
+    struct Window
+    {
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levelWidth = 0;
+        uint32_t levelHeight = 0;
+    };
+    Window window;
+
     enum class ExifCategory : uint8_t
     {
         Camera,
@@ -23,4 +23,10 @@ enum class ePixelFormat : uint32_t
     RGB565,
     RGBA5551,
     RGBA4444,
+    RGB16,    // 16-bit unsigned per channel, native byte order
+    RGBA16,   // 16-bit unsigned per channel, native byte order
+    RGBA16F,  // half float per channel, scene-linear
+    YCbCr420, // planar 8-bit YCbCr, chroma halved both ways, see YCbCr.h
+    YCbCr422, // planar 8-bit YCbCr, chroma halved horizontally
+    Indexed8, // 8-bit palette indices, see sChunkData::palette
 };
@@ -0,0 +1,36 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include <atomic>
+
+// Cancellation flag owned by whoever runs a job (loader, prefetcher) and
+// polled by the decoder and any pool tasks it spawned.
+class cStopToken final
+{
+public:
+    void reset()
+    {
+        m_stop.store(false, std::memory_order_relaxed);
+    }
+
+    void request()
+    {
+        m_stop.store(true, std::memory_order_release);
+    }
+
+    bool isRequested() const
+    {
+        return m_stop.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<bool> m_stop{ false };
+};
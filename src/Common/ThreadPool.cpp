@@ -0,0 +1,256 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+    std::atomic<uint32_t> ConfiguredThreads{ 0 };
+
+    thread_local cThreadPool* CurrentPool = nullptr;
+    thread_local uint32_t CurrentWorker   = 0;
+
+    struct sParallelState
+    {
+        std::atomic<uint32_t> next;
+        uint32_t end;
+        const std::function<void(uint32_t)>* fn;
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        uint32_t completed = 0;
+    };
+
+    // Claims items until the range is exhausted, returns the amount processed.
+    uint32_t runParallel(sParallelState& state)
+    {
+        uint32_t processed = 0;
+        for (uint32_t i = state.next++; i < state.end; i = state.next++)
+        {
+            (*state.fn)(i);
+            processed++;
+        }
+        return processed;
+    }
+
+} // namespace
+
+cTaskGroup::~cTaskGroup()
+{
+    wait();
+}
+
+bool cTaskGroup::isBusy() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending != 0;
+}
+
+void cTaskGroup::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] {
+        return m_pending == 0;
+    });
+}
+
+void cTaskGroup::add()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending++;
+}
+
+void cTaskGroup::done()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_pending == 0)
+    {
+        m_idle.notify_all();
+    }
+}
+
+void cThreadPool::configure(uint32_t threads)
+{
+    ConfiguredThreads = threads;
+}
+
+cThreadPool& cThreadPool::shared()
+{
+    static cThreadPool pool(ConfiguredThreads);
+    return pool;
+}
+
+cThreadPool::cThreadPool(uint32_t threads)
+{
+    if (threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    // Keep at least one worker free for a decoder while the loader job runs.
+    threads = std::max(threads, 2u);
+
+    m_workers.reserve(threads);
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        m_workers[i]->thread = std::thread(&cThreadPool::run, this, i);
+    }
+}
+
+cThreadPool::~cThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wakeup.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker->thread.join();
+    }
+}
+
+void cThreadPool::submit(cTaskGroup& group, Task task)
+{
+    group.add();
+    push([&group, task = std::move(task)] {
+        task();
+        group.done();
+    });
+}
+
+void cThreadPool::parallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& fn)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    const uint32_t count = end - begin;
+    if (count == 1)
+    {
+        fn(begin);
+        return;
+    }
+
+    auto state  = std::make_shared<sParallelState>();
+    state->next = begin;
+    state->end  = end;
+    state->fn   = &fn;
+
+    // Helpers that start after the range is drained return without touching fn.
+    const uint32_t helpers = std::min(count - 1, getThreadsCount());
+    for (uint32_t i = 0; i < helpers; i++)
+    {
+        push([state] {
+            const uint32_t processed = runParallel(*state);
+            if (processed != 0)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->completed += processed;
+                state->finished.notify_one();
+            }
+        });
+    }
+
+    const uint32_t processed = runParallel(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->completed += processed;
+    state->finished.wait(lock, [&state, count] {
+        return state->completed == count;
+    });
+}
+
+void cThreadPool::push(Task task)
+{
+    // Tasks spawned by a worker stay on its own deque (cache-warm, LIFO),
+    // external submissions are spread round-robin.
+    const uint32_t index = CurrentPool == this
+        ? CurrentWorker
+        : m_next++ % getThreadsCount();
+
+    // Counted before it is visible, a worker popping it right away must
+    // not take the count below zero.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+    m_wakeup.notify_one();
+}
+
+bool cThreadPool::pop(uint32_t index, Task& task)
+{
+    {
+        auto& own = *m_workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.tasks.empty() == false)
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+
+    const auto count = getThreadsCount();
+    for (uint32_t i = 1; i < count; i++)
+    {
+        auto& victim = *m_workers[(index + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty() == false)
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void cThreadPool::run(uint32_t index)
+{
+    CurrentPool   = this;
+    CurrentWorker = index;
+
+    Task task;
+    while (true)
+    {
+        if (pop(index, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeup.wait(lock, [this] {
+            return m_quit || m_queued != 0;
+        });
+
+        // Drain pending work before leaving, task groups may wait on it.
+        if (m_quit && m_queued == 0)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks a set of submitted tasks so their owner can wait for them.
+class cTaskGroup final
+{
+public:
+    ~cTaskGroup();
+
+    bool isBusy() const;
+    void wait();
+
+private:
+    friend class cThreadPool;
+
+    void add();
+    void done();
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_idle;
+    uint32_t m_pending = 0;
+};
+
+// Work-stealing executor shared by the loader, the prefetcher and the
+// format readers. Every worker owns a deque: it pops its own tasks LIFO and
+// steals from the others FIFO when it runs dry.
+class cThreadPool final
+{
+public:
+    using Task = std::function<void()>;
+
+    // Size of the shared pool, 0 = hardware concurrency. Must be called
+    // before the first shared() call to take effect.
+    static void configure(uint32_t threads);
+    static cThreadPool& shared();
+
+    explicit cThreadPool(uint32_t threads);
+    ~cThreadPool();
+
+    uint32_t getThreadsCount() const
+    {
+        return static_cast<uint32_t>(m_workers.size());
+    }
+
+    void submit(cTaskGroup& group, Task task);
+
+    // Runs fn(i) for every i in [begin, end). The calling thread takes part
+    // and only processes items of this call, so it is safe to use from
+    // pool tasks and never picks up unrelated long-running work.
+    void parallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)>& fn);
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void push(Task task);
+    bool pop(uint32_t index, Task& task);
+    void run(uint32_t index);
+
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::atomic<uint32_t> m_queued{ 0 };
+    std::atomic<uint32_t> m_next{ 0 };
+    bool m_quit = false;
+};
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <chrono>
+#include <ctime>
 
 namespace timing
 {
@@ -20,4 +21,10 @@ namespace timing
         return std::chrono::duration<double>(now - Start).count();
     }
 
+    // CPU time used by the process, all threads included.
+    inline double cpuSeconds()
+    {
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+    }
+
 } // namespace timing
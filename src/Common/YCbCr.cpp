@@ -0,0 +1,71 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "YCbCr.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t BlockSize = 8;
+
+    uint32_t alignToBlock(uint32_t size)
+    {
+        return (size + BlockSize - 1) / BlockSize * BlockSize;
+    }
+
+} // namespace
+
+namespace ycbcr
+{
+    bool isPlanar(ePixelFormat format)
+    {
+        return format == ePixelFormat::YCbCr420 || format == ePixelFormat::YCbCr422;
+    }
+
+    sLayout getLayout(ePixelFormat format, uint32_t width)
+    {
+        sLayout layout;
+        layout.factorX = isPlanar(format) ? 2 : 1;
+        layout.factorY = format == ePixelFormat::YCbCr420 ? 2 : 1;
+
+        const uint32_t chromaStride = alignToBlock(getChromaSize(width, layout.factorX));
+
+        layout.cbOffset = alignToBlock(width);
+        layout.crOffset = layout.cbOffset + chromaStride;
+        layout.pitch    = layout.crOffset + chromaStride;
+
+        return layout;
+    }
+
+    uint32_t getChromaSize(uint32_t size, uint32_t factor)
+    {
+        return (size + factor - 1) / factor;
+    }
+
+    void toRgb(float y, float cb, float cr, float* rgb)
+    {
+        cb -= 128.0f / 255.0f;
+        cr -= 128.0f / 255.0f;
+        rgb[0] = std::clamp(y + 1.402f * cr, 0.0f, 1.0f);
+        rgb[1] = std::clamp(y - 0.344136f * cb - 0.714136f * cr, 0.0f, 1.0f);
+        rgb[2] = std::clamp(y + 1.772f * cb, 0.0f, 1.0f);
+    }
+
+    void toRgb(uint8_t y, uint8_t cb, uint8_t cr, uint8_t* rgb)
+    {
+        float out[3];
+        toRgb(y / 255.0f, cb / 255.0f, cr / 255.0f, out);
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            rgb[i] = static_cast<uint8_t>(out[i] * 255.0f + 0.5f);
+        }
+    }
+
+} // namespace ycbcr
@@ -0,0 +1,41 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include "PixelFormat.h"
+
+#include <cstdint>
+
+// Planar YCbCr as raw JPEG decoding produces it. A band buffer row holds
+// the luma row followed by a Cb and a Cr row, the chroma part being filled
+// only on rows that start a chroma row (every second one for 4:2:0).
+// Planes are padded to whole 8-sample blocks, the width libjpeg writes.
+namespace ycbcr
+{
+    struct sLayout
+    {
+        uint32_t factorX  = 1; // chroma subsampling
+        uint32_t factorY  = 1;
+        uint32_t cbOffset = 0; // bytes into the row
+        uint32_t crOffset = 0;
+        uint32_t pitch    = 0;
+    };
+
+    bool isPlanar(ePixelFormat format);
+    sLayout getLayout(ePixelFormat format, uint32_t width);
+
+    // Chroma samples covering size luma samples.
+    uint32_t getChromaSize(uint32_t size, uint32_t factor);
+
+    // JFIF full-range BT.601, the conversion the shader does.
+    void toRgb(float y, float cb, float cr, float* rgb);
+    void toRgb(uint8_t y, uint8_t cb, uint8_t cr, uint8_t* rgb);
+
+} // namespace ycbcr
@@ -333,6 +333,18 @@ const char* cFilesList::getName(int delta)
     return nullptr;
 }
 
+const char* cFilesList::peekName(int delta) const
+{
+    const auto count = m_files.size();
+    if (count > 0)
+    {
+        const auto position = (m_position + count + delta % static_cast<int>(count)) % count;
+        return m_files[position].path.c_str();
+    }
+
+    return nullptr;
+}
+
 const char* cFilesList::getFirstName()
 {
     parseDir();
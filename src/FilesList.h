@@ -24,6 +24,7 @@ public:
     const char* getName(int delta = 0);
     const char* getFirstName();
     const char* getLastName();
+    const char* peekName(int delta) const; // like getName() but keeps the position
 
     void toggleDeletionMark();
     bool isMarkedForDeletion() const;
@@ -14,6 +14,7 @@
 #include "Common/File.h"
 #include "Common/ImageInfo.h"
 #include "Common/Timing.h"
+#include "Libs/GpuDecode.h"
 #include "Log/Log.h"
 
 #include <cassert>
@@ -32,17 +33,35 @@ void cFormat::setConfig(const sConfig* config)
     m_config = config;
 }
 
+void cFormat::setCallbacks(sCallbacks* callbacks)
+{
+    m_callbacks = callbacks;
+}
+
+void cFormat::setStopToken(const cStopToken* token)
+{
+    m_stopToken = token;
+}
+
 bool cFormat::Load(const char* filename, sChunkData& chunk, sImageInfo& info)
 {
-    m_stop     = false;
     m_chunk    = &chunk;
     m_info     = &info;
     m_decodeMs = 0.0;
     m_iccMs    = 0.0;
 
+    m_previewSent = false;
+    if (m_cachedPreview != nullptr)
+    {
+        signalPreviewReady(std::move(*m_cachedPreview));
+        m_cachedPreview.reset();
+        m_previewSent = true;
+    }
+
     const auto t0 = timing::seconds();
     bool result   = LoadImpl(filename, chunk, info);
     m_decodeMs    = (timing::seconds() - t0) * 1000.0 - m_iccMs;
+    m_previewSent = false;
 
     if (result)
     {
@@ -56,7 +75,6 @@ bool cFormat::Load(const char* filename, sChunkData& chunk, sImageInfo& info)
 
 bool cFormat::LoadSubImage(uint32_t subImage, sChunkData& chunk, sImageInfo& info)
 {
-    m_stop     = false;
     m_chunk    = &chunk;
     m_info     = &info;
     m_decodeMs = 0.0;
@@ -90,6 +108,11 @@ void cFormat::dump(const sChunkData& chunk, const sImageInfo& info) const
     cLog::Debug("frame duration: {}", info.delay);
 }
 
+void cFormat::setCachedPreview(sPreviewData&& preview)
+{
+    m_cachedPreview = std::make_unique<sPreviewData>(std::move(preview));
+}
+
 void cFormat::updateProgress(float percent)
 {
     if (m_chunk != nullptr)
@@ -101,6 +124,15 @@ void cFormat::updateProgress(float percent)
     m_callbacks->doProgress(percent);
 }
 
+void cFormat::signalRowsReady(uint32_t rows)
+{
+    if (m_chunk != nullptr && m_chunk->height != 0)
+    {
+        m_chunk->readyHeight.store(rows, std::memory_order_release);
+        m_callbacks->doProgress(static_cast<float>(rows) / m_chunk->height);
+    }
+}
+
 void cFormat::signalImageInfo()
 {
     if (m_callbacks != nullptr && m_callbacks->onImageInfo && m_info != nullptr)
@@ -125,7 +157,7 @@ void cFormat::signalBitmapAllocated()
 
 void cFormat::signalPreviewReady(sPreviewData&& preview)
 {
-    if (m_callbacks != nullptr && m_callbacks->onPreviewReady)
+    if (m_previewSent == false && m_callbacks != nullptr && m_callbacks->onPreviewReady)
     {
         m_callbacks->onPreviewReady(std::move(preview));
     }
@@ -138,6 +170,42 @@ void cFormat::setupBitmap(sChunkData& chunk, sImageInfo& info, uint32_t bpp, ePi
     signalBitmapAllocated();
 }
 
+bool cFormat::setupCompressed(sChunkData& chunk, sImageInfo& info, eCompressedFormat format, const uint8_t* blocks)
+{
+    info.bppImage = 32;
+
+    if (compressed::isSupported(format))
+    {
+        const size_t size = compressed::getDataSize(format, chunk.width, chunk.height);
+
+        chunk.format              = ePixelFormat::RGBA;
+        chunk.bpp                 = 32;
+        chunk.pitch               = 0;
+        chunk.bandHeight          = chunk.height;
+        chunk.isCompressedTexture = true;
+        chunk.compressedFormat    = format;
+        chunk.compressedSize      = static_cast<uint32_t>(size);
+        chunk.bitmap.assign(blocks, blocks + size);
+
+        return true;
+    }
+
+    chunk.allocate(chunk.width, chunk.height, 32, ePixelFormat::RGBA);
+
+    // Strips are decoded in parallel, let the viewer upload them as they land.
+    signalBitmapAllocated();
+
+    gpu_decode::Stream stream;
+    stream.onRowsReady = [this](uint32_t rows) { signalRowsReady(rows); };
+    stream.stop        = &getStopToken();
+    if (gpu_decode::decode(format, blocks, chunk.bitmap.data(), chunk.width, chunk.height, stream) == false)
+    {
+        return false;
+    }
+
+    return isStopped() == false;
+}
+
 bool cFormat::openFile(cFile& file, const char* filename, sImageInfo& info) const
 {
     if (file.open(filename) == false)
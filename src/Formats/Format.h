@@ -10,13 +10,17 @@
 #pragma once
 
 #include "Common/Buffer.h"
+#include "Common/CompressedFormat.h"
+#include "Common/ImageInfo.h"
 #include "Common/PixelFormat.h"
+#include "Common/StopToken.h"
+
+#include <memory>
 
 class cFile;
 struct sCallbacks;
 struct sChunkData;
 struct sConfig;
-struct sImageInfo;
 struct sPreviewData;
 
 class cFormat
@@ -25,30 +29,55 @@ public:
     virtual ~cFormat();
 
     void setConfig(const sConfig* config);
+    void setCallbacks(sCallbacks* callbacks);
+
+    // Token polled by the decoder, owned and reset by whoever runs the load.
+    void setStopToken(const cStopToken* token);
 
     virtual bool isSupported(cFile& file, Buffer& buffer) const = 0;
 
+    // Sub-images are composited over the previous one (e.g. GIF animation),
+    // so decoding sub-image N requires the canvas of N - 1.
+    virtual bool isSubImageSequential() const
+    {
+        return false;
+    }
+
     bool Load(const char* filename, sChunkData& chunk, sImageInfo& info);
     bool LoadSubImage(uint32_t subImage, sChunkData& chunk, sImageInfo& info);
 
     void updateProgress(float percent);
+    // Rows [0, rows) are final: exact readyHeight for streaming upload.
+    void signalRowsReady(uint32_t rows);
     void signalImageInfo();
     void signalBitmapAllocated();
     void signalPreviewReady(sPreviewData&& preview);
 
+    // Preview delivered at the start of the next Load(), replacing any
+    // preview embedded in the file (e.g. from the persistent preview cache).
+    void setCachedPreview(sPreviewData&& preview);
+
     // Centralized bitmap setup: signals image info, allocates bitmap, signals viewer.
     // Caller must set chunk.width, chunk.height, info.bppImage before calling.
     void setupBitmap(sChunkData& chunk, sImageInfo& info, uint32_t bpp, ePixelFormat format, const char* formatName);
 
+    // GPU block-compressed image: the blocks are kept as is when the GL context
+    // samples the format natively, otherwise decoded to RGBA with streamed rows.
+    // Caller must set chunk.width, chunk.height before calling.
+    bool setupCompressed(sChunkData& chunk, sImageInfo& info, eCompressedFormat format, const uint8_t* blocks);
+
     void setTargetSize(uint32_t width, uint32_t height)
     {
         m_targetWidth = width;
         m_targetHeight = height;
+        m_targetWindow = {};
     }
 
-    virtual void stop()
+    // Part of the level the target size picks, readers of tiled pyramids
+    // decode only that. Cleared by setTargetSize().
+    void setTargetWindow(const sImageInfo::Window& window)
     {
-        m_stop = true;
+        m_targetWindow = window;
     }
 
     virtual void dump(const sChunkData& chunk, const sImageInfo& info) const;
@@ -59,6 +88,22 @@ public:
     cFormat(sCallbacks* callbacks);
 
 protected:
+    bool isStopped() const
+    {
+        return m_stopToken->isRequested();
+    }
+
+    const cStopToken& getStopToken() const
+    {
+        return *m_stopToken;
+    }
+
+    // A cached preview was shown for this load, decoding another is wasted.
+    bool isPreviewSent() const
+    {
+        return m_previewSent;
+    }
+
     bool openFile(cFile& file, const char* filename, sImageInfo& info) const;
     bool readBuffer(cFile& file, Buffer& buffer, uint32_t minSize) const;
     bool applyIccProfile(sChunkData& chunk, const void* iccProfile, uint32_t iccProfileSize);
@@ -76,10 +121,14 @@ private:
     sImageInfo* m_info = nullptr;
     double m_decodeMs = 0.0;
     double m_iccMs = 0.0;
+    std::unique_ptr<sPreviewData> m_cachedPreview;
+    bool m_previewSent = false;
+    cStopToken m_ownStopToken; // never requested, used until a token is set
+    const cStopToken* m_stopToken = &m_ownStopToken;
 
 protected:
     const sConfig* m_config = nullptr;
-    bool m_stop = false;
     uint32_t m_targetWidth = 0;
     uint32_t m_targetHeight = 0;
+    sImageInfo::Window m_targetWindow;
 };
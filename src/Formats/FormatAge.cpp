@@ -13,7 +13,6 @@
 #include "Common/ImageInfo.h"
 #include "Common/ZlibDecoder.h"
 #include "Libs/AGEheader.h"
-#include "Libs/GpuDecode.h"
 #include "Libs/Rle.h"
 #include "Log/Log.h"
 
@@ -32,65 +31,28 @@ namespace
         return AGE::isValidHeader(header);
     }
 
-    struct CompressedFormatInfo
-    {
-        unsigned blockW;
-        unsigned blockH;
-        unsigned blockBytes;
-    };
-
-    const CompressedFormatInfo* getCompressedFormatInfo(AGE::Format format)
-    {
-        static const CompressedFormatInfo Formats[] = {
-            { 4, 4, 16 }, // ASTC_4x4
-            { 6, 6, 16 }, // ASTC_6x6
-            { 8, 8, 16 }, // ASTC_8x8
-            { 4, 4, 8 },  // ETC2_RGB
-            { 4, 4, 16 }, // ETC2_RGBA
-            { 4, 4, 8 },  // BC1
-            { 4, 4, 16 }, // BC3
-            { 4, 4, 16 }, // BC7
-        };
-
-        if (!AGE::isCompressedFormat(format))
-        {
-            return nullptr;
-        }
-
-        auto idx = static_cast<unsigned>(format) - static_cast<unsigned>(AGE::Format::LAST_UNCOMPRESSED) - 1;
-        return &Formats[idx];
-    }
-
-    bool decodeCompressedToRGBA(AGE::Format format, const uint8_t* src, uint8_t* dst, unsigned w, unsigned h)
+    eCompressedFormat toCompressedFormat(AGE::Format format)
     {
         switch (format)
         {
         case AGE::Format::BC1:
-            gpu_decode::decodeBC1(src, dst, w, h);
-            return true;
+            return eCompressedFormat::BC1;
         case AGE::Format::BC3:
-            gpu_decode::decodeBC3(src, dst, w, h);
-            return true;
+            return eCompressedFormat::BC3;
         case AGE::Format::BC7:
-            gpu_decode::decodeBC7(src, dst, w, h);
-            return true;
+            return eCompressedFormat::BC7;
         case AGE::Format::ETC2_RGB:
-            gpu_decode::decodeETC2_RGB(src, dst, w, h);
-            return true;
+            return eCompressedFormat::ETC2_RGB;
         case AGE::Format::ETC2_RGBA:
-            gpu_decode::decodeETC2_RGBA(src, dst, w, h);
-            return true;
+            return eCompressedFormat::ETC2_RGBA;
         case AGE::Format::ASTC_4x4:
-            gpu_decode::decodeASTC(src, dst, w, h, 4, 4);
-            return true;
+            return eCompressedFormat::ASTC_4x4;
         case AGE::Format::ASTC_6x6:
-            gpu_decode::decodeASTC(src, dst, w, h, 6, 6);
-            return true;
+            return eCompressedFormat::ASTC_6x6;
         case AGE::Format::ASTC_8x8:
-            gpu_decode::decodeASTC(src, dst, w, h, 8, 8);
-            return true;
+            return eCompressedFormat::ASTC_8x8;
         default:
-            return false;
+            return eCompressedFormat::None;
         }
     }
 
@@ -140,16 +102,13 @@ bool cFormatAge::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
         }
     }
 
-    const bool isCompressed = AGE::isCompressedFormat(format);
-    unsigned compressedDataSize = 0;
+    info.formatName = AGE::FormatToStr(format);
 
-    if (isCompressed)
-    {
-        auto fmtInfo = getCompressedFormatInfo(format);
-        auto blocksW = (header.w + fmtInfo->blockW - 1) / fmtInfo->blockW;
-        auto blocksH = (header.h + fmtInfo->blockH - 1) / fmtInfo->blockH;
-        compressedDataSize = blocksW * blocksH * fmtInfo->blockBytes;
-    }
+    const auto compressedFormat = toCompressedFormat(format);
+    const bool isCompressed = compressedFormat != eCompressedFormat::None;
+    const unsigned compressedDataSize = isCompressed
+        ? static_cast<unsigned>(compressed::getDataSize(compressedFormat, header.w, header.h))
+        : 0;
 
     unsigned bytespp = 0;
     switch (format)
@@ -184,7 +143,7 @@ bool cFormatAge::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
             cLog::Error("Unknown AGE format.");
             return false;
         }
-        // compressed formats will be decoded to RGBA
+        // compressed formats are set up by setupCompressed()
         bytespp = 4;
         chunk.format = ePixelFormat::RGBA;
         break;
@@ -194,7 +153,7 @@ bool cFormatAge::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
     chunk.height = header.h;
 
     // For compressed: first decompress AGE compression into a temp buffer,
-    // then software-decode GPU blocks to RGBA.
+    // then pass the GPU blocks through or software-decode them to RGBA.
     if (isCompressed)
     {
         std::vector<uint8_t> compressedBuf(compressedDataSize);
@@ -248,12 +207,8 @@ bool cFormatAge::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
 
         updateProgress(0.6f);
 
-        info.bppImage = bytespp * 8;
-        chunk.allocate(chunk.width, chunk.height, bytespp * 8, chunk.format);
-
-        if (!decodeCompressedToRGBA(format, compressedBuf.data(), chunk.bitmap.data(), chunk.width, chunk.height))
+        if (!setupCompressed(chunk, info, compressedFormat, compressedBuf.data()))
         {
-            cLog::Error("Failed to decode compressed AGE texture.");
             return false;
         }
 
@@ -330,7 +285,5 @@ bool cFormatAge::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
         }
     }
 
-    info.formatName = AGE::FormatToStr(format);
-
     return true;
 }
@@ -14,6 +14,7 @@
 #include "Common/ImageInfo.h"
 #include "Log/Log.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iterator>
 
@@ -281,13 +282,9 @@ namespace
         switch (bitCount)
         {
         case 1:
-            chunk.format = ePixelFormat::BGRA; // GL_LUMINANCE;
-            chunk.bpp = 32;                    // 8;
-            break;
-
         case 8:
-            chunk.format = ePixelFormat::BGRA; // GL_BGR;
-            chunk.bpp = 32;                    // 24;
+            chunk.format = ePixelFormat::Indexed8;
+            chunk.bpp = 8;
             break;
 
         case 16:
@@ -306,38 +303,30 @@ namespace
         }
     }
 
-    struct RGBA
+    // BMP palette entries are B, G, R, reserved.
+    void setPalette(sChunkData& chunk, const Buffer& pal)
     {
-        uint8_t r, g, b, a;
+        chunk.palette.assign(256 * 4, 0);
 
-        uint32_t toRGBA() const
+        const size_t colors = std::min<size_t>(pal.size() / 4, 256);
+        for (size_t i = 0; i < colors; i++)
         {
-            return ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+            auto entry = &chunk.palette[i * 4];
+            entry[0]   = pal[i * 4 + 2];
+            entry[1]   = pal[i * 4 + 1];
+            entry[2]   = pal[i * 4 + 0];
+            entry[3]   = 255;
         }
 
-        uint32_t toBGRA() const
-        {
-            return ((uint32_t)a << 24) | ((uint32_t)b << 16) | ((uint32_t)g << 8) | (uint32_t)r;
-        }
-
-        uint32_t toRGB() const
-        {
-            return ((uint32_t)255 << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
-        }
-
-        uint32_t toBGR() const
-        {
-            return ((uint32_t)255 << 24) | ((uint32_t)b << 16) | ((uint32_t)g << 8) | (uint32_t)r;
-        }
-    };
+        chunk.effects |= eEffect::Palette;
+    }
 
-    bool readUncompressed1(cFile& file, sChunkData& chunk, const BITMAPCOMMON& header, const Buffer& pal)
+    bool readUncompressed1(cFile& file, sChunkData& chunk, const BITMAPCOMMON& header)
     {
         const uint32_t inPitch = header.sizeImage / chunk.height;
         Buffer buffer(inPitch);
 
         auto in = buffer.data();
-        auto palette = (RGBA*)pal.data();
 
         for (uint32_t row = 0; row < chunk.height; row++)
         {
@@ -346,16 +335,14 @@ namespace
                 return false;
             }
 
-            auto out = (uint32_t*)(chunk.bitmap.data() + (chunk.height - row - 1) * chunk.pitch);
+            auto out = chunk.bitmap.data() + (chunk.height - row - 1) * chunk.pitch;
             size_t idx = 0;
             for (uint32_t i = 0; i < inPitch; i++)
             {
                 auto byte = in[i];
                 for (uint32_t b = 0; b < 8 && idx < chunk.width; b++, idx++)
                 {
-                    const uint32_t val = byte & 0x80;
-                    auto color = palette[val ? 1 : 0];
-                    out[idx] = color.toBGR();
+                    out[idx] = (byte & 0x80) ? 1 : 0;
 
                     byte <<= 1;
                 }
@@ -365,32 +352,30 @@ namespace
         return true;
     }
 
-    bool readRLE8(cFile& file, sChunkData& chunk, const BITMAPCOMMON& header, const Buffer& pal, bool isRle8)
+    bool readRLE8(cFile& file, sChunkData& chunk, const BITMAPCOMMON& header, bool isRle8)
     {
         (void)header;
 
         cCachedReader reader(file, 5);
 
-        auto palette = (const RGBA*)pal.data();
-
         size_t ofs = 0;
-        const auto pitch = chunk.width;
-        const auto start = (uint32_t*)chunk.bitmap.data();
+        const auto pitch = chunk.pitch;
+        const auto start = chunk.bitmap.data();
         const auto end = start + (chunk.height * pitch);
         auto bits = end - pitch;
 
-#define COPY_PIXEL(x)                     \
-    do                                    \
-    {                                     \
-        auto spot = &bits[ofs++];         \
-        if (spot >= start && spot < end)  \
-        {                                 \
-            *spot = (palette[x].toBGR()); \
-        }                                 \
-        else                              \
-        {                                 \
-            cLog::Warning("Out of bitmap bounds.");  \
-        }                                 \
+#define COPY_PIXEL(x)                                   \
+    do                                                  \
+    {                                                   \
+        auto spot = &bits[ofs++];                       \
+        if (spot >= start && spot < end)                \
+        {                                               \
+            *spot = static_cast<uint8_t>(x);            \
+        }                                               \
+        else                                            \
+        {                                               \
+            cLog::Warning("Out of bitmap bounds.");     \
+        }                                               \
     } while (0)
 
         while (true)
@@ -529,13 +514,12 @@ namespace
         return false;
     }
 
-    bool readUncompressed8(cFile& file, sChunkData& chunk, const BITMAPCOMMON& header, const Buffer& pal)
+    bool readUncompressed8(cFile& file, sChunkData& chunk, const BITMAPCOMMON& header)
     {
         const uint32_t inPitch = header.sizeImage / chunk.height;
         Buffer buffer(inPitch);
 
         auto in = buffer.data();
-        auto palette = (RGBA*)pal.data();
 
         for (uint32_t row = 0; row < chunk.height; row++)
         {
@@ -544,14 +528,9 @@ namespace
                 return false;
             }
 
-            auto out = (uint32_t*)(chunk.bitmap.data() + (chunk.height - row - 1) * chunk.pitch);
-            size_t idx = 0;
-            for (uint32_t i = 0; i < inPitch; i++)
-            {
-                const auto byte = in[i];
-                auto color = palette[byte];
-                out[idx++] = color.toBGR();
-            }
+            // Rows are padded to 4 bytes, the indices are copied as is.
+            auto out = chunk.bitmap.data() + (chunk.height - row - 1) * chunk.pitch;
+            ::memcpy(out, in, std::min(inPitch, chunk.width));
         }
 
         return true;
@@ -666,8 +645,6 @@ bool cFormatBmp::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
 
         setGLformat(header.bitCount, chunk, info);
 
-        setupBitmap(chunk, info, chunk.bpp, chunk.format, "bmp");
-
         const uint32_t fileOffset = file.getOffset();
         cLog::Debug("  File offset      : {}", fileOffset);
         cLog::Debug("  Bitmap offset    : {}", bmpHeader.bitmapOffset);
@@ -678,6 +655,14 @@ bool cFormatBmp::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
         cLog::Debug("  Colors important : {}", header.clrImportant);
         cLog::Debug("  Colors used      : {}", header.clrUsed);
 
+        // The viewer picks the palette up with the allocated bitmap.
+        if (chunk.format == ePixelFormat::Indexed8)
+        {
+            setPalette(chunk, palette);
+        }
+
+        setupBitmap(chunk, info, chunk.bpp, chunk.format, "bmp");
+
         // file.seek(bmpHeader.bitmapOffset, SEEK_SET);
 
         const auto compression = (Compression)header.compression;
@@ -689,11 +674,11 @@ bool cFormatBmp::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
             switch (header.bitCount)
             {
             case 1:
-                result = readUncompressed1(file, chunk, header, palette);
+                result = readUncompressed1(file, chunk, header);
                 break;
 
             case 8:
-                result = readUncompressed8(file, chunk, header, palette);
+                result = readUncompressed8(file, chunk, header);
                 break;
 
             case 16:
@@ -722,7 +707,7 @@ bool cFormatBmp::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
             switch (header.bitCount)
             {
             case 8:
-                result = readRLE8(file, chunk, header, palette, false);
+                result = readRLE8(file, chunk, header, false);
                 break;
             }
 
@@ -739,7 +724,7 @@ bool cFormatBmp::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
             switch (header.bitCount)
             {
             case 8:
-                result = readRLE8(file, chunk, header, palette, true);
+                result = readRLE8(file, chunk, header, true);
                 break;
             }
 
@@ -757,7 +742,7 @@ bool cFormatBmp::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
 
         // Extract ICC profile from V5 header (only for 8-bit-per-channel formats)
         if (ver == Version::V5 && header.profileSize > 0 && header.profileData > 0
-            && (chunk.format == ePixelFormat::BGR || chunk.format == ePixelFormat::BGRA))
+            && (chunk.format == ePixelFormat::BGR || chunk.format == ePixelFormat::BGRA || chunk.format == ePixelFormat::Indexed8))
         {
             auto profileOffset = sizeof(BmpHeader) + header.profileData;
             if (profileOffset + header.profileSize <= static_cast<size_t>(file.getSize()))
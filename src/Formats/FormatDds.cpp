@@ -11,10 +11,8 @@
 #include "Common/ChunkData.h"
 #include "Common/File.h"
 #include "Common/ImageInfo.h"
-#include "Libs/GpuDecode.h"
 #include "Log/Log.h"
 
-#include <cmath>
 #include <cstdlib>
 #include <cstring>
 
@@ -423,20 +421,19 @@ bool cFormatDds::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
     }
     else
     {
-        using GpuDecodeFunc = void (*)(const uint8_t*, uint8_t*, uint32_t, uint32_t);
-        GpuDecodeFunc decoder = nullptr;
+        auto compressedFormat = eCompressedFormat::None;
 
         if (format == DDS_DXT1)
         {
-            decoder = gpu_decode::decodeBC1;
+            compressedFormat = eCompressedFormat::BC1;
         }
         else if (format == DDS_DXT2 || format == DDS_DXT3)
         {
-            decoder = gpu_decode::decodeBC2;
+            compressedFormat = eCompressedFormat::BC2;
         }
         else if (format == DDS_DXT4 || format == DDS_DXT5)
         {
-            decoder = gpu_decode::decodeBC3;
+            compressedFormat = eCompressedFormat::BC3;
         }
         else if (format == DDS_DXT10)
         {
@@ -445,32 +442,32 @@ bool cFormatDds::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
             case DXGI_FORMAT_BC1_TYPELESS:
             case DXGI_FORMAT_BC1_UNORM:
             case DXGI_FORMAT_BC1_UNORM_SRGB:
-                decoder = gpu_decode::decodeBC1;
+                compressedFormat = eCompressedFormat::BC1;
                 break;
             case DXGI_FORMAT_BC2_TYPELESS:
             case DXGI_FORMAT_BC2_UNORM:
             case DXGI_FORMAT_BC2_UNORM_SRGB:
-                decoder = gpu_decode::decodeBC2;
+                compressedFormat = eCompressedFormat::BC2;
                 break;
             case DXGI_FORMAT_BC3_TYPELESS:
             case DXGI_FORMAT_BC3_UNORM:
             case DXGI_FORMAT_BC3_UNORM_SRGB:
-                decoder = gpu_decode::decodeBC3;
+                compressedFormat = eCompressedFormat::BC3;
                 break;
             case DXGI_FORMAT_BC4_TYPELESS:
             case DXGI_FORMAT_BC4_UNORM:
             case DXGI_FORMAT_BC4_SNORM:
-                decoder = gpu_decode::decodeBC4;
+                compressedFormat = eCompressedFormat::BC4;
                 break;
             case DXGI_FORMAT_BC5_TYPELESS:
             case DXGI_FORMAT_BC5_UNORM:
             case DXGI_FORMAT_BC5_SNORM:
-                decoder = gpu_decode::decodeBC5;
+                compressedFormat = eCompressedFormat::BC5;
                 break;
             case DXGI_FORMAT_BC7_TYPELESS:
             case DXGI_FORMAT_BC7_UNORM:
             case DXGI_FORMAT_BC7_UNORM_SRGB:
-                decoder = gpu_decode::decodeBC7;
+                compressedFormat = eCompressedFormat::BC7;
                 break;
             default:
                 cLog::Error("Unsupported DXT10 DXGI format: {}.", static_cast<uint32_t>(header10.dxgiFormat));
@@ -478,21 +475,19 @@ bool cFormatDds::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
             }
         }
 
-        if (decoder == nullptr)
+        if (compressedFormat == eCompressedFormat::None)
         {
             cLog::Error("No decoder for DDS format.");
             return false;
         }
 
-        chunk.format = ePixelFormat::RGBA;
-        chunk.bpp = 32;
-        info.bppImage = 32;
-        chunk.pitch = chunk.width * 4;
-        const uint32_t h = static_cast<uint32_t>(::ceilf(chunk.height / 4.0f)) * 4;
-        const uint32_t size = chunk.pitch * h;
-        chunk.bitmap.resize(size);
+        if (data_size < compressed::getDataSize(compressedFormat, chunk.width, chunk.height))
+        {
+            cLog::Error("Can't load DDS file '{}': truncated data.", filename);
+            return false;
+        }
 
-        decoder(src, chunk.bitmap.data(), chunk.width, chunk.height);
+        return setupCompressed(chunk, info, compressedFormat, src);
     }
 
     return true;
@@ -112,7 +112,7 @@ bool cFormatEps::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
             auto progressCb = [this](float p) { updateProgress(p); };
             auto allocatedCb = [this]() { signalBitmapAllocated(); };
             auto imageInfoCb = [this]() { signalImageInfo(); };
-            auto result = m_decoder.decodeJpeg(decoded.data(), static_cast<uint32_t>(decoded.size()), chunk, info, progressCb, allocatedCb, imageInfoCb, nullptr, m_stop);
+            auto result = m_decoder.decodeJpeg(decoded.data(), static_cast<uint32_t>(decoded.size()), chunk, info, progressCb, allocatedCb, imageInfoCb, nullptr, getStopToken());
             if (result.success)
             {
                 // ICC LUT generated inside decodeJpeg() — applied on GPU
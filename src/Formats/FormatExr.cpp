@@ -17,12 +17,10 @@
 #include "Common/ImageInfo.h"
 #include "Log/Log.h"
 
-#include <OpenEXR/ImfArray.h>
 #include <OpenEXR/ImfPreviewImage.h>
 #include <OpenEXR/ImfRgbaFile.h>
 #include <OpenEXR/ImfStandardAttributes.h>
 #include <OpenEXR/ImfTiledRgbaFile.h>
-#include <algorithm>
 #include <cstring>
 #include <iterator>
 
@@ -36,17 +34,7 @@ namespace
         uint8_t a;
     };
 
-    struct sRgb888
-    {
-        uint8_t r;
-        uint8_t g;
-        uint8_t b;
-    };
-
-    inline uint8_t HalfToUint8(const half& h)
-    {
-        return static_cast<uint8_t>(std::clamp(static_cast<uint32_t>(h * 255.0f), 0u, 255u));
-    }
+    static_assert(sizeof(Imf::Rgba) == 8, "Imf::Rgba must match the RGBA16F layout");
 
     const char* GetFormat(uint32_t format)
     {
@@ -99,7 +87,16 @@ namespace
 #endif
     }
 
-    bool ReadTiledRgba(const char* filename, Imf::Array2D<Imf::Rgba>& pixels, sChunkData& chunk, sImageInfo& info, Imf::RgbaChannels& channels, uint32_t& compression)
+    // Half RGBA is decoded straight into the bitmap, the GPU takes it as
+    // RGBA16F.
+    Imf::Rgba* AllocateRgba(sChunkData& chunk, const Imath::Box2i& dw)
+    {
+        chunk.allocate(dw.max.x - dw.min.x + 1, dw.max.y - dw.min.y + 1, 64, ePixelFormat::RGBA16F);
+        auto pixels = reinterpret_cast<Imf::Rgba*>(chunk.bitmap.data());
+        return pixels - dw.min.x - static_cast<ptrdiff_t>(dw.min.y) * chunk.width;
+    }
+
+    bool ReadTiledRgba(const char* filename, sChunkData& chunk, sImageInfo& info, Imf::RgbaChannels& channels, uint32_t& compression)
     {
         Imf::TiledRgbaInputFile in(filename);
         bool result = in.isComplete();
@@ -111,23 +108,14 @@ namespace
             ReadHeader(header, chunk, info);
 
             auto& dw = in.dataWindow();
-            const auto width = dw.max.x - dw.min.x + 1;
-            const auto height = dw.max.y - dw.min.y + 1;
-            chunk.width = width;
-            chunk.height = height;
-
-            const auto dx = dw.min.x;
-            const auto dy = dw.min.y;
-
-            pixels.resizeErase(height, width);
-            in.setFrameBuffer(&pixels[-dy][-dx], 1, width);
+            in.setFrameBuffer(AllocateRgba(chunk, dw), 1, chunk.width);
             in.readTiles(0, in.numXTiles() - 1, 0, in.numYTiles() - 1);
         }
 
         return result;
     }
 
-    bool ReadScanlineRgba(const char* filename, Imf::Array2D<Imf::Rgba>& pixels, sChunkData& chunk, sImageInfo& info, Imf::RgbaChannels& channels, uint32_t& compression)
+    bool ReadScanlineRgba(const char* filename, sChunkData& chunk, sImageInfo& info, Imf::RgbaChannels& channels, uint32_t& compression)
     {
         Imf::RgbaInputFile in(filename);
         bool result = in.isComplete();
@@ -140,16 +128,7 @@ namespace
             ReadHeader(header, chunk, info);
 
             auto& dw = in.dataWindow();
-            const auto width = dw.max.x - dw.min.x + 1;
-            const auto height = dw.max.y - dw.min.y + 1;
-            chunk.width = width;
-            chunk.height = height;
-
-            const auto dx = dw.min.x;
-            const auto dy = dw.min.y;
-
-            pixels.resizeErase(height, width);
-            in.setFrameBuffer(&pixels[-dy][-dx], 1, width);
+            in.setFrameBuffer(AllocateRgba(chunk, dw), 1, chunk.width);
             in.readPixels(dw.min.y, dw.max.y);
         }
 
@@ -251,12 +230,11 @@ bool cFormatExr::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
     bool result = false;
 
     Imf::RgbaChannels channels = static_cast<Imf::RgbaChannels>(0u);
-    Imf::Array2D<Imf::Rgba> pixels;
     uint32_t compression = ~0u;
 
     try
     {
-        result = ReadScanlineRgba(filename, pixels, chunk, info, channels, compression);
+        result = ReadScanlineRgba(filename, chunk, info, channels, compression);
     }
     catch (...)
     {
@@ -264,7 +242,7 @@ bool cFormatExr::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
 
         try
         {
-            result = ReadTiledRgba(filename, pixels, chunk, info, channels, compression);
+            result = ReadTiledRgba(filename, chunk, info, channels, compression);
         }
         catch (...)
         {
@@ -303,43 +281,9 @@ bool cFormatExr::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
 
         info.bppImage = chCount * 8;
 
-        const bool hasA = (channels & Imf::WRITE_A) != 0;
-        const uint32_t bytes = hasA ? 4 : 3;
-        chunk.bpp = bytes * 8;
-        chunk.format = hasA ? ePixelFormat::RGBA : ePixelFormat::RGB;
-        chunk.allocate(chunk.width, chunk.height, chunk.bpp, chunk.format);
-
-        if (hasA)
-        {
-            auto src = &pixels[0][0];
-            for (uint32_t y = 0; y < chunk.height; y++)
-            {
-                auto dst = reinterpret_cast<sRgba8888*>(chunk.bitmap.data() + y * chunk.pitch);
-                for (uint32_t x = 0; x < chunk.width; x++)
-                {
-                    const auto& i = *src++;
-                    dst[x].r = HalfToUint8(i.r);
-                    dst[x].g = HalfToUint8(i.g);
-                    dst[x].b = HalfToUint8(i.b);
-                    dst[x].a = HalfToUint8(i.a);
-                }
-            }
-        }
-        else
-        {
-            auto src = &pixels[0][0];
-            for (uint32_t y = 0; y < chunk.height; y++)
-            {
-                auto dst = reinterpret_cast<sRgb888*>(chunk.bitmap.data() + y * chunk.pitch);
-                for (uint32_t x = 0; x < chunk.width; x++)
-                {
-                    const auto& i = *src++;
-                    dst[x].r = HalfToUint8(i.r);
-                    dst[x].g = HalfToUint8(i.g);
-                    dst[x].b = HalfToUint8(i.b);
-                }
-            }
-        }
+        // Scene-linear half floats, exposed and tone mapped on the GPU.
+        // Missing alpha is filled with 1.0 by the RGBA interface.
+        chunk.effects |= eEffect::ToneMap;
 
         info.formatName = GetFormat(compression);
     }
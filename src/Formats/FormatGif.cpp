@@ -73,8 +73,76 @@ namespace
         for (uint32_t x = 0; x < width; x++)
         {
             const uint32_t idx = image.RasterBits[row * width + x];
-            const uint32_t pos = (row + image.ImageDesc.Top) * chunk.pitch + (x + image.ImageDesc.Left) * 4;
-            putPixel(chunk, pos, &cmap->Colors[idx], transparentIdx == idx);
+            if (chunk.format == ePixelFormat::Indexed8)
+            {
+                if (transparentIdx != idx)
+                {
+                    chunk.bitmap[(row + image.ImageDesc.Top) * chunk.pitch + x + image.ImageDesc.Left] = static_cast<uint8_t>(idx);
+                }
+            }
+            else
+            {
+                const uint32_t pos = (row + image.ImageDesc.Top) * chunk.pitch + (x + image.ImageDesc.Left) * 4;
+                putPixel(chunk, pos, &cmap->Colors[idx], transparentIdx == idx);
+            }
+        }
+    }
+
+    int getTransparentIndex(const SavedImage& image)
+    {
+        for (int i = 0; i < image.ExtensionBlockCount; i++)
+        {
+            const auto& eb = image.ExtensionBlocks[i];
+            if (eb.ByteCount == 4 && eb.Function == 0xF9 && (eb.Bytes[0] & 1) == 1)
+            {
+                return eb.Bytes[3];
+            }
+        }
+
+        return -1;
+    }
+
+    // Frames stay palette indices when they share one colormap. Animations
+    // also need one transparent index, it fills cleared canvas areas.
+    bool isIndexable(const GifFileType* gif, int& clearIdx)
+    {
+        if (gif->ImageCount == 1)
+        {
+            clearIdx = std::max(getTransparentIndex(gif->SavedImages[0]), 0);
+            return true;
+        }
+
+        clearIdx = getTransparentIndex(gif->SavedImages[0]);
+        if (gif->SColorMap == nullptr || clearIdx < 0)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < gif->ImageCount; i++)
+        {
+            const auto& image = gif->SavedImages[i];
+            if (image.ImageDesc.ColorMap != nullptr || getTransparentIndex(image) != clearIdx)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void setPalette(sChunkData& chunk, const ColorMapObject* cmap, int transparentIdx)
+    {
+        for (int i = 0; i < cmap->ColorCount && i < 256; i++)
+        {
+            auto entry = &chunk.palette[i * 4];
+            entry[0]   = cmap->Colors[i].Red;
+            entry[1]   = cmap->Colors[i].Green;
+            entry[2]   = cmap->Colors[i].Blue;
+            entry[3]   = 255;
+        }
+        if (transparentIdx >= 0)
+        {
+            ::memset(&chunk.palette[transparentIdx * 4], 0, 4);
         }
     }
 } // namespace
@@ -130,7 +198,24 @@ bool cFormatGif::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
     chunk.width = m_gif->SWidth;
     chunk.height = m_gif->SHeight;
 
-    chunk.allocate(chunk.width, chunk.height, 32, ePixelFormat::RGBA);
+    m_indexed = isIndexable(m_gif.get(), m_clearIdx);
+    if (m_indexed)
+    {
+        const auto& image = m_gif->SavedImages[0];
+        auto cmap         = image.ImageDesc.ColorMap != nullptr ? image.ImageDesc.ColorMap : m_gif->SColorMap;
+        if (cmap == nullptr)
+        {
+            cLog::Error("Invalid GIF colormap.");
+            return false;
+        }
+
+        chunk.allocateIndexed(chunk.width, chunk.height);
+        setPalette(chunk, cmap, getTransparentIndex(image));
+    }
+    else
+    {
+        chunk.allocate(chunk.width, chunk.height, 32, ePixelFormat::RGBA);
+    }
 
     m_prevFrame = {};
 
@@ -196,10 +281,13 @@ bool cFormatGif::load(uint32_t current, sChunkData& chunk, sImageInfo& info)
         }
     }
 
-    // Apply previous frame's disposal before rendering current frame
+    // Apply previous frame's disposal before rendering current frame.
+    // Indexed canvases are cleared to the transparent index.
+    const uint32_t bytesPerPixel = m_indexed ? 1 : 4;
+    const int clear              = m_indexed ? m_clearIdx : 0;
     if (info.current == 0)
     {
-        std::memset(chunk.bitmap.data(), 0, chunk.bitmap.size());
+        std::memset(chunk.bitmap.data(), clear, chunk.bitmap.size());
         m_prevFrame = {};
     }
     else if (m_prevFrame.disposalMode == 2)
@@ -207,8 +295,8 @@ bool cFormatGif::load(uint32_t current, sChunkData& chunk, sImageInfo& info)
         // Clear previous frame's rectangle to transparent black
         for (uint32_t y = m_prevFrame.top; y < m_prevFrame.top + m_prevFrame.height && y < chunk.height; y++)
         {
-            auto* row = &chunk.bitmap[y * chunk.pitch + m_prevFrame.left * 4];
-            std::memset(row, 0, std::min(m_prevFrame.width, chunk.width - m_prevFrame.left) * 4);
+            auto* row = &chunk.bitmap[y * chunk.pitch + m_prevFrame.left * bytesPerPixel];
+            std::memset(row, clear, std::min(m_prevFrame.width, chunk.width - m_prevFrame.left) * bytesPerPixel);
         }
     }
     // Mode 0/1: leave canvas as-is (overlay)
@@ -259,6 +347,29 @@ bool cFormatGif::load(uint32_t current, sChunkData& chunk, sImageInfo& info)
         info.formatName = "gif/p";
     }
 
+    // Area changed since the previous frame: its disposal and this frame.
+    chunk.dirty = {};
+    if (info.current != 0)
+    {
+        uint32_t x0 = image.ImageDesc.Left;
+        uint32_t y0 = image.ImageDesc.Top;
+        uint32_t x1 = x0 + width;
+        uint32_t y1 = y0 + height;
+        if (m_prevFrame.disposalMode == 2)
+        {
+            x0 = std::min(x0, m_prevFrame.left);
+            y0 = std::min(y0, m_prevFrame.top);
+            x1 = std::max(x1, m_prevFrame.left + m_prevFrame.width);
+            y1 = std::max(y1, m_prevFrame.top + m_prevFrame.height);
+        }
+        x1 = std::min(x1, chunk.width);
+        y1 = std::min(y1, chunk.height);
+        if (x0 < x1 && y0 < y1)
+        {
+            chunk.dirty = { x0, y0, x1 - x0, y1 - y0 };
+        }
+    }
+
     // Save current frame's disposal info for next frame
     m_prevFrame.disposalMode = disposalMode;
     m_prevFrame.left = image.ImageDesc.Left;
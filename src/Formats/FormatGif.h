@@ -24,6 +24,11 @@ public:
 
     bool isSupported(cFile& file, Buffer& buffer) const override;
 
+    bool isSubImageSequential() const override
+    {
+        return true;
+    }
+
 private:
     bool LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& info) override;
     bool LoadSubImageImpl(uint32_t current, sChunkData& chunk, sImageInfo& info) override;
@@ -33,6 +38,10 @@ private:
 private:
     std::string m_filename;
 
+    // Frames are kept as palette indices, see isIndexable().
+    bool m_indexed = false;
+    int m_clearIdx = 0;
+
     struct PreviousFrame
     {
         uint32_t disposalMode = 0;
@@ -15,11 +15,11 @@
 #include "Common/ChunkData.h"
 #include "Common/File.h"
 #include "Common/ImageInfo.h"
+#include "Common/ThreadPool.h"
 #include "Log/Log.h"
 
 #include <cstring>
 #include <openjpeg.h>
-#include <thread>
 
 namespace
 {
@@ -33,8 +33,8 @@ namespace
 
     void j2k_error_callback(const char* msg, void* client_data)
     {
-        auto stop = static_cast<const bool*>(client_data);
-        if (stop == nullptr || *stop == false)
+        auto stop = static_cast<const cStopToken*>(client_data);
+        if (stop == nullptr || stop->isRequested() == false)
         {
             std::string_view sv(msg);
             while (sv.empty() == false && (sv.back() == '\n' || sv.back() == '\r'))
@@ -77,13 +77,13 @@ namespace
     struct StreamContext
     {
         cFile* file;
-        const bool* stop;
+        const cStopToken* stop;
     };
 
     size_t streamRead(void* buffer, size_t size, void* user)
     {
         auto ctx = static_cast<StreamContext*>(user);
-        if (*ctx->stop)
+        if (ctx->stop->isRequested())
         {
             return static_cast<size_t>(-1);
         }
@@ -101,7 +101,7 @@ namespace
     off_t streamSkip(off_t bytes, void* user)
     {
         auto ctx = static_cast<StreamContext*>(user);
-        if (*ctx->stop)
+        if (ctx->stop->isRequested())
         {
             return -1;
         }
@@ -116,7 +116,7 @@ namespace
     int streamSeek(off_t bytes, void* user)
     {
         auto ctx = static_cast<StreamContext*>(user);
-        if (*ctx->stop)
+        if (ctx->stop->isRequested())
         {
             return 0;
         }
@@ -236,13 +236,13 @@ namespace
         return stream;
     }
 
-    bool createCodec(CodecContext& ctx, opj_stream_t* stream, const bool* stopFlag, uint32_t reduceFactor)
+    bool createCodec(CodecContext& ctx, opj_stream_t* stream, const cStopToken* stopFlag, uint32_t reduceFactor)
     {
         ctx.codec = opj_create_decompress(OPJ_CODEC_JP2);
 
         opj_set_info_handler(ctx.codec, j2k_info_callback, nullptr);
         opj_set_warning_handler(ctx.codec, j2k_warning_callback, nullptr);
-        opj_set_error_handler(ctx.codec, j2k_error_callback, const_cast<bool*>(stopFlag));
+        opj_set_error_handler(ctx.codec, j2k_error_callback, const_cast<cStopToken*>(stopFlag));
 
         opj_dparameters_t parameters;
         opj_set_default_decoder_parameters(&parameters);
@@ -253,7 +253,8 @@ namespace
             return false;
         }
 
-        const auto numThreads = std::max(1u, std::thread::hardware_concurrency());
+        // OpenJPEG runs its own workers, size them like the shared pool.
+        const auto numThreads = cThreadPool::shared().getThreadsCount();
         opj_codec_set_threads(ctx.codec, static_cast<int>(numThreads));
 
         if (opj_read_header(stream, ctx.codec, &ctx.image) == false)
@@ -286,12 +287,12 @@ bool cFormatJp2k::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
         return false;
     }
 
-    StreamContext sctx{ &file, &m_stop };
+    StreamContext sctx{ &file, &getStopToken() };
 
     // Phase 1: Read header to get tile/resolution info and determine preview factor.
     auto stream = createStream(&sctx, info.fileSize);
     CodecContext headerCtx;
-    if (createCodec(headerCtx, stream, &m_stop, 0) == false)
+    if (createCodec(headerCtx, stream, &getStopToken(), 0) == false)
     {
         cLog::Error("Can't read JPEG2000 header.");
         opj_stream_destroy(stream);
@@ -332,12 +333,12 @@ bool cFormatJp2k::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
     stream = nullptr;
 
     // Phase 2: Quick low-resolution preview (if image is large enough).
-    if (reduceFactor > 0 && m_stop == false)
+    if (reduceFactor > 0 && isStopped() == false)
     {
         decodePreview(file, info.fileSize, reduceFactor, fullWidth, fullHeight);
     }
 
-    if (m_stop)
+    if (isStopped())
     {
         return false;
     }
@@ -346,7 +347,7 @@ bool cFormatJp2k::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
     file.seek(0, SEEK_SET);
     stream = createStream(&sctx, info.fileSize);
     CodecContext fullCtx;
-    if (createCodec(fullCtx, stream, &m_stop, 0) == false)
+    if (createCodec(fullCtx, stream, &getStopToken(), 0) == false)
     {
         cLog::Error("Can't set up JPEG2000 full-res decoder.");
         opj_stream_destroy(stream);
@@ -405,14 +406,14 @@ bool cFormatJp2k::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
         constexpr uint32_t StripHeight = 4096;
         const uint32_t numStrips       = (chunk.height + StripHeight - 1) / StripHeight;
 
-        for (uint32_t strip = 0; strip < numStrips && m_stop == false; strip++)
+        for (uint32_t strip = 0; strip < numStrips && isStopped() == false; strip++)
         {
             const uint32_t y0 = strip * StripHeight;
             const uint32_t y1 = std::min(y0 + StripHeight, chunk.height);
 
             if (opj_set_decode_area(fullCtx.codec, fullCtx.image, 0, y0, chunk.width, y1) == false)
             {
-                if (m_stop == false)
+                if (isStopped() == false)
                 {
                     cLog::Error("Can't set JPEG2000 decode area for strip {}.", strip);
                 }
@@ -422,7 +423,7 @@ bool cFormatJp2k::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
 
             if (opj_decode(fullCtx.codec, stream, fullCtx.image) == false)
             {
-                if (m_stop == false)
+                if (isStopped() == false)
                 {
                     cLog::Error("Can't decode JPEG2000 strip {}/{}.", strip + 1, numStrips);
                 }
@@ -439,11 +440,11 @@ bool cFormatJp2k::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
     else
     {
         // Multi-tile image: decode tile-by-tile.
-        for (uint32_t tileIdx = 0; tileIdx < numTiles && m_stop == false; tileIdx++)
+        for (uint32_t tileIdx = 0; tileIdx < numTiles && isStopped() == false; tileIdx++)
         {
             if (opj_get_decoded_tile(fullCtx.codec, stream, fullCtx.image, tileIdx) == false)
             {
-                if (m_stop == false)
+                if (isStopped() == false)
                 {
                     cLog::Error("Can't decode JPEG2000 tile {}/{}.", tileIdx + 1, numTiles);
                 }
@@ -466,7 +467,7 @@ bool cFormatJp2k::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
         }
     }
 
-    if (m_stop || decodeOk == false)
+    if (isStopped() || decodeOk == false)
     {
         opj_stream_destroy(stream);
         return false;
@@ -488,17 +489,17 @@ void cFormatJp2k::decodePreview(cFile& file, long fileSize, uint32_t reduceFacto
 {
     file.seek(0, SEEK_SET);
 
-    StreamContext sctx{ &file, &m_stop };
+    StreamContext sctx{ &file, &getStopToken() };
     auto stream = createStream(&sctx, fileSize);
 
     CodecContext ctx;
-    if (createCodec(ctx, stream, &m_stop, reduceFactor) == false)
+    if (createCodec(ctx, stream, &getStopToken(), reduceFactor) == false)
     {
         opj_stream_destroy(stream);
         return;
     }
 
-    if (opj_decode(ctx.codec, stream, ctx.image) == false || m_stop)
+    if (opj_decode(ctx.codec, stream, ctx.image) == false || isStopped())
     {
         opj_stream_destroy(stream);
         return;
@@ -518,7 +519,7 @@ void cFormatJp2k::decodePreview(cFile& file, long fileSize, uint32_t reduceFacto
     previewChunk.allocate(ctx.image->comps[0].w, ctx.image->comps[0].h, bpp, format);
 
     convertPixels(ctx.image, previewChunk, 0, 0);
-    if (m_stop)
+    if (isStopped())
     {
         return;
     }
@@ -572,7 +573,7 @@ void cFormatJp2k::convertPixels(opj_image_t* image, sChunkData& chunk, uint32_t
     switch (numcomps)
     {
     case 1:
-        for (uint32_t y = 0; y < tileH && m_stop == false; y++)
+        for (uint32_t y = 0; y < tileH && isStopped() == false; y++)
         {
             packRow(y, [&](uint32_t pos, uint8_t*& bits) {
                 *bits++ = read8(comps[0], pos);
@@ -581,7 +582,7 @@ void cFormatJp2k::convertPixels(opj_image_t* image, sChunkData& chunk, uint32_t
         break;
 
     case 2:
-        for (uint32_t y = 0; y < tileH && m_stop == false; y++)
+        for (uint32_t y = 0; y < tileH && isStopped() == false; y++)
         {
             packRow(y, [&](uint32_t pos, uint8_t*& bits) {
                 *bits++ = read8(comps[0], pos);
@@ -591,7 +592,7 @@ void cFormatJp2k::convertPixels(opj_image_t* image, sChunkData& chunk, uint32_t
         break;
 
     case 3:
-        for (uint32_t y = 0; y < tileH && m_stop == false; y++)
+        for (uint32_t y = 0; y < tileH && isStopped() == false; y++)
         {
             packRow(y, [&](uint32_t pos, uint8_t*& bits) {
                 *bits++ = read8(comps[0], pos);
@@ -602,7 +603,7 @@ void cFormatJp2k::convertPixels(opj_image_t* image, sChunkData& chunk, uint32_t
         break;
 
     default:
-        for (uint32_t y = 0; y < tileH && m_stop == false; y++)
+        for (uint32_t y = 0; y < tileH && isStopped() == false; y++)
         {
             packRow(y, [&](uint32_t pos, uint8_t*& bits) {
                 *bits++ = read8(comps[0], pos);
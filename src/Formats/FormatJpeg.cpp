@@ -51,9 +51,30 @@ bool cFormatJpeg::isSupported(cFile& file, Buffer& buffer) const
 }
 
 bool cFormatJpeg::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& info)
+{
+    m_filename = filename;
+    return decode(chunk, info, true);
+}
+
+bool cFormatJpeg::LoadSubImageImpl(uint32_t subImage, sChunkData& chunk, sImageInfo& info)
+{
+    if (subImage != 0 || m_filename.empty())
+    {
+        return false;
+    }
+
+    // Same picture at the new target size, the decode fills effects and
+    // EXIF in again.
+    chunk.effects = eEffect::None;
+    info.exifList.clear();
+
+    return decode(chunk, info, false);
+}
+
+bool cFormatJpeg::decode(sChunkData& chunk, sImageInfo& info, bool sendPreview)
 {
     cFile file;
-    if (openFile(file, filename, info) == false)
+    if (openFile(file, m_filename.c_str(), info) == false)
     {
         return false;
     }
@@ -65,7 +86,7 @@ bool cFormatJpeg::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
     auto progressCb = [this](float p) { updateProgress(p); };
     auto allocatedCb = [this]() { signalBitmapAllocated(); };
     auto imageInfoCb = [this]() { signalImageInfo(); };
-    auto previewCb = [this, &chunk](cJpegDecoder::Bitmap&& thumb) {
+    auto previewCb = [this, &chunk, &info](cJpegDecoder::Bitmap&& thumb) {
         sPreviewData preview;
         preview.bitmap = std::move(thumb.data);
         preview.width = thumb.width;
@@ -73,11 +94,14 @@ bool cFormatJpeg::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo&
         preview.pitch = thumb.pitch;
         preview.bpp = thumb.bpp;
         preview.format = thumb.format;
-        preview.fullImageWidth = chunk.width;
-        preview.fullImageHeight = chunk.height;
+        preview.fullImageWidth = info.fullWidth != 0 ? info.fullWidth : chunk.width;
+        preview.fullImageHeight = info.fullWidth != 0 ? info.fullHeight : chunk.height;
         signalPreviewReady(std::move(preview));
     };
-    auto result = m_decoder.decodeJpeg(in.data(), static_cast<uint32_t>(size), chunk, info, progressCb, allocatedCb, imageInfoCb, previewCb, m_stop);
+    const bool wantPreview = sendPreview && isPreviewSent() == false;
+    auto result = m_decoder.decodeJpeg(in.data(), static_cast<uint32_t>(size), chunk, info, progressCb, allocatedCb, imageInfoCb,
+                                       wantPreview ? cJpegDecoder::PreviewCallback(previewCb) : cJpegDecoder::PreviewCallback(),
+                                       getStopToken(), m_targetWidth, m_targetHeight);
     if (result.success == false)
     {
         return false;
@@ -12,6 +12,8 @@
 #include "Format.h"
 #include "Libs/JpegDecoder.h"
 
+#include <string>
+
 class cFormatJpeg final : public cFormat
 {
 public:
@@ -21,6 +23,10 @@ public:
 
 private:
     bool LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& info) override;
+    // Sub-image 0 is the same picture decoded at the current target size.
+    bool LoadSubImageImpl(uint32_t subImage, sChunkData& chunk, sImageInfo& info) override;
+    bool decode(sChunkData& chunk, sImageInfo& info, bool sendPreview);
 
     cJpegDecoder m_decoder;
+    std::string m_filename;
 };
@@ -97,7 +97,7 @@ bool cFormatPng::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
             : "png/icc";
         signalBitmapAllocated();
     });
-    reader.setStopFlag(&m_stop);
+    reader.setStopToken(&getStopToken());
 
     // ICC LUT generated inside loadPng() — applied on GPU during rendering
     return reader.loadPng(chunk, info, file);
@@ -238,7 +238,7 @@ bool cFormatPng::loadCgBI(cFile& file, sChunkData& chunk, sImageInfo& info)
 
     for (uint32_t y = 0; y < height; y++)
     {
-        if (m_stop)
+        if (isStopped())
         {
             return false;
         }
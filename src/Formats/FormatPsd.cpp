@@ -777,18 +777,18 @@ bool cFormatPsd::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
 
     signalBitmapAllocated();
 
-    for (uint32_t batchStart = 0; batchStart < chunk.height && m_stop == false; batchStart += BatchSize)
+    for (uint32_t batchStart = 0; batchStart < chunk.height && isStopped() == false; batchStart += BatchSize)
     {
         const uint32_t batchEnd = std::min(batchStart + BatchSize, chunk.height);
 
         // For RAW/RLE: read batch rows from file
         if (isZip == false)
         {
-            for (uint32_t ch = 0; ch < channels && m_stop == false; ch++)
+            for (uint32_t ch = 0; ch < channels && isStopped() == false; ch++)
             {
                 file.seek(channelRowOffsets[ch * chunk.height + batchStart], SEEK_SET);
 
-                for (uint32_t row = batchStart; row < batchEnd && m_stop == false; row++)
+                for (uint32_t row = batchStart; row < batchEnd && isStopped() == false; row++)
                 {
                     auto dst = batchBufs[ch].data() + (row - batchStart) * rowBytes;
 
@@ -886,7 +886,7 @@ bool cFormatPsd::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& i
         updateProgress(static_cast<float>(batchEnd) / chunk.height);
     }
 
-    if (m_stop)
+    if (isStopped())
     {
         return false;
     }
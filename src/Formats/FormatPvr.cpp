@@ -12,7 +12,6 @@
 #include "Common/File.h"
 #include "Common/Helpers.h"
 #include "Common/ImageInfo.h"
-#include "Libs/GpuDecode.h"
 #include "Log/Log.h"
 
 #include <cstring>
@@ -300,8 +299,6 @@ namespace
         return inflateEnd(&d_stream) == Z_OK;
     }
 
-    using GpuDecodeFunc = void (*)(const uint8_t*, uint8_t*, uint32_t, uint32_t);
-
 } // namespace
 
 bool cFormatPvr::isGZipBuffer(const uint8_t* buffer, uint32_t size) const
@@ -602,10 +599,9 @@ bool cFormatPvr::loadPvr3(const uint8_t* data, sChunkData& chunk, sImageInfo& in
         Copy,
         PVRTC2,
         PVRTC4,
-        GPU,
     };
     auto decompress = Decomp::Copy;
-    GpuDecodeFunc gpuDecoder = nullptr;
+    auto compressedFormat = eCompressedFormat::None;
     auto bytes = 0u;
     switch (pixelFormat)
     {
@@ -658,75 +654,42 @@ bool cFormatPvr::loadPvr3(const uint8_t* data, sChunkData& chunk, sImageInfo& in
         chunk.format = ePixelFormat::RGBA;
         break;
 
-    // GPU compressed formats — all decode to RGBA
+    // GPU compressed formats — passed through or decoded to RGBA
     case PVR3TexturePixelFormat::ETC1:
     case PVR3TexturePixelFormat::ETC2_RGB:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeETC2_RGB;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::ETC2_RGB;
         break;
     case PVR3TexturePixelFormat::ETC2_RGBA:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeETC2_RGBA;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::ETC2_RGBA;
         break;
     case PVR3TexturePixelFormat::ETC2_RGBA1:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeETC2_RGBA1;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::ETC2_RGBA1;
         break;
     case PVR3TexturePixelFormat::EAC_R11_Unsigned:
     case PVR3TexturePixelFormat::EAC_R11_Signed:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeEAC_R11;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::EAC_R11;
         break;
     case PVR3TexturePixelFormat::EAC_RG11_Unsigned:
     case PVR3TexturePixelFormat::EAC_RG11_Signed:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeEAC_RG11;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::EAC_RG11;
         break;
     case PVR3TexturePixelFormat::BC1:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeBC1;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::BC1;
         break;
     case PVR3TexturePixelFormat::BC2:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeBC2;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::BC2;
         break;
     case PVR3TexturePixelFormat::BC3:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeBC3;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::BC3;
         break;
     case PVR3TexturePixelFormat::BC4:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeBC4;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::BC4;
         break;
     case PVR3TexturePixelFormat::BC5:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeBC5;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::BC5;
         break;
     case PVR3TexturePixelFormat::BC7:
-        decompress = Decomp::GPU;
-        gpuDecoder = gpu_decode::decodeBC7;
-        bytes = 4;
-        chunk.format = ePixelFormat::RGBA;
+        compressedFormat = eCompressedFormat::BC7;
         break;
 
     default:
@@ -734,13 +697,19 @@ bool cFormatPvr::loadPvr3(const uint8_t* data, sChunkData& chunk, sImageInfo& in
         return false;
     }
 
-    chunk.bpp = bytes * 8;
-    info.bppImage = bytes * 8;
     chunk.width = width;
     chunk.height = height;
+    auto src = data + sizeof(PVRv3TexHeader) + header.metadataLength;
+
+    if (compressedFormat != eCompressedFormat::None)
+    {
+        return setupCompressed(chunk, info, compressedFormat, src);
+    }
+
+    chunk.bpp = bytes * 8;
+    info.bppImage = bytes * 8;
     chunk.pitch = width * bytes;
     chunk.resizeBitmap(chunk.pitch, chunk.height);
-    auto src = data + sizeof(PVRv3TexHeader) + header.metadataLength;
 
     switch (decompress)
     {
@@ -761,9 +730,6 @@ bool cFormatPvr::loadPvr3(const uint8_t* data, sChunkData& chunk, sImageInfo& in
             return false;
         }
         break;
-    case Decomp::GPU:
-        gpuDecoder(src, chunk.bitmap.data(), width, height);
-        break;
     }
 
     return true;
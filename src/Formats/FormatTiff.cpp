@@ -14,11 +14,41 @@
 #include "Common/ChunkData.h"
 #include "Common/File.h"
 #include "Common/ImageInfo.h"
+#include "Common/StopToken.h"
+#include "Common/ThreadPool.h"
 #include "Log/Log.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <stdarg.h>
+#include <thread>
 #include <tiffio.h>
+#include <vector>
+
+// Resolution of a page: the page itself, one of its SubIFDs or a
+// reduced-resolution directory following it.
+struct sTiffLevel
+{
+    uint16_t directory    = 0;
+    uint64_t subDirectory = 0; // SubIFD offset, 0 for a top-level directory
+    uint32_t width        = 0;
+    uint32_t height       = 0;
+};
+
+struct sTiffLayout
+{
+    ePixelFormat format = ePixelFormat::RGB;
+    uint32_t bpp        = 0;     // of a pixel in the bitmap
+    uint32_t srcBytes   = 0;     // of a decoded pixel
+    bool isNarrowed     = false; // 16-bit gray kept as 8-bit
+    bool isAssociated   = false; // premultiplied alpha
+    bool isTiled        = false;
+    uint32_t unitWidth  = 0; // tile width, image width for strips
+    uint32_t unitHeight = 0; // tile height or rows per strip
+};
 
 namespace
 {
@@ -32,6 +62,276 @@ namespace
         cLog::WriteV(cLog::Severity::Debug, fmt, ap);
     }
 
+    bool setLevel(TIFF* tif, const sTiffLevel& level)
+    {
+        return level.subDirectory != 0
+            ? TIFFSetSubDirectory(tif, level.subDirectory) != 0
+            : TIFFSetDirectory(tif, level.directory) != 0;
+    }
+
+    // Within a pixel of rounding, labels and macro images of slides are far off.
+    bool isSameAspect(const sTiffLevel& level, const sTiffLevel& full)
+    {
+        const auto a = static_cast<int64_t>(level.width) * full.height;
+        const auto b = static_cast<int64_t>(level.height) * full.width;
+        return std::abs(a - b) <= static_cast<int64_t>(full.width) + full.height;
+    }
+
+    // Levels of the current directory, finest first. Leaves the current
+    // directory selected.
+    void findLevels(TIFF* tif, uint16_t current, std::vector<sTiffLevel>& levels)
+    {
+        sTiffLevel full;
+        full.directory = current;
+        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &full.width);
+        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &full.height);
+        levels.push_back(full);
+
+        auto addLevel = [&](sTiffLevel level) {
+            TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &level.width);
+            TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &level.height);
+            if (level.width != 0 && level.width < full.width && isSameAspect(level, full))
+            {
+                levels.push_back(level);
+            }
+        };
+
+        // The offsets point into the directory that is about to be left.
+        uint16_t count    = 0;
+        uint64_t* offsets = nullptr;
+        std::vector<uint64_t> subDirectories;
+        if (TIFFGetField(tif, TIFFTAG_SUBIFD, &count, &offsets) != 0 && offsets != nullptr)
+        {
+            subDirectories.assign(offsets, offsets + count);
+        }
+
+        for (auto offset : subDirectories)
+        {
+            if (TIFFSetSubDirectory(tif, offset) != 0)
+            {
+                sTiffLevel level;
+                level.directory    = current;
+                level.subDirectory = offset;
+                addLevel(level);
+            }
+        }
+
+        if (subDirectories.empty())
+        {
+            const auto numDirs = TIFFNumberOfDirectories(tif);
+            for (uint32_t dir = current + 1; dir < numDirs && TIFFSetDirectory(tif, dir) != 0; dir++)
+            {
+                uint32_t subfileType = 0;
+                TIFFGetField(tif, TIFFTAG_SUBFILETYPE, &subfileType);
+                if ((subfileType & FILETYPE_REDUCEDIMAGE) == 0)
+                {
+                    break;
+                }
+
+                sTiffLevel level;
+                level.directory = static_cast<uint16_t>(dir);
+                addLevel(level);
+            }
+        }
+
+        std::stable_sort(levels.begin() + 1, levels.end(), [](const sTiffLevel& a, const sTiffLevel& b) {
+            return a.width > b.width;
+        });
+        levels.erase(std::unique(levels.begin(), levels.end(), [](const sTiffLevel& a, const sTiffLevel& b) {
+                         return a.width == b.width;
+                     }),
+                     levels.end());
+
+        TIFFSetDirectory(tif, current);
+    }
+
+    // Larger pyramid levels are only read in windows, unless the pyramid
+    // has nothing smaller.
+    constexpr uint32_t MaxLevelSize = 4096;
+
+    // Coarsest level that still covers the target box, fit either way round
+    // as the view may be rotated. The finest one without a target.
+    size_t pickLevel(const std::vector<sTiffLevel>& levels, uint32_t targetWidth, uint32_t targetHeight)
+    {
+        if (targetWidth == 0 || targetHeight == 0)
+        {
+            return 0;
+        }
+
+        const auto fw    = static_cast<float>(levels.front().width);
+        const auto fh    = static_cast<float>(levels.front().height);
+        const auto tw    = static_cast<float>(targetWidth);
+        const auto th    = static_cast<float>(targetHeight);
+        const auto scale = std::max(std::min(tw / fw, th / fh), std::min(th / fw, tw / fh));
+        for (size_t i = levels.size() - 1; i > 0; i--)
+        {
+            if (levels[i].width + 1.0f >= fw * scale)
+            {
+                return i;
+            }
+        }
+
+        return 0;
+    }
+
+    // Gray, gray + alpha, RGB and RGBA with 8 or 16 bits unsigned samples
+    // stored top-down and interleaved. Everything else goes through
+    // TIFFRGBAImage.
+    bool getNativeLayout(TIFF* tif, uint32_t height, sTiffLayout& layout)
+    {
+        uint16_t photometric = 0;
+        if (TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &photometric) == 0)
+        {
+            return false;
+        }
+
+        uint16_t bits         = 0;
+        uint16_t samples      = 0;
+        uint16_t planar       = 0;
+        uint16_t sampleFormat = 0;
+        uint16_t orientation  = 0;
+        uint16_t extraCount   = 0;
+        uint16_t* extra       = nullptr;
+        TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bits);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &samples);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &planar);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLEFORMAT, &sampleFormat);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_ORIENTATION, &orientation);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_EXTRASAMPLES, &extraCount, &extra);
+
+        if ((bits != 8 && bits != 16) || planar != PLANARCONFIG_CONTIG
+            || sampleFormat != SAMPLEFORMAT_UINT || orientation != ORIENTATION_TOPLEFT
+            || extraCount > 1)
+        {
+            return false;
+        }
+
+        const bool is16     = bits == 16;
+        const bool hasAlpha = extraCount == 1;
+        if (photometric == PHOTOMETRIC_MINISBLACK && samples == 1 + extraCount)
+        {
+            if (hasAlpha && is16)
+            {
+                return false;
+            }
+            layout.format     = hasAlpha ? ePixelFormat::LuminanceAlpha : ePixelFormat::Luminance;
+            layout.bpp        = hasAlpha ? 16 : 8;
+            layout.isNarrowed = is16;
+        }
+        else if (photometric == PHOTOMETRIC_RGB && samples == 3 + extraCount)
+        {
+            layout.format = hasAlpha
+                ? (is16 ? ePixelFormat::RGBA16 : ePixelFormat::RGBA)
+                : (is16 ? ePixelFormat::RGB16 : ePixelFormat::RGB);
+            layout.bpp    = samples * bits;
+        }
+        else
+        {
+            return false;
+        }
+
+        layout.srcBytes     = samples * bits / 8;
+        layout.isAssociated = hasAlpha && extra[0] == EXTRASAMPLE_ASSOCALPHA;
+        layout.isTiled      = TIFFIsTiled(tif) != 0;
+        if (layout.isTiled)
+        {
+            TIFFGetField(tif, TIFFTAG_TILEWIDTH, &layout.unitWidth);
+            TIFFGetField(tif, TIFFTAG_TILELENGTH, &layout.unitHeight);
+        }
+        else
+        {
+            uint32_t rowsPerStrip = height;
+            TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+            layout.unitHeight = std::min(rowsPerStrip, height);
+        }
+
+        return layout.unitHeight != 0 && (layout.isTiled == false || layout.unitWidth != 0);
+    }
+
+    void copyPixels(const uint8_t* src, uint8_t* dst, uint32_t count, const sTiffLayout& layout)
+    {
+        if (layout.isNarrowed)
+        {
+            auto samples = reinterpret_cast<const uint16_t*>(src);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<uint8_t>(samples[i] >> 8);
+            }
+        }
+        else
+        {
+            ::memcpy(dst, src, static_cast<size_t>(count) * layout.srcBytes);
+        }
+    }
+
+    // Grows a window of the level to whole tiles, or whole strips vertically.
+    void alignWindow(const sTiffLayout& layout, sImageInfo::Window& window)
+    {
+        auto align = [](uint32_t& pos, uint32_t& size, uint32_t unit, uint32_t limit) {
+            const uint32_t end = std::min(limit, (pos + size + unit - 1) / unit * unit);
+            pos                = pos / unit * unit;
+            size               = end - pos;
+        };
+
+        align(window.y, window.height, layout.unitHeight, window.levelHeight);
+        if (layout.isTiled)
+        {
+            align(window.x, window.width, layout.unitWidth, window.levelWidth);
+        }
+    }
+
+    // Decodes the strip or the row of tiles at level rows [top, bottom)
+    // into the window's part of them. Returns the strips or tiles read, the
+    // area of those that fail is cleared, as TIFFRGBAImage leaves it.
+    uint32_t readUnit(TIFF* tif, const sTiffLayout& layout, const sImageInfo::Window& window, uint32_t top, uint32_t bottom,
+                      Buffer& buffer, sChunkData& chunk)
+    {
+        const uint32_t dstBytes = chunk.bpp / 8;
+        if (layout.isTiled == false)
+        {
+            const auto strip = TIFFComputeStrip(tif, top, 0);
+            if (TIFFReadEncodedStrip(tif, strip, buffer.data(), static_cast<tmsize_t>(buffer.size())) < 0)
+            {
+                for (uint32_t y = top; y < bottom; y++)
+                {
+                    ::memset(chunk.rowPtr(y - window.y), 0, static_cast<size_t>(chunk.width) * dstBytes);
+                }
+                return 0;
+            }
+
+            const auto rowSize = static_cast<size_t>(TIFFScanlineSize(tif));
+            const auto left    = static_cast<size_t>(window.x) * layout.srcBytes;
+            for (uint32_t y = top; y < bottom; y++)
+            {
+                copyPixels(buffer.data() + (y - top) * rowSize + left, chunk.rowPtr(y - window.y), chunk.width, layout);
+            }
+            return 1;
+        }
+
+        uint32_t read      = 0;
+        const auto rowSize = static_cast<size_t>(TIFFTileRowSize(tif));
+        for (uint32_t x = 0; x < chunk.width; x += layout.unitWidth)
+        {
+            const uint32_t count = std::min(layout.unitWidth, chunk.width - x);
+            const auto tile      = TIFFComputeTile(tif, window.x + x, top, 0, 0);
+            if (TIFFReadEncodedTile(tif, tile, buffer.data(), static_cast<tmsize_t>(buffer.size())) < 0)
+            {
+                for (uint32_t y = top; y < bottom; y++)
+                {
+                    ::memset(chunk.rowPtr(y - window.y) + x * dstBytes, 0, static_cast<size_t>(count) * dstBytes);
+                }
+                continue;
+            }
+
+            for (uint32_t y = top; y < bottom; y++)
+            {
+                copyPixels(buffer.data() + (y - top) * rowSize, chunk.rowPtr(y - window.y) + x * dstBytes, count, layout);
+            }
+            read++;
+        }
+        return read;
+    }
+
 } // namespace
 
 bool cFormatTiff::isSupported(cFile& file, Buffer& buffer) const
@@ -44,15 +344,49 @@ bool cFormatTiff::isSupported(cFile& file, Buffer& buffer) const
     const auto h = buffer.data();
     const uint8_t le[4] = { 0x49, 0x49, 0x2A, 0x00 };
     const uint8_t be[4] = { 0x4D, 0x4D, 0x00, 0x2A };
-    return !::memcmp(h, le, sizeof(le)) || !::memcmp(h, be, sizeof(be));
+    const uint8_t bigLe[4] = { 0x49, 0x49, 0x2B, 0x00 };
+    const uint8_t bigBe[4] = { 0x4D, 0x4D, 0x00, 0x2B };
+    return !::memcmp(h, le, sizeof(le)) || !::memcmp(h, be, sizeof(be))
+        || !::memcmp(h, bigLe, sizeof(bigLe)) || !::memcmp(h, bigBe, sizeof(bigBe));
 }
 
 bool cFormatTiff::LoadImpl(const char* filename, sChunkData& chunk, sImageInfo& info)
 {
     m_filename = filename;
+    m_pages.clear();
     return load(0, chunk, info);
 }
 
+void cFormatTiff::findPages(void* handle)
+{
+    auto tif           = static_cast<TIFF*>(handle);
+    const auto numDirs = TIFFNumberOfDirectories(tif);
+
+    // Reduced-resolution directories that belong to a page's pyramid are
+    // read through it, they aren't pages of their own.
+    std::vector<uint8_t> isLevel(numDirs, 0);
+    std::vector<sTiffLevel> levels;
+    for (uint32_t dir = 0; dir < numDirs; dir++)
+    {
+        if (isLevel[dir] != 0 || TIFFSetDirectory(tif, dir) == 0)
+        {
+            continue;
+        }
+
+        m_pages.push_back(static_cast<uint16_t>(dir));
+
+        levels.clear();
+        findLevels(tif, static_cast<uint16_t>(dir), levels);
+        for (const auto& level : levels)
+        {
+            if (level.subDirectory == 0 && level.directory != dir)
+            {
+                isLevel[level.directory] = 1;
+            }
+        }
+    }
+}
+
 bool cFormatTiff::LoadSubImageImpl(uint32_t current, sChunkData& chunk, sImageInfo& info)
 {
     return load(current, chunk, info);
@@ -148,39 +482,102 @@ bool cFormatTiff::load(uint32_t current, sChunkData& chunk, sImageInfo& info)
     if (tif != nullptr)
     {
         // read count of pages in image
-        info.images = TIFFNumberOfDirectories(tif);
+        if (m_pages.empty())
+        {
+            findPages(tif);
+        }
+        info.images  = std::max<uint32_t>(1, static_cast<uint32_t>(m_pages.size()));
         info.current = std::min(current, info.images - 1);
 
         // set desired page
-        if (TIFFSetDirectory(tif, info.current) != 0)
+        const uint16_t directory = m_pages.empty() ? 0 : m_pages[info.current];
+        if (TIFFSetDirectory(tif, directory) != 0)
         {
+            // Pyramids are read at the level the target size needs, the
+            // coarse one is the preview then. Levels too large to hold are
+            // read a window at a time for the view.
+            std::vector<sTiffLevel> levels;
+            findLevels(tif, directory, levels);
+            auto index = pickLevel(levels, m_targetWidth, m_targetHeight);
+
+            const bool isWindow = levels.size() > 1 && m_targetWindow.width != 0 && m_targetWindow.height != 0;
+            if (isWindow == false)
+            {
+                while (index + 1 < levels.size()
+                       && std::max(levels[index].width, levels[index].height) > MaxLevelSize)
+                {
+                    index++;
+                }
+            }
+            const auto& level = levels[index];
+            const auto& full  = levels.front();
+
+            info.levels.clear();
+            if (levels.size() > 1)
+            {
+                for (const auto& l : levels)
+                {
+                    info.levels.push_back({ l.width, l.height });
+                }
+            }
+            info.fullWidth  = (&level != &full || isWindow) ? full.width : 0;
+            info.fullHeight = (&level != &full || isWindow) ? full.height : 0;
+            info.window     = {};
+            chunk.effects   = eEffect::None;
+
+            sImageInfo::Window window;
+            window.levelWidth  = level.width;
+            window.levelHeight = level.height;
+            if (isWindow)
+            {
+                window.x      = std::min(m_targetWindow.x, level.width - 1);
+                window.y      = std::min(m_targetWindow.y, level.height - 1);
+                window.width  = std::min(m_targetWindow.width, level.width - window.x);
+                window.height = std::min(m_targetWindow.height, level.height - window.y);
+            }
+            else
+            {
+                window.width  = level.width;
+                window.height = level.height;
+            }
+
+            // Levels usually don't repeat the page's profile.
+            Buffer iccProfile;
+            uint32_t iccProfileSize = 0;
+            void* iccData = nullptr;
+            if (TIFFGetField(tif, TIFFTAG_ICCPROFILE, &iccProfileSize, &iccData) != 0
+                && iccProfileSize > 0 && iccData != nullptr)
+            {
+                auto data = static_cast<const uint8_t*>(iccData);
+                iccProfile.assign(data, data + iccProfileSize);
+            }
+            const bool hasIccProfile = iccProfile.empty() == false;
+
             TIFFRGBAImage img;
             char emsg[1024];
-            if (TIFFRGBAImageBegin(&img, tif, 0, emsg) != 0)
+            if (setLevel(tif, level) && TIFFRGBAImageBegin(&img, tif, 0, emsg) != 0)
             {
                 chunk.width = img.width;
                 chunk.height = img.height;
                 info.bppImage = img.bitspersample * img.samplesperpixel;
 
                 TIFFRGBAImageEnd(&img);
-                decodePreview(tif, chunk.width, chunk.height, info.current);
+                if (levels.size() == 1)
+                {
+                    decodePreview(tif, chunk.width, chunk.height, directory);
+                }
 
                 // Re-open the image after preview scan may have changed directory
-                if (TIFFSetDirectory(tif, info.current) == 0
+                if (setLevel(tif, level) == false
                     || TIFFRGBAImageBegin(&img, tif, 0, emsg) == 0)
                 {
                     TIFFClose(tif);
                     return false;
                 }
 
-                // Read ICC data after directory is restored — TIFFGetField
+                // Read ICC tables after directory is restored — TIFFGetField
                 // returns pointers into TIFF's internal memory that are only
                 // valid for the current directory.
-                uint32_t iccProfileSize = 0;
-                void* iccProfile = nullptr;
-                bool hasIccProfile = TIFFGetField(tif, TIFFTAG_ICCPROFILE, &iccProfileSize, &iccProfile) != 0
-                    && iccProfileSize > 0 && iccProfile != nullptr;
-
                 float* chr = nullptr;
                 float* wp = nullptr;
                 uint16_t* gmr = nullptr;
@@ -197,9 +594,43 @@ bool cFormatTiff::load(uint32_t current, sChunkData& chunk, sImageInfo& info)
                     }
                 }
 
+                sTiffLayout layout;
+                if (getNativeLayout(tif, chunk.height, layout))
+                {
+                    TIFFRGBAImageEnd(&img);
+
+                    // Whole tiles are read anyway, the window keeps them.
+                    alignWindow(layout, window);
+                    chunk.width  = window.width;
+                    chunk.height = window.height;
+                    if (isWindow)
+                    {
+                        info.window = window;
+                    }
+
+                    // The LUT is sampled for the bitmap's format.
+                    chunk.format     = layout.format;
+                    const bool isIcc = hasIccProfile
+                        ? applyIccProfile(chunk, iccProfile.data(), static_cast<uint32_t>(iccProfile.size()))
+                        : hasIccTables && applyIccProfile(chunk, chr, wp, gmr, gmg, gmb);
+                    info.formatName = isIcc ? "tiff/icc" : "tiff";
+
+                    result = loadNative(layout, level, window, chunk);
+                    TIFFClose(tif);
+                    return result;
+                }
+
+                chunk.width  = window.width;
+                chunk.height = window.height;
+                if (isWindow)
+                {
+                    info.window = window;
+                }
                 setupBitmap(chunk, info, 32, ePixelFormat::RGBA, "tiff");
 
                 img.req_orientation = ORIENTATION_TOPLEFT;
+                img.col_offset      = static_cast<int>(window.x);
+                img.row_offset      = static_cast<int>(window.y);
 
                 auto bitmap = chunk.bitmap.data();
                 result = TIFFRGBAImageGet(&img, reinterpret_cast<uint32_t*>(bitmap), chunk.width, chunk.height) != 0;
@@ -209,7 +640,7 @@ bool cFormatTiff::load(uint32_t current, sChunkData& chunk, sImageInfo& info)
                     bool iccApplied = false;
                     if (hasIccProfile)
                     {
-                        iccApplied = applyIccProfile(chunk, iccProfile, iccProfileSize);
+                        iccApplied = applyIccProfile(chunk, iccProfile.data(), static_cast<uint32_t>(iccProfile.size()));
                     }
                     else if (hasIccTables)
                     {
@@ -235,4 +666,96 @@ bool cFormatTiff::load(uint32_t current, sChunkData& chunk, sImageInfo& info)
     return result;
 }
 
+bool cFormatTiff::loadNative(const sTiffLayout& layout, const sTiffLevel& level, const sImageInfo::Window& window, sChunkData& chunk)
+{
+    constexpr uint32_t BandRows = 8192;
+
+    auto& pool             = cThreadPool::shared();
+    const uint32_t units   = (chunk.height + layout.unitHeight - 1) / layout.unitHeight;
+    const uint32_t workers = std::min(pool.getThreadsCount() + 1, units);
+
+    // Every worker's unit fits into the ring at the same time.
+    chunk.allocate(chunk.width, chunk.height, layout.bpp, layout.format,
+                   std::max(BandRows, layout.unitHeight * (workers + 1)));
+    if (layout.isAssociated)
+    {
+        chunk.effects |= eEffect::Unpremultiply;
+    }
+    signalBitmapAllocated();
+
+    // Units finish out of order, rows are ready up to the first one still
+    // decoding. Units are taken in order, so that one always runs and the
+    // ring keeps draining. Like TIFFRGBAImage without stoponerr, a unit that
+    // can't be read is left blank and the rest of the page still shows.
+    std::mutex mutex;
+    std::vector<uint8_t> done(units, 0);
+    uint32_t prefix = 0;
+    auto complete   = [&](uint32_t unit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        done[unit] = 1;
+        const auto before = prefix;
+        while (prefix < units && done[prefix] != 0)
+        {
+            prefix++;
+        }
+        if (prefix != before)
+        {
+            signalRowsReady(std::min(prefix * layout.unitHeight, chunk.height));
+        }
+    };
+
+    const uint32_t pieces = layout.isTiled ? (chunk.width + layout.unitWidth - 1) / layout.unitWidth : 1;
+    std::atomic<uint32_t> next{ 0 };
+    std::atomic<uint32_t> read{ 0 };
+    pool.parallelFor(0, workers, [&](uint32_t) {
+        // Units are claimed, the workers that did open the file take them all.
+        auto tif = TIFFOpen(m_filename.c_str(), "r");
+        if (tif == nullptr || setLevel(tif, level) == false)
+        {
+            if (tif != nullptr)
+            {
+                TIFFClose(tif);
+            }
+            return;
+        }
+
+        Buffer buffer(static_cast<size_t>(layout.isTiled ? TIFFTileSize(tif) : TIFFStripSize(tif)));
+        while (isStopped() == false)
+        {
+            const uint32_t unit = next.fetch_add(1, std::memory_order_relaxed);
+            if (unit >= units)
+            {
+                break;
+            }
+
+            // Level rows, the window starts on a unit.
+            const uint32_t top    = window.y + unit * layout.unitHeight;
+            const uint32_t bottom = std::min(top + layout.unitHeight, window.y + chunk.height);
+
+            // The ring must not overwrite rows the viewer hasn't consumed.
+            while (isStopped() == false
+                   && bottom - 1 - window.y - chunk.consumedHeight.load(std::memory_order_acquire) >= chunk.bandHeight)
+            {
+                std::this_thread::yield();
+            }
+
+            if (isStopped() == false)
+            {
+                const uint32_t count = readUnit(tif, layout, window, top, bottom, buffer, chunk);
+                if (count < pieces)
+                {
+                    cLog::Warning("TIFF: {} of {} {} in rows {}-{} unreadable.", pieces - count, pieces,
+                                  layout.isTiled ? "tiles" : "strip", top, bottom - 1);
+                }
+                read.fetch_add(count, std::memory_order_relaxed);
+            }
+            complete(unit);
+        }
+
+        TIFFClose(tif);
+    });
+
+    return isStopped() == false && read.load(std::memory_order_relaxed) != 0;
+}
+
 #endif
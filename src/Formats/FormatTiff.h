@@ -13,7 +13,12 @@
 
 #include "Format.h"
 
+#include <cstdint>
 #include <string>
+#include <vector>
+
+struct sTiffLayout;
+struct sTiffLevel;
 
 class cFormatTiff final : public cFormat
 {
@@ -27,11 +32,16 @@ private:
     bool LoadSubImageImpl(uint32_t current, sChunkData& chunk, sImageInfo& info) override;
 
 private:
+    void findPages(void* tif);
     bool load(uint32_t current, sChunkData& chunk, sImageInfo& info);
+    // Strips or tiles of the window in their own sample layout, decoded in
+    // parallel with a TIFF handle per worker.
+    bool loadNative(const sTiffLayout& layout, const sTiffLevel& level, const sImageInfo::Window& window, sChunkData& chunk);
     void decodePreview(void* tif, uint32_t fullWidth, uint32_t fullHeight, unsigned current);
 
 private:
     std::string m_filename;
+    std::vector<uint16_t> m_pages; // directories shown as pages, not levels of another one
 };
 
 #endif
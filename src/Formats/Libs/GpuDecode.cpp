@@ -8,10 +8,16 @@
 \**********************************************/
 
 #include "GpuDecode.h"
+#include "GpuDecodeSimd.h"
+#include "Common/StopToken.h"
+#include "Common/ThreadPool.h"
 
 #include <algorithm>
 #include <astcenc/astcenc.h>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace
 {
@@ -125,26 +131,60 @@ namespace
     // BC7 decoder
     // -------------------------------------------------------------------------
 
+    // The whole 128-bit block is held in two registers and consumed from the
+    // low end, BC7 fields are at most 8 bits wide.
     struct BitReader
     {
-        const uint8_t* data;
-        int pos;
+        uint64_t lo;
+        uint64_t hi;
+
+        explicit BitReader(const uint8_t* data)
+            : lo(0)
+            , hi(0)
+        {
+            for (int i = 7; i >= 0; i--)
+            {
+                lo = (lo << 8) | data[i];
+                hi = (hi << 8) | data[i + 8];
+            }
+        }
 
         uint32_t read(int bits)
         {
-            uint32_t val = 0;
-            for (int i = 0; i < bits; i++)
+            if (bits == 0)
             {
-                int byteIdx = pos >> 3;
-                int bitIdx = pos & 7;
-                val |= ((data[byteIdx] >> bitIdx) & 1) << i;
-                pos++;
+                return 0;
             }
+
+            const uint32_t val = static_cast<uint32_t>(lo & ((1u << bits) - 1));
+            skip(bits);
             return val;
         }
+
+        // One index set is at most 63 bits in every mode, so it is sliced
+        // out of the low register without a dependency between reads.
+        void readIndices(int bits, uint32_t anchors, uint8_t indices[16])
+        {
+            int offset = 0;
+            for (int i = 0; i < 16; i++)
+            {
+                const int width = bits - static_cast<int>((anchors >> i) & 1);
+                indices[i] = static_cast<uint8_t>((lo >> offset) & ((1u << width) - 1));
+                offset += width;
+            }
+            skip(offset);
+        }
+
+        void skip(int bits)
+        {
+            lo = (lo >> bits) | (hi << (64 - bits));
+            hi >>= bits;
+        }
     };
 
-    constexpr int Bc7Partitions2[64][16] = {
+    constexpr uint8_t Bc7NoPartition[16] = {};
+
+    constexpr uint8_t Bc7Partitions2[64][16] = {
         { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1 },
         { 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1 },
         { 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1 },
@@ -211,7 +251,7 @@ namespace
         { 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 1, 1 },
     };
 
-    constexpr int Bc7Partitions3[64][16] = {
+    constexpr uint8_t Bc7Partitions3[64][16] = {
         { 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 },
         { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
         { 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
@@ -498,7 +538,7 @@ namespace
 
     void decodeBC7Block(const uint8_t* src, Rgba pixels[16])
     {
-        BitReader br = { src, 0 };
+        BitReader br(src);
 
         int mode = 0;
         while (mode < 8 && br.read(1) == 0)
@@ -584,30 +624,28 @@ namespace
         int ib1 = mi.ib;
         int ib2 = mi.ib2;
 
-        for (int i = 0; i < 16; i++)
+        // anchor texels store their index with one bit less
+        uint32_t anchors = 1;
+        const uint8_t* subsets = Bc7NoPartition;
+        if (mi.ns == 2)
         {
-            bool isAnchor = (i == 0);
-            if (mi.ns == 2)
-            {
-                isAnchor = isAnchor || (i == Bc7Anchor2[partition]);
-            }
-            else if (mi.ns == 3)
-            {
-                isAnchor = isAnchor || (i == Bc7Anchor3a[partition]) || (i == Bc7Anchor3b[partition]);
-            }
-            indices[i] = br.read(isAnchor ? ib1 - 1 : ib1);
+            anchors |= 1u << Bc7Anchor2[partition];
+            subsets = Bc7Partitions2[partition];
+        }
+        else if (mi.ns == 3)
+        {
+            anchors |= (1u << Bc7Anchor3a[partition]) | (1u << Bc7Anchor3b[partition]);
+            subsets = Bc7Partitions3[partition];
         }
 
+        br.readIndices(ib1, anchors, indices);
         if (ib2)
         {
-            for (int i = 0; i < 16; i++)
-            {
-                indices2[i] = br.read(i == 0 ? ib2 - 1 : ib2);
-            }
+            br.readIndices(ib2, 1, indices2);
         }
 
         // interpolate
-        auto getWeight = [](int bits, int index) -> uint8_t {
+        auto getWeights = [](int bits) -> const uint8_t* {
             static constexpr uint8_t Bc7Weights2[] = { 0, 21, 43, 64 };
             static constexpr uint8_t Bc7Weights3[] = { 0, 9, 18, 27, 37, 46, 55, 64 };
             static constexpr uint8_t Bc7Weights4[] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
@@ -615,53 +653,53 @@ namespace
             switch (bits)
             {
             case 2:
-                return Bc7Weights2[index];
+                return Bc7Weights2;
             case 3:
-                return Bc7Weights3[index];
-            case 4:
-                return Bc7Weights4[index];
+                return Bc7Weights3;
             }
 
-            return 0;
+            return Bc7Weights4;
         };
 
-        for (int i = 0; i < 16; i++)
+        const uint8_t* colorWeights = getWeights(ib1);
+        const uint8_t* alphaWeights = colorWeights;
+        const uint8_t* colorIndices = indices;
+        const uint8_t* alphaIndices = indices;
+        if (ib2)
         {
-            int subset = 0;
-            if (mi.ns == 2)
-            {
-                subset = Bc7Partitions2[partition][i];
-            }
-            else if (mi.ns == 3)
+            alphaWeights = getWeights(ib2);
+            alphaIndices = indices2;
+            if (idxSel)
             {
-                subset = Bc7Partitions3[partition][i];
+                std::swap(colorWeights, alphaWeights);
+                std::swap(colorIndices, alphaIndices);
             }
+        }
 
-            auto& e0 = endpoints[subset * 2];
-            auto& e1 = endpoints[subset * 2 + 1];
+        // Gather per-texel endpoints and weights, then interpolate all 16
+        // texels in one vector pass.
+        alignas(16) uint8_t e0[64];
+        alignas(16) uint8_t e1[64];
+        alignas(16) uint8_t weights[64];
 
-            uint8_t cw, aw;
-            if (ib2 == 0)
-            {
-                cw = aw = getWeight(ib1, indices[i]);
-            }
-            else if (idxSel == 0)
-            {
-                cw = getWeight(ib1, indices[i]);
-                aw = getWeight(ib2, indices2[i]);
-            }
-            else
-            {
-                aw = getWeight(ib1, indices[i]);
-                cw = getWeight(ib2, indices2[i]);
-            }
+        for (int i = 0; i < 16; i++)
+        {
+            const int subset = subsets[i];
+            ::memcpy(&e0[i * 4], endpoints[subset * 2], 4);
+            ::memcpy(&e1[i * 4], endpoints[subset * 2 + 1], 4);
+
+            const uint8_t cw = colorWeights[colorIndices[i]];
+            weights[i * 4 + 0] = cw;
+            weights[i * 4 + 1] = cw;
+            weights[i * 4 + 2] = cw;
+            weights[i * 4 + 3] = alphaWeights[alphaIndices[i]];
+        }
 
-            pixels[i].r = static_cast<uint8_t>(((64 - cw) * e0[0] + cw * e1[0] + 32) >> 6);
-            pixels[i].g = static_cast<uint8_t>(((64 - cw) * e0[1] + cw * e1[1] + 32) >> 6);
-            pixels[i].b = static_cast<uint8_t>(((64 - cw) * e0[2] + cw * e1[2] + 32) >> 6);
-            pixels[i].a = static_cast<uint8_t>(((64 - aw) * e0[3] + aw * e1[3] + 32) >> 6);
+        gpu_simd::getKernels().lerp64(e0, e1, weights, reinterpret_cast<uint8_t*>(pixels));
 
-            if (rotation)
+        if (rotation)
+        {
+            for (int i = 0; i < 16; i++)
             {
                 if (rotation == 1)
                     std::swap(pixels[i].a, pixels[i].r);
@@ -913,15 +951,189 @@ namespace
         table[0] = (block >> 37) & 7;
         table[1] = (block >> 34) & 7;
 
+        int16_t mods[8];
+        for (int sub = 0; sub < 2; sub++)
+        {
+            mods[sub * 4 + 0] = static_cast<int16_t>(Etc2Modifier[table[sub]][0]);
+            mods[sub * 4 + 1] = static_cast<int16_t>(-Etc2Modifier[table[sub]][0]);
+            mods[sub * 4 + 2] = static_cast<int16_t>(Etc2Modifier[table[sub]][1]);
+            mods[sub * 4 + 3] = static_cast<int16_t>(-Etc2Modifier[table[sub]][1]);
+        }
+
+        const uint8_t base[2][3] = {
+            { static_cast<uint8_t>(baseR[0]), static_cast<uint8_t>(baseG[0]), static_cast<uint8_t>(baseB[0]) },
+            { static_cast<uint8_t>(baseR[1]), static_cast<uint8_t>(baseG[1]), static_cast<uint8_t>(baseB[1]) },
+        };
+
+        const uint16_t msb = static_cast<uint16_t>((src[4] << 8) | src[5]);
+        const uint16_t lsb = static_cast<uint16_t>((src[6] << 8) | src[7]);
+        gpu_simd::getKernels().etcTexels(msb, lsb, flipBit, base, mods, reinterpret_cast<uint8_t*>(pixels));
+    }
+
+    // -------------------------------------------------------------------------
+    // Per-block wrappers for the composite formats
+    // -------------------------------------------------------------------------
+
+    void decodeBC2Block(const uint8_t* src, Rgba pixels[16])
+    {
+        // First 8 bytes: explicit 4-bit alpha for each pixel
+        decodeBC1Block(src + 8, pixels);
+        for (int i = 0; i < 16; i++)
+        {
+            uint8_t a4 = (src[i / 2] >> ((i & 1) * 4)) & 0x0f;
+            pixels[i].a = static_cast<uint8_t>(a4 | (a4 << 4));
+        }
+    }
+
+    void decodeBC3Block(const uint8_t* src, Rgba pixels[16])
+    {
+        uint8_t alphas[16];
+        decodeBC3Alpha(src, alphas);
+        decodeBC1Block(src + 8, pixels);
+        for (int i = 0; i < 16; i++)
+        {
+            pixels[i].a = alphas[i];
+        }
+    }
+
+    void decodeBC4Block(const uint8_t* src, Rgba pixels[16])
+    {
+        uint8_t values[16];
+        decodeBC3Alpha(src, values);
+        for (int i = 0; i < 16; i++)
+        {
+            pixels[i] = { values[i], 0, 0, 255 };
+        }
+    }
+
+    void decodeBC5Block(const uint8_t* src, Rgba pixels[16])
+    {
+        uint8_t red[16];
+        decodeBC3Alpha(src, red);
+        uint8_t green[16];
+        decodeBC3Alpha(src + 8, green);
+        for (int i = 0; i < 16; i++)
+        {
+            pixels[i] = { red[i], green[i], 0, 255 };
+        }
+    }
+
+    void decodeETC2Block_RGBA(const uint8_t* src, Rgba pixels[16])
+    {
+        // first 8 bytes: EAC alpha block, next 8 bytes: ETC2 RGB block
+        uint8_t alphas[16];
+        decodeEACAlpha(src, alphas);
+        decodeETC2Block_RGB(src + 8, pixels);
+        for (int i = 0; i < 16; i++)
+        {
+            pixels[i].a = alphas[i];
+        }
+    }
+
+    void decodeETC2Block_RGBA1(const uint8_t* src, Rgba pixels[16])
+    {
+        // ETC2 punchthrough alpha uses the same 8-byte block as ETC2 RGB
+        // but the diff bit signals opaque vs punchthrough mode.
+        // When c0 <= c1 in the individual/differential path, index 2 = transparent black.
+        uint64_t block = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            block = (block << 8) | src[i];
+        }
+
+        bool diffBit = (block >> 33) & 1;
+        bool flipBit = (block >> 32) & 1;
+
+        int baseR[2], baseG[2], baseB[2];
+
+        bool tMode = false;
+        bool hMode = false;
+        bool planar = false;
+
+        if (diffBit)
+        {
+            int r = (block >> 59) & 0x1f;
+            int dr = (block >> 56) & 0x07;
+            if (dr >= 4)
+                dr -= 8;
+            int rr = r + dr;
+            if (rr < 0 || rr > 31)
+            {
+                tMode = true;
+            }
+
+            int g = (block >> 51) & 0x1f;
+            int dg = (block >> 48) & 0x07;
+            if (dg >= 4)
+                dg -= 8;
+            int gg = g + dg;
+            if (!tMode && (gg < 0 || gg > 31))
+            {
+                hMode = true;
+            }
+
+            int b = (block >> 43) & 0x1f;
+            int db = (block >> 40) & 0x07;
+            if (db >= 4)
+                db -= 8;
+            int bb = b + db;
+            if (!tMode && !hMode && (bb < 0 || bb > 31))
+            {
+                planar = true;
+            }
+
+            if (!tMode && !hMode && !planar)
+            {
+                baseR[0] = (r << 3) | (r >> 2);
+                baseG[0] = (g << 3) | (g >> 2);
+                baseB[0] = (b << 3) | (b >> 2);
+                baseR[1] = (rr << 3) | (rr >> 2);
+                baseG[1] = (gg << 3) | (gg >> 2);
+                baseB[1] = (bb << 3) | (bb >> 2);
+            }
+        }
+        else
+        {
+            // Non-differential: always opaque in punchthrough (spec says diffbit=0 is invalid
+            // for punchthrough, but we handle it gracefully as opaque)
+            baseR[0] = ((block >> 60) & 0xf) * 17;
+            baseG[0] = ((block >> 52) & 0xf) * 17;
+            baseB[0] = ((block >> 44) & 0xf) * 17;
+            baseR[1] = ((block >> 56) & 0xf) * 17;
+            baseG[1] = ((block >> 48) & 0xf) * 17;
+            baseB[1] = ((block >> 40) & 0xf) * 17;
+        }
+
+        // For T/H/planar modes, delegate to the RGB decoder (always opaque alpha)
+        if (tMode || hMode || planar)
+        {
+            decodeETC2Block_RGB(src, pixels);
+            return;
+        }
+
+        // Individual/differential mode with punchthrough
+        int table[2];
+        table[0] = (block >> 37) & 7;
+        table[1] = (block >> 34) & 7;
+
         for (int i = 0; i < 16; i++)
         {
             int col = i >> 2, row = i & 3;
-            int sub = flipBit ? (row >= 2 ? 1 : 0) : (col >= 2 ? 1 : 0);
+            int sub = flipBit
+                ? (row >= 2 ? 1 : 0)
+                : (col >= 2 ? 1 : 0);
             int bitIdx = col * 4 + row;
             int msb = (src[4 + (bitIdx >> 3)] >> (7 - (bitIdx & 7))) & 1;
             int lsb = (src[4 + ((bitIdx + 16) >> 3)] >> (7 - ((bitIdx + 16) & 7))) & 1;
             int idx = msb | (lsb << 1);
 
+            // In punchthrough mode, index 2 (msb=0, lsb=1) = transparent black
+            if (idx == 2)
+            {
+                pixels[row * 4 + col] = { 0, 0, 0, 0 };
+                continue;
+            }
+
             int mod = 0;
             switch (idx)
             {
@@ -931,9 +1143,6 @@ namespace
             case 1:
                 mod = -Etc2Modifier[table[sub]][0];
                 break;
-            case 2:
-                mod = Etc2Modifier[table[sub]][1];
-                break;
             case 3:
                 mod = -Etc2Modifier[table[sub]][1];
                 break;
@@ -948,474 +1157,388 @@ namespace
         }
     }
 
-} // namespace
-
-namespace gpu_decode
-{
-
-    void decodeBC1(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
+    void decodeEACBlock_R11(const uint8_t* src, Rgba pixels[16])
     {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
-
-        for (uint32_t by = 0; by < blocksH; by++)
+        uint8_t values[16];
+        decodeEACAlpha(src, values);
+        for (int i = 0; i < 16; i++)
         {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
-            {
-                Rgba pixels[16];
-                decodeBC1Block(src, pixels);
-                src += 8;
-
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, pixels[py * 4 + px]);
-                    }
-                }
-            }
+            pixels[i] = { values[i], values[i], values[i], 255 };
         }
     }
 
-    void decodeBC2(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
+    void decodeEACBlock_RG11(const uint8_t* src, Rgba pixels[16])
     {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
-
-        for (uint32_t by = 0; by < blocksH; by++)
+        uint8_t red[16];
+        decodeEACAlpha(src, red);
+        uint8_t green[16];
+        decodeEACAlpha(src + 8, green);
+        for (int i = 0; i < 16; i++)
         {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
-            {
-                // First 8 bytes: explicit 4-bit alpha for each pixel
-                const uint8_t* alphaBlock = src;
-
-                Rgba pixels[16];
-                decodeBC1Block(src + 8, pixels);
-                src += 16;
-
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        int i = py * 4 + px;
-                        int byteIdx = i / 2;
-                        int shift = (i & 1) * 4;
-                        uint8_t a4 = (alphaBlock[byteIdx] >> shift) & 0x0f;
-                        pixels[i].a = static_cast<uint8_t>(a4 | (a4 << 4));
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, pixels[i]);
-                    }
-                }
-            }
+            pixels[i] = { red[i], green[i], 0, 255 };
         }
     }
 
-    void decodeBC3(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
-    {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
+    // -------------------------------------------------------------------------
+    // Strip-parallel driver
+    // -------------------------------------------------------------------------
+
+    constexpr uint32_t StripBlockRows = 16; // 64 pixel rows per pool task
 
-        for (uint32_t by = 0; by < blocksH; by++)
+    void storeBlock(uint8_t* dst, uint32_t bx, uint32_t by, uint32_t width, uint32_t height, const Rgba pixels[16])
+    {
+        const uint32_t x = bx * 4;
+        const uint32_t y = by * 4;
+        if (x + 4 <= width && y + 4 <= height)
         {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
+            // Interior block: four 16-byte row copies, no per-pixel clamping.
+            const size_t stride = static_cast<size_t>(width) * 4;
+            auto row            = dst + static_cast<size_t>(y) * stride + x * 4;
+            for (uint32_t py = 0; py < 4; py++, row += stride)
             {
-                uint8_t alphas[16];
-                decodeBC3Alpha(src, alphas);
-
-                Rgba pixels[16];
-                decodeBC1Block(src + 8, pixels);
-                src += 16;
-
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        int i = py * 4 + px;
-                        pixels[i].a = alphas[i];
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, pixels[i]);
-                    }
-                }
+                ::memcpy(row, &pixels[py * 4], 16);
             }
         }
-    }
-
-    void decodeBC4(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
-    {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
-
-        for (uint32_t by = 0; by < blocksH; by++)
+        else
         {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
+            for (uint32_t py = 0; py < 4; py++)
             {
-                uint8_t values[16];
-                decodeBC3Alpha(src, values);
-                src += 8;
-
-                for (int py = 0; py < 4; py++)
+                for (uint32_t px = 0; px < 4; px++)
                 {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        int i = py * 4 + px;
-                        Rgba c = { values[i], 0, 0, 255 };
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, c);
-                    }
+                    writePixel(dst, x + px, y + py, width, height, pixels[py * 4 + px]);
                 }
             }
         }
     }
 
-    void decodeBC5(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
+    // Completed strips may finish out of order, only the contiguous prefix
+    // from the top is reported as ready.
+    class cStripTracker final
     {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
+    public:
+        cStripTracker(uint32_t strips, uint32_t height, const gpu_decode::Stream& stream)
+            : m_done(strips, 0)
+            , m_height(height)
+            , m_stream(stream)
+        {
+        }
 
-        for (uint32_t by = 0; by < blocksH; by++)
+        void complete(uint32_t strip)
         {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
+            if (m_stream.onRowsReady == nullptr)
             {
-                uint8_t red[16];
-                decodeBC3Alpha(src, red);
-                uint8_t green[16];
-                decodeBC3Alpha(src + 8, green);
-                src += 16;
+                return;
+            }
 
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        int i = py * 4 + px;
-                        Rgba c = { red[i], green[i], 0, 255 };
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, c);
-                    }
-                }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done[strip]     = 1;
+            const auto before = m_prefix;
+            while (m_prefix < m_done.size() && m_done[m_prefix] != 0)
+            {
+                m_prefix++;
+            }
+            if (m_prefix != before)
+            {
+                m_stream.onRowsReady(std::min(m_prefix * StripBlockRows * 4, m_height));
             }
         }
-    }
 
-    void decodeBC7(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
+    private:
+        std::mutex m_mutex;
+        std::vector<uint8_t> m_done;
+        uint32_t m_prefix = 0;
+        const uint32_t m_height;
+        const gpu_decode::Stream& m_stream;
+    };
+
+    template <uint32_t BlockBytes, typename BlockDecoder>
+    void decodeBlocks(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height,
+                      const gpu_decode::Stream& stream, BlockDecoder decodeBlock)
     {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
+        const uint32_t blocksW = (width + 3) / 4;
+        const uint32_t blocksH = (height + 3) / 4;
+        const uint32_t strips  = (blocksH + StripBlockRows - 1) / StripBlockRows;
 
-        for (uint32_t by = 0; by < blocksH; by++)
-        {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
+        cStripTracker tracker(strips, height, stream);
+
+        cThreadPool::shared().parallelFor(0, strips, [&](uint32_t strip) {
+            if (stream.stop != nullptr && stream.stop->isRequested())
             {
-                Rgba pixels[16];
-                decodeBC7Block(src, pixels);
-                src += 16;
+                return;
+            }
 
-                for (int py = 0; py < 4; py++)
+            const uint32_t byBegin = strip * StripBlockRows;
+            const uint32_t byEnd   = std::min(byBegin + StripBlockRows, blocksH);
+
+            auto block = src + static_cast<size_t>(byBegin) * blocksW * BlockBytes;
+            for (uint32_t by = byBegin; by < byEnd; by++)
+            {
+                for (uint32_t bx = 0; bx < blocksW; bx++)
                 {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, pixels[py * 4 + px]);
-                    }
+                    Rgba pixels[16];
+                    decodeBlock(block, pixels);
+                    block += BlockBytes;
+
+                    storeBlock(dst, bx, by, width, height, pixels);
                 }
             }
-        }
+
+            tracker.complete(strip);
+        });
     }
 
-    void decodeETC2_RGB(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
-    {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
+    // -------------------------------------------------------------------------
+    // ASTC contexts
+    // -------------------------------------------------------------------------
 
-        for (uint32_t by = 0; by < blocksH; by++)
+    // A context carries ~15 MB of block size tables, so one per block size
+    // and profile is built on first use and kept for the process lifetime.
+    // Each image is decoded under the context lock; within a strip the pool
+    // threads pull blocks from the context as astcenc thread indices.
+    struct AstcContext
+    {
+        uint32_t blockW;
+        uint32_t blockH;
+        astcenc_profile profile;
+        uint32_t threads;
+        astcenc_context* context;
+        std::mutex mutex;
+
+        ~AstcContext()
         {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
-            {
-                Rgba pixels[16];
-                decodeETC2Block_RGB(src, pixels);
-                src += 8;
-
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, pixels[py * 4 + px]);
-                    }
-                }
-            }
+            astcenc_context_free(context);
         }
-    }
+    };
 
-    void decodeETC2_RGBA(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
+    std::mutex AstcContextsMutex;
+    std::vector<std::unique_ptr<AstcContext>> AstcContexts;
+
+    AstcContext* getAstcContext(uint32_t blockW, uint32_t blockH, astcenc_profile profile)
     {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
+        std::lock_guard<std::mutex> lock(AstcContextsMutex);
 
-        for (uint32_t by = 0; by < blocksH; by++)
+        for (auto& astc : AstcContexts)
         {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
+            if (astc->blockW == blockW && astc->blockH == blockH && astc->profile == profile)
             {
-                // first 8 bytes: EAC alpha block
-                uint8_t alphas[16];
-                decodeEACAlpha(src, alphas);
-
-                // next 8 bytes: ETC2 RGB block
-                Rgba pixels[16];
-                decodeETC2Block_RGB(src + 8, pixels);
-                src += 16;
-
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        int i = py * 4 + px;
-                        pixels[i].a = alphas[i];
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, pixels[i]);
-                    }
-                }
+                return astc.get();
             }
         }
-    }
 
-    void decodeETC2_RGBA1(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
-    {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
+        astcenc_config config{};
+        astcenc_error status = astcenc_config_init(
+            profile, blockW, blockH, 1,
+            ASTCENC_PRE_FASTEST, ASTCENC_FLG_DECOMPRESS_ONLY, &config);
+        if (status != ASTCENC_SUCCESS)
+        {
+            return nullptr;
+        }
 
-        for (uint32_t by = 0; by < blocksH; by++)
+        // Pool workers plus the calling thread.
+        const uint32_t threads   = cThreadPool::shared().getThreadsCount() + 1;
+        astcenc_context* context = nullptr;
+        status = astcenc_context_alloc(&config, threads, &context);
+        if (status != ASTCENC_SUCCESS)
         {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
-            {
-                // ETC2 punchthrough alpha uses the same 8-byte block as ETC2 RGB
-                // but the diff bit signals opaque vs punchthrough mode.
-                // When c0 <= c1 in the individual/differential path, index 2 = transparent black.
-                uint64_t block = 0;
-                for (int i = 0; i < 8; i++)
-                {
-                    block = (block << 8) | src[i];
-                }
+            return nullptr;
+        }
 
-                bool diffBit = (block >> 33) & 1;
-                bool flipBit = (block >> 32) & 1;
+        auto astc     = std::make_unique<AstcContext>();
+        astc->blockW  = blockW;
+        astc->blockH  = blockH;
+        astc->profile = profile;
+        astc->threads = threads;
+        astc->context = context;
+        AstcContexts.push_back(std::move(astc));
 
-                int baseR[2], baseG[2], baseB[2];
+        return AstcContexts.back().get();
+    }
 
-                bool tMode = false;
-                bool hMode = false;
-                bool planar = false;
+} // namespace
 
-                if (diffBit)
-                {
-                    int r = (block >> 59) & 0x1f;
-                    int dr = (block >> 56) & 0x07;
-                    if (dr >= 4)
-                        dr -= 8;
-                    int rr = r + dr;
-                    if (rr < 0 || rr > 31)
-                    {
-                        tMode = true;
-                    }
-
-                    int g = (block >> 51) & 0x1f;
-                    int dg = (block >> 48) & 0x07;
-                    if (dg >= 4)
-                        dg -= 8;
-                    int gg = g + dg;
-                    if (!tMode && (gg < 0 || gg > 31))
-                    {
-                        hMode = true;
-                    }
-
-                    int b = (block >> 43) & 0x1f;
-                    int db = (block >> 40) & 0x07;
-                    if (db >= 4)
-                        db -= 8;
-                    int bb = b + db;
-                    if (!tMode && !hMode && (bb < 0 || bb > 31))
-                    {
-                        planar = true;
-                    }
-
-                    if (!tMode && !hMode && !planar)
-                    {
-                        baseR[0] = (r << 3) | (r >> 2);
-                        baseG[0] = (g << 3) | (g >> 2);
-                        baseB[0] = (b << 3) | (b >> 2);
-                        baseR[1] = (rr << 3) | (rr >> 2);
-                        baseG[1] = (gg << 3) | (gg >> 2);
-                        baseB[1] = (bb << 3) | (bb >> 2);
-                    }
-                }
-                else
-                {
-                    // Non-differential: always opaque in punchthrough (spec says diffbit=0 is invalid
-                    // for punchthrough, but we handle it gracefully as opaque)
-                    baseR[0] = ((block >> 60) & 0xf) * 17;
-                    baseG[0] = ((block >> 52) & 0xf) * 17;
-                    baseB[0] = ((block >> 44) & 0xf) * 17;
-                    baseR[1] = ((block >> 56) & 0xf) * 17;
-                    baseG[1] = ((block >> 48) & 0xf) * 17;
-                    baseB[1] = ((block >> 40) & 0xf) * 17;
-                }
+namespace gpu_decode
+{
 
-                // For T/H/planar modes, delegate to the RGB decoder (always opaque alpha)
-                if (tMode || hMode || planar)
-                {
-                    Rgba pixels[16];
-                    decodeETC2Block_RGB(src, pixels);
-                    for (int py = 0; py < 4; py++)
-                    {
-                        for (int px = 0; px < 4; px++)
-                        {
-                            writePixel(dst, bx * 4 + px, by * 4 + py, width, height, pixels[py * 4 + px]);
-                        }
-                    }
-                    src += 8;
-                    continue;
-                }
+    void decodeBC1(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<8>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeBC1Block(block, pixels);
+        });
+    }
 
-                // Individual/differential mode with punchthrough
-                int table[2];
-                table[0] = (block >> 37) & 7;
-                table[1] = (block >> 34) & 7;
+    void decodeBC2(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<16>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeBC2Block(block, pixels);
+        });
+    }
 
-                Rgba pixels[16];
-                for (int i = 0; i < 16; i++)
-                {
-                    int col = i >> 2, row = i & 3;
-                    int sub = flipBit
-                        ? (row >= 2 ? 1 : 0)
-                        : (col >= 2 ? 1 : 0);
-                    int bitIdx = col * 4 + row;
-                    int msb = (src[4 + (bitIdx >> 3)] >> (7 - (bitIdx & 7))) & 1;
-                    int lsb = (src[4 + ((bitIdx + 16) >> 3)] >> (7 - ((bitIdx + 16) & 7))) & 1;
-                    int idx = msb | (lsb << 1);
-
-                    // In punchthrough mode, index 2 (msb=0, lsb=1) = transparent black
-                    if (idx == 2)
-                    {
-                        pixels[row * 4 + col] = { 0, 0, 0, 0 };
-                        continue;
-                    }
-
-                    int mod = 0;
-                    switch (idx)
-                    {
-                    case 0:
-                        mod = Etc2Modifier[table[sub]][0];
-                        break;
-                    case 1:
-                        mod = -Etc2Modifier[table[sub]][0];
-                        break;
-                    case 3:
-                        mod = -Etc2Modifier[table[sub]][1];
-                        break;
-                    }
-
-                    pixels[row * 4 + col] = {
-                        clampByte(baseR[sub] + mod),
-                        clampByte(baseG[sub] + mod),
-                        clampByte(baseB[sub] + mod),
-                        255
-                    };
-                }
+    void decodeBC3(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<16>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeBC3Block(block, pixels);
+        });
+    }
 
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, pixels[py * 4 + px]);
-                    }
-                }
+    void decodeBC4(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<8>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeBC4Block(block, pixels);
+        });
+    }
 
-                src += 8;
-            }
-        }
+    void decodeBC5(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<16>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeBC5Block(block, pixels);
+        });
     }
 
-    void decodeEAC_R11(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
+    void decodeBC7(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
     {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
+        decodeBlocks<16>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeBC7Block(block, pixels);
+        });
+    }
 
-        for (uint32_t by = 0; by < blocksH; by++)
-        {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
-            {
-                uint8_t values[16];
-                decodeEACAlpha(src, values);
-                src += 8;
+    void decodeETC2_RGB(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<8>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeETC2Block_RGB(block, pixels);
+        });
+    }
 
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        int i = py * 4 + px;
-                        Rgba c = { values[i], values[i], values[i], 255 };
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, c);
-                    }
-                }
-            }
-        }
+    void decodeETC2_RGBA(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<16>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeETC2Block_RGBA(block, pixels);
+        });
     }
 
-    void decodeEAC_RG11(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height)
+    void decodeETC2_RGBA1(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
     {
-        uint32_t blocksW = (width + 3) / 4;
-        uint32_t blocksH = (height + 3) / 4;
+        decodeBlocks<8>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeETC2Block_RGBA1(block, pixels);
+        });
+    }
 
-        for (uint32_t by = 0; by < blocksH; by++)
-        {
-            for (uint32_t bx = 0; bx < blocksW; bx++)
-            {
-                uint8_t red[16];
-                decodeEACAlpha(src, red);
-                uint8_t green[16];
-                decodeEACAlpha(src + 8, green);
-                src += 16;
+    void decodeEAC_R11(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<8>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeEACBlock_R11(block, pixels);
+        });
+    }
 
-                for (int py = 0; py < 4; py++)
-                {
-                    for (int px = 0; px < 4; px++)
-                    {
-                        int i = py * 4 + px;
-                        Rgba c = { red[i], green[i], 0, 255 };
-                        writePixel(dst, bx * 4 + px, by * 4 + py, width, height, c);
-                    }
-                }
-            }
-        }
+    void decodeEAC_RG11(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        decodeBlocks<16>(src, dst, width, height, stream, [](const uint8_t* block, Rgba pixels[16]) {
+            decodeEACBlock_RG11(block, pixels);
+        });
     }
 
-    void decodeASTC(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t blockW, uint32_t blockH)
+    void decodeASTC(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t blockW, uint32_t blockH, const Stream& stream)
     {
-        astcenc_config config{};
-        astcenc_error status = astcenc_config_init(
-            ASTCENC_PRF_LDR, blockW, blockH, 1,
-            ASTCENC_PRE_FASTEST, ASTCENC_FLG_DECOMPRESS_ONLY, &config);
-        if (status != ASTCENC_SUCCESS)
+        auto astc = getAstcContext(blockW, blockH, ASTCENC_PRF_LDR);
+        if (astc == nullptr)
         {
             ::memset(dst, 0, width * height * 4);
             return;
         }
 
-        astcenc_context* context = nullptr;
-        status = astcenc_context_alloc(&config, 1, &context);
-        if (status != ASTCENC_SUCCESS)
+        const uint32_t blocksW   = (width + blockW - 1) / blockW;
+        const uint32_t blocksH   = (height + blockH - 1) / blockH;
+        const uint32_t stripRows = StripBlockRows * blockH;
+        const uint32_t strips    = (blocksH + StripBlockRows - 1) / StripBlockRows;
+
+        const astcenc_swizzle swizzle{ ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A };
+
+        std::lock_guard<std::mutex> lock(astc->mutex);
+
+        // Strips are decoded top to bottom, each one as a sub-image shared
+        // by all threads, so finished rows can be streamed right away.
+        for (uint32_t strip = 0; strip < strips; strip++)
         {
-            ::memset(dst, 0, width * height * 4);
-            return;
-        }
+            if (stream.stop != nullptr && stream.stop->isRequested())
+            {
+                return;
+            }
+
+            const uint32_t y    = strip * stripRows;
+            const uint32_t rows = std::min(stripRows, height - y);
 
-        astcenc_image image{};
-        image.dim_x = width;
-        image.dim_y = height;
-        image.dim_z = 1;
-        image.data_type = ASTCENC_TYPE_U8;
-        image.data = reinterpret_cast<void**>(&dst);
+            void* slice = dst + static_cast<size_t>(y) * width * 4;
 
-        uint32_t blocksW_ = (width + blockW - 1) / blockW;
-        uint32_t blocksH_ = (height + blockH - 1) / blockH;
-        size_t dataLen = static_cast<size_t>(blocksW_) * blocksH_ * 16;
+            astcenc_image image{};
+            image.dim_x     = width;
+            image.dim_y     = rows;
+            image.dim_z     = 1;
+            image.data_type = ASTCENC_TYPE_U8;
+            image.data      = &slice;
 
-        astcenc_swizzle swizzle{ ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A };
-        astcenc_decompress_image(context, src, dataLen, &image, &swizzle, 0);
+            const uint8_t* blocks = src + static_cast<size_t>(strip) * StripBlockRows * blocksW * 16;
+            const size_t dataLen  = static_cast<size_t>(std::min(StripBlockRows, blocksH - strip * StripBlockRows)) * blocksW * 16;
 
-        astcenc_context_free(context);
+            astcenc_decompress_reset(astc->context);
+            cThreadPool::shared().parallelFor(0, astc->threads, [&](uint32_t thread) {
+                astcenc_decompress_image(astc->context, blocks, dataLen, &image, &swizzle, thread);
+            });
+
+            if (stream.onRowsReady != nullptr)
+            {
+                stream.onRowsReady(y + rows);
+            }
+        }
+    }
+
+    bool decode(eCompressedFormat format, const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream)
+    {
+        switch (format)
+        {
+        case eCompressedFormat::BC1:
+            decodeBC1(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::BC2:
+            decodeBC2(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::BC3:
+            decodeBC3(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::BC4:
+            decodeBC4(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::BC5:
+            decodeBC5(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::BC7:
+            decodeBC7(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::ETC2_RGB:
+            decodeETC2_RGB(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::ETC2_RGBA:
+            decodeETC2_RGBA(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::ETC2_RGBA1:
+            decodeETC2_RGBA1(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::EAC_R11:
+            decodeEAC_R11(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::EAC_RG11:
+            decodeEAC_RG11(src, dst, width, height, stream);
+            return true;
+        case eCompressedFormat::ASTC_4x4:
+            decodeASTC(src, dst, width, height, 4, 4, stream);
+            return true;
+        case eCompressedFormat::ASTC_6x6:
+            decodeASTC(src, dst, width, height, 6, 6, stream);
+            return true;
+        case eCompressedFormat::ASTC_8x8:
+            decodeASTC(src, dst, width, height, 8, 8, stream);
+            return true;
+        default:
+            return false;
+        }
     }
 
 } // namespace gpu_decode
@@ -9,21 +9,38 @@
 
 #pragma once
 
+#include "Common/CompressedFormat.h"
+
 #include <cstdint>
+#include <functional>
+
+class cStopToken;
 
 namespace gpu_decode
 {
-    void decodeBC1(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeBC2(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeBC3(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeBC4(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeBC5(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeBC7(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeETC2_RGB(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeETC2_RGBA(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeETC2_RGBA1(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeEAC_R11(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeEAC_RG11(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height);
-    void decodeASTC(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t blockW, uint32_t blockH);
+    // Block formats are decoded in horizontal strips on the shared thread
+    // pool. onRowsReady receives the count of fully decoded rows from the top
+    // as strips complete, so the viewer can stream them; stop aborts early.
+    struct Stream
+    {
+        std::function<void(uint32_t rows)> onRowsReady;
+        const cStopToken* stop = nullptr;
+    };
+
+    void decodeBC1(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeBC2(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeBC3(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeBC4(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeBC5(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeBC7(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeETC2_RGB(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeETC2_RGBA(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeETC2_RGBA1(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeEAC_R11(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeEAC_RG11(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
+    void decodeASTC(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t blockW, uint32_t blockH, const Stream& stream = {});
+
+    // Dispatches to one of the decoders above, false for an unknown format.
+    bool decode(eCompressedFormat format, const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, const Stream& stream = {});
 
 } // namespace gpu_decode
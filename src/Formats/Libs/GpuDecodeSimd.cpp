@@ -0,0 +1,287 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "GpuDecodeSimd.h"
+#include "Log/Log.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GPU_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define GPU_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    inline uint8_t clampByte(int v)
+    {
+        return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+    }
+
+    // -------------------------------------------------------------------------
+    // Scalar reference
+    // -------------------------------------------------------------------------
+
+    void lerp64Scalar(const uint8_t* e0, const uint8_t* e1, const uint8_t* w, uint8_t* out)
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            out[i] = static_cast<uint8_t>(((64 - w[i]) * e0[i] + w[i] * e1[i] + 32) >> 6);
+        }
+    }
+
+    void etcTexelsScalar(uint16_t msb, uint16_t lsb, bool flip, const uint8_t base[2][3], const int16_t mods[8], uint8_t* out)
+    {
+        for (int p = 0; p < 16; p++)
+        {
+            const int row   = p >> 2;
+            const int col   = p & 3;
+            const int shift = 15 - (col * 4 + row);
+            const int idx   = ((msb >> shift) & 1) | (((lsb >> shift) & 1) << 1);
+            const int sub   = flip ? (row >= 2 ? 1 : 0) : (col >= 2 ? 1 : 0);
+            const int mod   = mods[sub * 4 + idx];
+
+            out[p * 4 + 0] = clampByte(base[sub][0] + mod);
+            out[p * 4 + 1] = clampByte(base[sub][1] + mod);
+            out[p * 4 + 2] = clampByte(base[sub][2] + mod);
+            out[p * 4 + 3] = 255;
+        }
+    }
+
+    const gpu_simd::Kernels ScalarKernels = { "scalar", lerp64Scalar, etcTexelsScalar };
+
+#if defined(GPU_SIMD_X86)
+
+    // -------------------------------------------------------------------------
+    // SSE4.1
+    // -------------------------------------------------------------------------
+
+    __attribute__((target("sse4.1"))) void lerp64Sse41(const uint8_t* e0, const uint8_t* e1, const uint8_t* w, uint8_t* out)
+    {
+        const __m128i c64 = _mm_set1_epi16(64);
+        const __m128i c32 = _mm_set1_epi16(32);
+
+        for (int i = 0; i < 64; i += 8)
+        {
+            const __m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(e0 + i)));
+            const __m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(e1 + i)));
+            const __m128i f = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + i)));
+
+            __m128i r = _mm_add_epi16(_mm_mullo_epi16(a, _mm_sub_epi16(c64, f)), _mm_mullo_epi16(b, f));
+            r         = _mm_srli_epi16(_mm_add_epi16(r, c32), 6);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(r, r));
+        }
+    }
+
+    __attribute__((target("sse4.1"))) void etcTexelsSse41(uint16_t msb, uint16_t lsb, bool flip, const uint8_t base[2][3], const int16_t mods[8], uint8_t* out)
+    {
+        // Selector bit of row-major texel p is 15 - (col * 4 + row).
+        const __m128i bitMask[2] = {
+            _mm_setr_epi16(static_cast<short>(0x8000), 0x0800, 0x0080, 0x0008, 0x4000, 0x0400, 0x0040, 0x0004),
+            _mm_setr_epi16(0x2000, 0x0200, 0x0020, 0x0002, 0x1000, 0x0100, 0x0010, 0x0001),
+        };
+        const __m128i colMask = _mm_setr_epi16(0, 0, -1, -1, 0, 0, -1, -1);
+
+        const __m128i vm    = _mm_set1_epi16(static_cast<short>(msb));
+        const __m128i vl    = _mm_set1_epi16(static_cast<short>(lsb));
+        const __m128i table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mods));
+
+        __m128i channel[3][2];
+        for (int h = 0; h < 2; h++)
+        {
+            const __m128i m   = _mm_cmpeq_epi16(_mm_and_si128(vm, bitMask[h]), bitMask[h]);
+            const __m128i l   = _mm_cmpeq_epi16(_mm_and_si128(vl, bitMask[h]), bitMask[h]);
+            const __m128i sub = flip
+                ? _mm_set1_epi16(h == 0 ? 0 : -1)
+                : colMask;
+
+            const __m128i key = _mm_or_si128(_mm_or_si128(_mm_and_si128(m, _mm_set1_epi16(1)),
+                                                          _mm_and_si128(l, _mm_set1_epi16(2))),
+                                             _mm_and_si128(sub, _mm_set1_epi16(4)));
+
+            // Byte shuffle picking the int16 table entry: (2 * key) | (2 * key + 1) << 8.
+            const __m128i shuffle = _mm_add_epi16(_mm_mullo_epi16(key, _mm_set1_epi16(0x0202)), _mm_set1_epi16(0x0100));
+            const __m128i delta   = _mm_shuffle_epi8(table, shuffle);
+
+            for (int c = 0; c < 3; c++)
+            {
+                const __m128i b = _mm_blendv_epi8(_mm_set1_epi16(base[0][c]), _mm_set1_epi16(base[1][c]), sub);
+                channel[c][h]   = _mm_add_epi16(b, delta);
+            }
+        }
+
+        // Saturating pack is the clamp to [0, 255].
+        const __m128i r = _mm_packus_epi16(channel[0][0], channel[0][1]);
+        const __m128i g = _mm_packus_epi16(channel[1][0], channel[1][1]);
+        const __m128i b = _mm_packus_epi16(channel[2][0], channel[2][1]);
+        const __m128i a = _mm_set1_epi8(-1);
+
+        const __m128i rgLo = _mm_unpacklo_epi8(r, g);
+        const __m128i rgHi = _mm_unpackhi_epi8(r, g);
+        const __m128i baLo = _mm_unpacklo_epi8(b, a);
+        const __m128i baHi = _mm_unpackhi_epi8(b, a);
+
+        auto dst = reinterpret_cast<__m128i*>(out);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(rgLo, baLo));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(rgLo, baLo));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(rgHi, baHi));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(rgHi, baHi));
+    }
+
+    const gpu_simd::Kernels Sse41Kernels = { "sse4.1", lerp64Sse41, etcTexelsSse41 };
+
+    // -------------------------------------------------------------------------
+    // AVX2, the ETC kernel works on 16 texels and gains nothing over SSE4.1.
+    // -------------------------------------------------------------------------
+
+    __attribute__((target("avx2"))) void lerp64Avx2(const uint8_t* e0, const uint8_t* e1, const uint8_t* w, uint8_t* out)
+    {
+        const __m256i c64 = _mm256_set1_epi16(64);
+        const __m256i c32 = _mm256_set1_epi16(32);
+
+        for (int i = 0; i < 64; i += 16)
+        {
+            const __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(e0 + i)));
+            const __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(e1 + i)));
+            const __m256i f = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i)));
+
+            __m256i r = _mm256_add_epi16(_mm256_mullo_epi16(a, _mm256_sub_epi16(c64, f)), _mm256_mullo_epi16(b, f));
+            r         = _mm256_srli_epi16(_mm256_add_epi16(r, c32), 6);
+
+            // packus works per 128-bit lane, gather qwords 0 and 2.
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(r, r), 0xd8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+        }
+    }
+
+    const gpu_simd::Kernels Avx2Kernels = { "avx2", lerp64Avx2, etcTexelsSse41 };
+
+    const gpu_simd::Kernels& detectKernels()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return Avx2Kernels;
+        }
+        if (__builtin_cpu_supports("sse4.1"))
+        {
+            return Sse41Kernels;
+        }
+        return ScalarKernels;
+    }
+
+#elif defined(GPU_SIMD_NEON)
+
+    // -------------------------------------------------------------------------
+    // NEON
+    // -------------------------------------------------------------------------
+
+    void lerp64Neon(const uint8_t* e0, const uint8_t* e1, const uint8_t* w, uint8_t* out)
+    {
+        const uint8x16_t c64 = vdupq_n_u8(64);
+
+        for (int i = 0; i < 64; i += 16)
+        {
+            const uint8x16_t a = vld1q_u8(e0 + i);
+            const uint8x16_t b = vld1q_u8(e1 + i);
+            const uint8x16_t f = vld1q_u8(w + i);
+            const uint8x16_t g = vsubq_u8(c64, f);
+
+            const uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(a), vget_low_u8(g)), vget_low_u8(b), vget_low_u8(f));
+            const uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(a), vget_high_u8(g)), vget_high_u8(b), vget_high_u8(f));
+
+            // Rounding narrow shift is the + 32 >> 6.
+            vst1q_u8(out + i, vcombine_u8(vrshrn_n_u16(lo, 6), vrshrn_n_u16(hi, 6)));
+        }
+    }
+
+    void etcTexelsNeon(uint16_t msb, uint16_t lsb, bool flip, const uint8_t base[2][3], const int16_t mods[8], uint8_t* out)
+    {
+        // Selector bit of row-major texel p is 15 - (col * 4 + row).
+        static const uint16_t BitMask[16] = {
+            0x8000, 0x0800, 0x0080, 0x0008, 0x4000, 0x0400, 0x0040, 0x0004,
+            0x2000, 0x0200, 0x0020, 0x0002, 0x1000, 0x0100, 0x0010, 0x0001
+        };
+        static const uint16_t ColMask[8] = { 0, 0, 0xffff, 0xffff, 0, 0, 0xffff, 0xffff };
+
+        const uint16x8_t vm    = vdupq_n_u16(msb);
+        const uint16x8_t vl    = vdupq_n_u16(lsb);
+        const uint8x16_t table = vreinterpretq_u8_s16(vld1q_s16(mods));
+
+        uint8x8_t channel[3][2];
+        for (int h = 0; h < 2; h++)
+        {
+            const uint16x8_t mask = vld1q_u16(BitMask + h * 8);
+            const uint16x8_t m    = vtstq_u16(vm, mask);
+            const uint16x8_t l    = vtstq_u16(vl, mask);
+            const uint16x8_t sub  = flip
+                ? vdupq_n_u16(h == 0 ? 0 : 0xffff)
+                : vld1q_u16(ColMask);
+
+            const uint16x8_t key = vorrq_u16(vorrq_u16(vandq_u16(m, vdupq_n_u16(1)),
+                                                      vandq_u16(l, vdupq_n_u16(2))),
+                                             vandq_u16(sub, vdupq_n_u16(4)));
+
+            // Byte shuffle picking the int16 table entry: (2 * key) | (2 * key + 1) << 8.
+            const uint16x8_t shuffle = vmlaq_n_u16(vdupq_n_u16(0x0100), key, 0x0202);
+            const int16x8_t delta    = vreinterpretq_s16_u8(vqtbl1q_u8(table, vreinterpretq_u8_u16(shuffle)));
+
+            for (int c = 0; c < 3; c++)
+            {
+                const int16x8_t b = vbslq_s16(sub, vdupq_n_s16(base[1][c]), vdupq_n_s16(base[0][c]));
+                channel[c][h]     = vqmovun_s16(vaddq_s16(b, delta));
+            }
+        }
+
+        uint8x16x4_t texels;
+        texels.val[0] = vcombine_u8(channel[0][0], channel[0][1]);
+        texels.val[1] = vcombine_u8(channel[1][0], channel[1][1]);
+        texels.val[2] = vcombine_u8(channel[2][0], channel[2][1]);
+        texels.val[3] = vdupq_n_u8(255);
+        vst4q_u8(out, texels);
+    }
+
+    const gpu_simd::Kernels NeonKernels = { "neon", lerp64Neon, etcTexelsNeon };
+
+    const gpu_simd::Kernels& detectKernels()
+    {
+        return NeonKernels;
+    }
+
+#else
+
+    const gpu_simd::Kernels& detectKernels()
+    {
+        return ScalarKernels;
+    }
+
+#endif
+
+} // namespace
+
+namespace gpu_simd
+{
+    const Kernels& getKernels()
+    {
+        static const Kernels& kernels = []() -> const Kernels& {
+            const auto& detected = detectKernels();
+            cLog::Debug("Block decode kernels: {}.", detected.name);
+            return detected;
+        }();
+
+        return kernels;
+    }
+
+    const Kernels& getScalarKernels()
+    {
+        return ScalarKernels;
+    }
+
+} // namespace gpu_simd
@@ -0,0 +1,38 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include <cstdint>
+
+// Vector kernels for the hot loops of the block decoders. The x86 variants
+// are compiled with per-function target attributes and picked at runtime,
+// NEON is baseline on aarch64. The scalar set is the reference.
+namespace gpu_simd
+{
+    struct Kernels
+    {
+        const char* name;
+
+        // out[i] = (e0[i] * (64 - w[i]) + e1[i] * w[i] + 32) >> 6 over 64 bytes
+        // (16 RGBA texels), the BC7 endpoint interpolation.
+        void (*lerp64)(const uint8_t* e0, const uint8_t* e1, const uint8_t* w, uint8_t* out);
+
+        // ETC1/ETC2 individual and differential mode. msb/lsb are the selector
+        // planes (big-endian, column-major texel order), mods[sub * 4 + idx] the
+        // signed modifiers. Writes 16 opaque RGBA texels in row-major order.
+        void (*etcTexels)(uint16_t msb, uint16_t lsb, bool flip, const uint8_t base[2][3], const int16_t mods[8], uint8_t* out);
+    };
+
+    // Best kernels for the running CPU, detected once.
+    const Kernels& getKernels();
+
+    const Kernels& getScalarKernels();
+
+} // namespace gpu_simd
@@ -11,9 +11,17 @@
 #include "Common/ChunkData.h"
 #include "Common/Cms.h"
 #include "Common/ImageInfo.h"
+#include "Common/StopToken.h"
+#include "Common/ThreadPool.h"
+#include "Common/Timing.h"
+#include "Common/YCbCr.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <jpeglib.h>
+#include <mutex>
+#include <numeric>
 #include <setjmp.h>
 #include <thread>
 
@@ -36,9 +44,15 @@ namespace
 
     // Wait until the ring buffer has room for the next row.
     // The decoder must not overwrite rows the viewer hasn't consumed yet.
-    void waitForRoom(const sChunkData& chunk, uint32_t row, const bool& stop)
+    void waitForRoom(const sChunkData& chunk, uint32_t row, const cStopToken& stop)
     {
-        while (stop == false)
+        // A full bitmap never wraps, and refinement passes restart at row 0.
+        if (chunk.bandHeight >= chunk.height)
+        {
+            return;
+        }
+
+        while (stop.isRequested() == false)
         {
             auto consumed = chunk.consumedHeight.load(std::memory_order_acquire);
             if (row - consumed < chunk.bandHeight)
@@ -49,79 +63,218 @@ namespace
         }
     }
 
-    void emitRow(sChunkData& chunk, uint32_t row,
-                 const cJpegDecoder::ProgressCallback& onProgress, float progressBase, float progressScale)
+    void emitRow(sChunkData& chunk, uint32_t row, const cJpegDecoder::ProgressCallback& onProgress)
     {
         chunk.readyHeight.store(row + 1, std::memory_order_release);
 
         if (onProgress)
         {
-            auto p = static_cast<float>(row + 1) / chunk.height;
-            onProgress(progressBase + p * progressScale);
+            onProgress(static_cast<float>(row + 1) / chunk.height);
+        }
+    }
+
+    // Called with each finished bitmap row.
+    using RowCallback = std::function<void(uint32_t row)>;
+
+    void setOutputSpace(jpeg_decompress_struct& cinfo, bool isCMYK, bool isPlanar)
+    {
+        if (isPlanar)
+        {
+            cinfo.out_color_space = JCS_YCbCr;
+            cinfo.raw_data_out    = TRUE;
+        }
+        else if (isCMYK == false)
+        {
+            cinfo.out_color_space = JCS_RGB;
+        }
+    }
+
+    // 8-bit YCbCr with 4:2:0 or 4:2:2 chroma is read as raw planes.
+    bool getPlanarFormat(const jpeg_decompress_struct& cinfo, ePixelFormat& format)
+    {
+        if (cinfo.jpeg_color_space != JCS_YCbCr || cinfo.num_components != 3 || cinfo.data_precision != 8)
+        {
+            return false;
+        }
+
+        const auto comp = cinfo.comp_info;
+        for (int c = 1; c < 3; c++)
+        {
+            if (comp[c].h_samp_factor != 1 || comp[c].v_samp_factor != 1)
+            {
+                return false;
+            }
+        }
+
+        if (comp[0].h_samp_factor != 2 || comp[0].v_samp_factor > 2)
+        {
+            return false;
+        }
+
+        format = comp[0].v_samp_factor == 2
+            ? ePixelFormat::YCbCr420
+            : ePixelFormat::YCbCr422;
+        return true;
+    }
+
+    // Largest DCT scaling (1/8, 1/4, 1/2) whose output still covers the
+    // image fit into the box. Either orientation fits, EXIF rotation is
+    // applied later.
+    uint32_t getScaleDenom(const jpeg_decompress_struct& cinfo, uint32_t fitWidth, uint32_t fitHeight)
+    {
+        if (fitWidth == 0 || fitHeight == 0)
+        {
+            return 1;
+        }
+
+        const double w     = cinfo.image_width;
+        const double h     = cinfo.image_height;
+        const double scale = std::max(std::min(fitWidth / w, fitHeight / h),
+                                      std::min(fitHeight / w, fitWidth / h));
+        for (uint32_t denom = 8; denom > 1; denom /= 2)
+        {
+            if (1.0 / denom >= scale)
+            {
+                return denom;
+            }
+        }
+
+        return 1;
+    }
+
+    // One iMCU row per call, straight into the band buffer rows from
+    // firstRow on. Rows past the image end go to a scratch row.
+    void readRawData(jpeg_decompress_struct& cinfo, sChunkData& chunk, uint32_t firstRow,
+                     const cStopToken& stop, const RowCallback& onRow)
+    {
+        const auto layout        = ycbcr::getLayout(chunk.format, chunk.width);
+        const uint32_t groupRows = cinfo.max_v_samp_factor * DCTSIZE;
+
+        std::vector<uint8_t> scratch(chunk.pitch);
+        std::vector<JSAMPROW> rows(groupRows + 2 * DCTSIZE);
+        JSAMPARRAY planes[3] = { rows.data(), rows.data() + groupRows, rows.data() + groupRows + DCTSIZE };
+
+        auto rowPtr = [&](uint32_t row) {
+            return row < chunk.height
+                ? chunk.rowPtr(row)
+                : scratch.data();
+        };
+
+        while (cinfo.output_scanline < cinfo.output_height && stop.isRequested() == false)
+        {
+            const uint32_t top    = firstRow + cinfo.output_scanline;
+            const uint32_t bottom = std::min(top + groupRows, chunk.height);
+            waitForRoom(chunk, bottom - 1, stop);
+            if (stop.isRequested())
+            {
+                break;
+            }
+
+            for (uint32_t i = 0; i < groupRows; i++)
+            {
+                planes[0][i] = rowPtr(top + i);
+            }
+
+            // Chroma row i sits on the luma row it starts at.
+            for (uint32_t i = 0; i < DCTSIZE; i++)
+            {
+                auto out     = rowPtr(top + i * layout.factorY);
+                planes[1][i] = out + layout.cbOffset;
+                planes[2][i] = out + layout.crOffset;
+            }
+
+            jpeg_read_raw_data(&cinfo, planes, groupRows);
+
+            onRow(bottom - 1);
         }
     }
 
-    void readScanlines(jpeg_decompress_struct& cinfo, sChunkData& chunk,
-                       const bool& stop,
-                       const cJpegDecoder::ProgressCallback& onProgress, float progressBase, float progressScale)
+    void readScanlines(jpeg_decompress_struct& cinfo, sChunkData& chunk, uint32_t firstRow,
+                       const cStopToken& stop, const RowCallback& onRow)
     {
         if (cinfo.data_precision == 12)
         {
 #if defined(HAVE_JPEG12)
-            std::vector<uint16_t> scanline(chunk.pitch);
-            while (cinfo.output_scanline < cinfo.output_height && stop == false)
+            const bool is16 = chunk.format == ePixelFormat::RGB16;
+            std::vector<uint16_t> scanline(is16 ? 0 : chunk.pitch);
+            while (cinfo.output_scanline < cinfo.output_height && stop.isRequested() == false)
             {
-                const uint32_t row = cinfo.output_scanline;
+                const uint32_t row = firstRow + cinfo.output_scanline;
                 waitForRoom(chunk, row, stop);
-                if (stop)
+                if (stop.isRequested())
                 {
                     break;
                 }
 
-                auto s = scanline.data();
-                jpeg12_read_scanlines(&cinfo, reinterpret_cast<J12SAMPARRAY>(&s), 1);
                 auto out = chunk.rowPtr(row);
-                for (uint32_t i = 0u; i < chunk.pitch; i++)
+                if (is16)
+                {
+                    // Decoded in place, 12-bit samples widened to the full
+                    // 16-bit range.
+                    auto s = reinterpret_cast<J12SAMPROW>(out);
+                    jpeg12_read_scanlines(&cinfo, &s, 1);
+                    auto samples = reinterpret_cast<uint16_t*>(out);
+                    for (uint32_t i = 0u; i < chunk.width * 3; i++)
+                    {
+                        samples[i] = static_cast<uint16_t>((samples[i] << 4) | (samples[i] >> 8));
+                    }
+                }
+                else
                 {
-                    out[i] = static_cast<uint8_t>(scanline[i] >> 4);
+                    auto s = scanline.data();
+                    jpeg12_read_scanlines(&cinfo, reinterpret_cast<J12SAMPARRAY>(&s), 1);
+                    for (uint32_t i = 0u; i < chunk.pitch; i++)
+                    {
+                        out[i] = static_cast<uint8_t>(scanline[i] >> 4);
+                    }
                 }
 
-                emitRow(chunk, row, onProgress, progressBase, progressScale);
+                onRow(row);
             }
 #endif
         }
         else if (cinfo.data_precision == 16)
         {
 #if defined(HAVE_JPEG16)
-            std::vector<uint16_t> scanline(chunk.pitch);
-            while (cinfo.output_scanline < cinfo.output_height && stop == false)
+            const bool is16 = chunk.format == ePixelFormat::RGB16;
+            std::vector<uint16_t> scanline(is16 ? 0 : chunk.pitch);
+            while (cinfo.output_scanline < cinfo.output_height && stop.isRequested() == false)
             {
-                const uint32_t row = cinfo.output_scanline;
+                const uint32_t row = firstRow + cinfo.output_scanline;
                 waitForRoom(chunk, row, stop);
-                if (stop)
+                if (stop.isRequested())
                 {
                     break;
                 }
 
-                auto s = scanline.data();
-                jpeg16_read_scanlines(&cinfo, reinterpret_cast<J16SAMPARRAY>(&s), 1);
                 auto out = chunk.rowPtr(row);
-                for (uint32_t i = 0u; i < chunk.pitch; i++)
+                if (is16)
                 {
-                    out[i] = static_cast<uint8_t>(scanline[i] >> 8);
+                    // Native samples, no conversion.
+                    auto s = reinterpret_cast<J16SAMPROW>(out);
+                    jpeg16_read_scanlines(&cinfo, &s, 1);
+                }
+                else
+                {
+                    auto s = scanline.data();
+                    jpeg16_read_scanlines(&cinfo, reinterpret_cast<J16SAMPARRAY>(&s), 1);
+                    for (uint32_t i = 0u; i < chunk.pitch; i++)
+                    {
+                        out[i] = static_cast<uint8_t>(scanline[i] >> 8);
+                    }
                 }
 
-                emitRow(chunk, row, onProgress, progressBase, progressScale);
+                onRow(row);
             }
 #endif
         }
         else
         {
-            while (cinfo.output_scanline < cinfo.output_height && stop == false)
+            while (cinfo.output_scanline < cinfo.output_height && stop.isRequested() == false)
             {
-                const uint32_t row = cinfo.output_scanline;
+                const uint32_t row = firstRow + cinfo.output_scanline;
                 waitForRoom(chunk, row, stop);
-                if (stop)
+                if (stop.isRequested())
                 {
                     break;
                 }
@@ -129,20 +282,407 @@ namespace
                 auto out = chunk.rowPtr(row);
                 jpeg_read_scanlines(&cinfo, &out, 1);
 
-                emitRow(chunk, row, onProgress, progressBase, progressScale);
+                onRow(row);
             }
         }
     }
 
+    void readPass(jpeg_decompress_struct& cinfo, sChunkData& chunk, uint32_t firstRow, bool isPlanar,
+                  const cStopToken& stop, const RowCallback& onRow)
+    {
+        if (isPlanar)
+        {
+            readRawData(cinfo, chunk, firstRow, stop, onRow);
+        }
+        else
+        {
+            readScanlines(cinfo, chunk, firstRow, stop, onRow);
+        }
+    }
+
+    void readPass(jpeg_decompress_struct& cinfo, sChunkData& chunk, bool isPlanar,
+                  const cStopToken& stop, const cJpegDecoder::ProgressCallback& onProgress)
+    {
+        readPass(cinfo, chunk, 0, isPlanar, stop, [&chunk, &onProgress](uint32_t row) {
+            emitRow(chunk, row, onProgress);
+        });
+    }
+
+    // Buffered-image mode: a full-frame output pass from the scans read so
+    // far, the next one once more scans arrived and at least as long as the
+    // last pass took has passed, so refinements cost at most about half of
+    // the decode. Each pass after the first is announced by onRefine.
+    void readRefinements(jpeg_decompress_struct& cinfo, sChunkData& chunk, bool isPlanar,
+                         const cStopToken& stop,
+                         const cJpegDecoder::ProgressCallback& onProgress,
+                         const cJpegDecoder::AllocatedCallback& onRefine)
+    {
+        constexpr double MinRefineInterval = 0.1; // seconds
+
+        double nextPass = 0.0;
+        bool isFirst    = true;
+        while (stop.isRequested() == false)
+        {
+            int status = JPEG_SUSPENDED;
+            do
+            {
+                status = jpeg_consume_input(&cinfo);
+            } while (status != JPEG_REACHED_EOI && status != JPEG_SUSPENDED
+                     && (status != JPEG_SCAN_COMPLETED || timing::seconds() < nextPass)
+                     && stop.isRequested() == false);
+
+            if (stop.isRequested())
+            {
+                break;
+            }
+
+            // Data ends here, suspending on a memory source means truncated.
+            const bool isFinal = jpeg_input_complete(&cinfo) || status == JPEG_SUSPENDED;
+            if (isFirst == false && onRefine)
+            {
+                onRefine();
+            }
+            isFirst = false;
+
+            const double start = timing::seconds();
+            jpeg_start_output(&cinfo, cinfo.input_scan_number);
+            readPass(cinfo, chunk, isPlanar, stop, isFinal ? onProgress : nullptr);
+            jpeg_finish_output(&cinfo);
+
+            if (isFinal)
+            {
+                break;
+            }
+
+            const double now = timing::seconds();
+            nextPass         = now + std::max(now - start, MinRefineInterval);
+        }
+    }
+
+    // Headers and entropy-coded segments of a sequential Huffman file with
+    // restart markers and a single scan. Cut at the right markers, whole
+    // MCU rows decode on their own.
+    struct RestartIndex
+    {
+        Buffer header;                  // SOI up to the scan header, metadata left out
+        uint32_t heightOffset = 0;      // frame height in header
+        uint32_t mcusPerRow   = 0;
+        uint32_t mcuRows      = 0;
+        uint32_t mcuHeight    = 0;      // pixel rows per MCU row
+        uint32_t interval     = 0;      // MCUs per restart interval
+        uint32_t stripRows    = 0;      // MCU rows per strip
+        std::vector<uint32_t> segments; // offsets of the entropy-coded segments
+        uint32_t dataEnd = 0;           // offset of the marker after the scan
+    };
+
+    uint32_t readU16(const uint8_t* p)
+    {
+        return (static_cast<uint32_t>(p[0]) << 8) | p[1];
+    }
+
+    // Strips are at least this many pixel rows high and each fits into
+    // the band buffer, otherwise false.
+    bool indexRestarts(const uint8_t* in, uint32_t size, uint32_t bandHeight, RestartIndex& index)
+    {
+        constexpr uint32_t MinStripRows = 64;
+
+        index.header = { 0xff, 0xd8 };
+
+        uint32_t width      = 0;
+        uint32_t height     = 0;
+        uint32_t components = 0;
+        uint32_t maxH       = 1;
+        uint32_t maxV       = 1;
+
+        uint32_t pos = 2;
+        for (;;)
+        {
+            if (pos + 4 > size || in[pos] != 0xff)
+            {
+                return false;
+            }
+
+            const uint8_t marker = in[pos + 1];
+            if (marker == 0xff)
+            {
+                pos++; // fill byte
+                continue;
+            }
+
+            const uint32_t length = readU16(in + pos + 2);
+            const uint32_t next   = pos + 2 + length;
+            if (length < 2 || next > size)
+            {
+                return false;
+            }
+
+            const uint8_t* data = in + pos + 4;
+            if (marker == 0xc0 || marker == 0xc1)
+            {
+                components = length >= 8 ? data[5] : 0;
+                if (components == 0 || components > 4 || length < 8 + 3 * components || data[0] != 8)
+                {
+                    return false;
+                }
+
+                height = readU16(data + 1);
+                width  = readU16(data + 3);
+                for (uint32_t c = 0; c < components; c++)
+                {
+                    maxH = std::max<uint32_t>(maxH, data[7 + 3 * c] >> 4);
+                    maxV = std::max<uint32_t>(maxV, data[7 + 3 * c] & 15);
+                }
+                index.heightOffset = static_cast<uint32_t>(index.header.size()) + 5;
+            }
+            else if (marker >= 0xc2 && marker <= 0xcf && marker != 0xc4)
+            {
+                return false; // progressive, lossless or arithmetic
+            }
+            else if (marker == 0xdd)
+            {
+                index.interval = length >= 4 ? readU16(data) : 0;
+            }
+            else if (marker == 0xda)
+            {
+                if (width == 0 || height == 0 || index.interval == 0 || data[0] != components)
+                {
+                    return false;
+                }
+                index.header.insert(index.header.end(), in + pos, in + next);
+                pos = next;
+                break;
+            }
+            else if (marker != 0xc4 && marker != 0xdb && (marker < 0xe0 || marker > 0xef) && marker != 0xfe)
+            {
+                return false; // only tables, APPn and comments precede the scan
+            }
+
+            // APP0 and APP14 (Adobe) tell the color space, other APPn and
+            // comments are of no use to a strip.
+            const bool isMetadata = (marker >= 0xe1 && marker <= 0xef && marker != 0xee) || marker == 0xfe;
+            if (isMetadata == false)
+            {
+                index.header.insert(index.header.end(), in + pos, in + next);
+            }
+            pos = next;
+        }
+
+        // A single-component scan has one block per MCU.
+        const uint32_t mcuWidth = components == 1 ? DCTSIZE : DCTSIZE * maxH;
+        index.mcuHeight         = components == 1 ? DCTSIZE : DCTSIZE * maxV;
+        index.mcusPerRow        = (width + mcuWidth - 1) / mcuWidth;
+        index.mcuRows           = (height + index.mcuHeight - 1) / index.mcuHeight;
+
+        // Strips start where a restart interval starts a row.
+        const uint32_t step    = index.interval / std::gcd(index.interval, index.mcusPerRow);
+        const uint32_t desired = (cThreadPool::shared().getThreadsCount() + 1) * 4;
+        uint32_t rows          = std::max((index.mcuRows + desired - 1) / desired,
+                                          (MinStripRows + index.mcuHeight - 1) / index.mcuHeight);
+        rows                   = (rows + step - 1) / step * step;
+        if (rows >= index.mcuRows || static_cast<uint64_t>(rows) * index.mcuHeight > bandHeight)
+        {
+            return false;
+        }
+        index.stripRows = rows;
+
+        const uint64_t mcus     = static_cast<uint64_t>(index.mcusPerRow) * index.mcuRows;
+        const uint64_t expected = (mcus + index.interval - 1) / index.interval;
+        index.segments.reserve(static_cast<size_t>(expected));
+        index.segments.push_back(pos);
+        for (;;)
+        {
+            auto ff = static_cast<const uint8_t*>(::memchr(in + pos, 0xff, size - pos));
+            if (ff == nullptr || ff + 1 >= in + size)
+            {
+                return false;
+            }
+
+            pos                  = static_cast<uint32_t>(ff - in);
+            const uint8_t marker = in[pos + 1];
+            if (marker == 0x00)
+            {
+                pos += 2; // stuffed byte
+            }
+            else if (marker == 0xff)
+            {
+                pos++;
+            }
+            else if (marker >= 0xd0 && marker <= 0xd7)
+            {
+                pos += 2;
+                index.segments.push_back(pos);
+            }
+            else
+            {
+                index.dataEnd = pos;
+                break;
+            }
+        }
+
+        return index.segments.size() == expected;
+    }
+
+    // Stand-alone file of segments [first, end): the headers with the
+    // frame height of the strip and the restart markers renumbered.
+    Buffer makeStrip(const uint8_t* in, const RestartIndex& index, uint32_t first, uint32_t end, uint32_t height)
+    {
+        const uint32_t dataEnd = end < index.segments.size() ? index.segments[end] - 2 : index.dataEnd;
+
+        Buffer strip;
+        strip.reserve(index.header.size() + (dataEnd - index.segments[first]) + 2);
+        strip.insert(strip.end(), index.header.begin(), index.header.end());
+        strip[index.heightOffset]     = static_cast<uint8_t>(height >> 8);
+        strip[index.heightOffset + 1] = static_cast<uint8_t>(height & 0xff);
+
+        for (uint32_t s = first; s < end; s++)
+        {
+            if (s != first)
+            {
+                strip.push_back(0xff);
+                strip.push_back(static_cast<uint8_t>(0xd0 + ((s - first - 1) & 7)));
+            }
+            const uint32_t segmentEnd = s + 1 < index.segments.size() ? index.segments[s + 1] - 2 : index.dataEnd;
+            strip.insert(strip.end(), in + index.segments[s], in + segmentEnd);
+        }
+
+        strip.push_back(0xff);
+        strip.push_back(0xd9);
+
+        return strip;
+    }
+
+    bool decodeStrip(const Buffer& strip, sChunkData& chunk, uint32_t firstRow, bool isCMYK, bool isPlanar,
+                     const cStopToken& stop, const RowCallback& onRow)
+    {
+        jpeg_decompress_struct cinfo;
+        sErrorMgr jerr;
+
+        cinfo.err           = jpeg_std_error(&jerr.pub);
+        jerr.pub.error_exit = ErrorExit;
+        if (setjmp(jerr.setjmp_buffer))
+        {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+        jpeg_create_decompress(&cinfo);
+
+        jpeg_mem_src(&cinfo, strip.data(), static_cast<unsigned long>(strip.size()));
+        jpeg_read_header(&cinfo, TRUE);
+        setOutputSpace(cinfo, isCMYK, isPlanar);
+        jpeg_start_decompress(&cinfo);
+
+        readPass(cinfo, chunk, firstRow, isPlanar, stop, onRow);
+
+        if (stop.isRequested() == false)
+        {
+            jpeg_finish_decompress(&cinfo);
+        }
+        jpeg_destroy_decompress(&cinfo);
+
+        return true;
+    }
+
+    // Strips finish out of order, rows are ready up to the first strip
+    // still decoding.
+    class cStripTracker final
+    {
+    public:
+        cStripTracker(sChunkData& chunk, uint32_t strips, uint32_t stripHeight,
+                      const cJpegDecoder::ProgressCallback& onProgress)
+            : m_chunk(chunk)
+            , m_done(strips)
+            , m_stripHeight(stripHeight)
+            , m_onProgress(onProgress)
+        {
+            for (uint32_t i = 0; i < strips; i++)
+            {
+                m_done[i] = i * stripHeight;
+            }
+        }
+
+        void rowDone(uint32_t strip, uint32_t row)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done[strip] = row + 1;
+            while (m_prefix < m_done.size() && m_done[m_prefix] == getBottom(m_prefix))
+            {
+                m_prefix++;
+            }
+
+            const uint32_t ready = m_prefix < m_done.size() ? m_done[m_prefix] : m_chunk.height;
+            if (ready > m_ready)
+            {
+                m_ready = ready;
+                emitRow(m_chunk, ready - 1, m_onProgress);
+            }
+        }
+
+        uint32_t getBottom(uint32_t strip) const
+        {
+            return std::min((strip + 1) * m_stripHeight, m_chunk.height);
+        }
+
+    private:
+        std::mutex m_mutex;
+        sChunkData& m_chunk;
+        std::vector<uint32_t> m_done; // end of the rows decoded per strip
+        const uint32_t m_stripHeight;
+        const cJpegDecoder::ProgressCallback& m_onProgress;
+        uint32_t m_prefix = 0;
+        uint32_t m_ready  = 0;
+    };
+
+    // Strips go to the pool in order, so the first unfinished one always
+    // runs and the band buffer keeps draining. A strip that fails still
+    // counts as done, the ones below it must not wait for it.
+    bool decodeStrips(const uint8_t* in, const RestartIndex& index, sChunkData& chunk, bool isCMYK, bool isPlanar,
+                      const cStopToken& stop, const cJpegDecoder::ProgressCallback& onProgress)
+    {
+        const uint32_t strips      = (index.mcuRows + index.stripRows - 1) / index.stripRows;
+        const uint32_t stripHeight = index.stripRows * index.mcuHeight;
+
+        cStripTracker tracker(chunk, strips, stripHeight, onProgress);
+        std::atomic<bool> failed{ false };
+
+        cThreadPool::shared().parallelFor(0, strips, [&](uint32_t strip) {
+            if (stop.isRequested())
+            {
+                return;
+            }
+
+            const uint64_t mcuBegin = static_cast<uint64_t>(strip) * index.stripRows * index.mcusPerRow;
+            const uint64_t mcuEnd   = static_cast<uint64_t>(std::min((strip + 1) * index.stripRows, index.mcuRows)) * index.mcusPerRow;
+            const auto first        = static_cast<uint32_t>(mcuBegin / index.interval);
+            const auto end          = static_cast<uint32_t>((mcuEnd + index.interval - 1) / index.interval);
+            const uint32_t top      = strip * stripHeight;
+            const uint32_t bottom   = tracker.getBottom(strip);
+
+            const auto data = makeStrip(in, index, first, end, bottom - top);
+            const bool done = decodeStrip(data, chunk, top, isCMYK, isPlanar, stop, [&tracker, strip](uint32_t row) {
+                tracker.rowDone(strip, row);
+            });
+            if (done == false)
+            {
+                failed.store(true, std::memory_order_relaxed);
+                tracker.rowDone(strip, bottom - 1);
+            }
+        });
+
+        return failed.load(std::memory_order_relaxed) == false && stop.isRequested() == false;
+    }
+
 } // namespace
 
 cJpegDecoder::Result cJpegDecoder::decodeJpeg(const uint8_t* in, uint32_t size, sChunkData& chunk, sImageInfo& info,
                                               const ProgressCallback& onProgress, const AllocatedCallback& onAllocated,
                                               const ImageInfoCallback& onImageInfo, const PreviewCallback& onPreview,
-                                              const bool& stop)
+                                              const cStopToken& stop, uint32_t fitWidth, uint32_t fitHeight)
 {
     Result result;
 
+    // The preview decode reads `in` from the pool, every return waits for it.
+    cTaskGroup previewTask;
+
     // Step 1: allocate and initialize JPEG decompression object
     jpeg_decompress_struct cinfo;
     sErrorMgr jerr;
@@ -165,19 +705,29 @@ cJpegDecoder::Result cJpegDecoder::decodeJpeg(const uint8_t* in, uint32_t size,
 
     // Step 4: set parameters for decompression
     const bool isCMYK = cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK;
-    if (isCMYK == false)
-    {
-        cinfo.out_color_space = JCS_RGB;
-    }
+
+    // The IDCT produces the reduced size directly, most of the decode
+    // work is skipped.
+    const uint32_t scaleDenom = getScaleDenom(cinfo, fitWidth, fitHeight);
+    cinfo.scale_num           = 1;
+    cinfo.scale_denom         = scaleDenom;
+
+    // Subsampled YCbCr goes up as planes at native resolution, the shader
+    // upsamples and converts them. Raw planes come in full DCT blocks only.
+    ePixelFormat planarFormat = ePixelFormat::RGB;
+    const bool isPlanar       = scaleDenom == 1 && isCMYK == false && getPlanarFormat(cinfo, planarFormat);
+    setOutputSpace(cinfo, isCMYK, isPlanar);
 
     // Compute output dimensions early so we can signal image info
     // before decompression starts.
     jpeg_calc_output_dimensions(&cinfo);
 
-    info.fileSize = size;
-    chunk.width   = cinfo.output_width;
-    chunk.height  = cinfo.output_height;
-    info.bppImage = cinfo.num_components * static_cast<uint32_t>(cinfo.data_precision);
+    info.fileSize   = size;
+    info.fullWidth  = scaleDenom > 1 ? cinfo.image_width : 0;
+    info.fullHeight = scaleDenom > 1 ? cinfo.image_height : 0;
+    chunk.width     = cinfo.output_width;
+    chunk.height    = cinfo.output_height;
+    info.bppImage   = cinfo.num_components * static_cast<uint32_t>(cinfo.data_precision);
 
     // Extract markers (available after jpeg_read_header)
     locateICCProfile(cinfo, result.iccProfile);
@@ -196,6 +746,7 @@ cJpegDecoder::Result cJpegDecoder::decodeJpeg(const uint8_t* in, uint32_t size,
     }
 
     // Extract EXIF thumbnail as preview before expensive decode
+    bool hasPreview = false;
     if (onPreview && result.exifData.empty() == false)
     {
         const uint8_t* thumbData = nullptr;
@@ -206,18 +757,57 @@ cJpegDecoder::Result cJpegDecoder::decodeJpeg(const uint8_t* in, uint32_t size,
             if (thumb.width > 0 && thumb.height > 0)
             {
                 onPreview(std::move(thumb));
+                hasPreview = true;
             }
         }
     }
 
     // Step 5: Start decompressor
-    // For progressive JPEGs, jpeg_start_decompress performs all internal
-    // multi-pass decoding. After that, jpeg_read_scanlines works identically
-    // to baseline — one row at a time with stop checks.
+    // Progressive JPEGs shown while loading run in buffered-image mode, the
+    // viewer gets a blurry full frame early and sharpens it pass by pass.
+    // Otherwise jpeg_start_decompress performs all internal multi-pass
+    // decoding and jpeg_read_scanlines works identically to baseline.
+    // Refinements rewrite every row, so a banded bitmap can't take them.
+    constexpr uint32_t BandRows = 8192;
+
+    const bool isRefining = jpeg_has_multiple_scans(&cinfo)
+        && chunk.fullBitmap == false
+        && chunk.getBandHeight(BandRows) == chunk.height;
+
+    // Baseline files with restart markers decode in strips on the pool.
+    // Fancy upsampling reads across strip edges, so chroma subsampled
+    // files only qualify on the planar path.
+    RestartIndex restarts;
+    const bool isParallel = isRefining == false && scaleDenom == 1 && cinfo.data_precision == 8
+        && (isPlanar || (cinfo.max_h_samp_factor == 1 && cinfo.max_v_samp_factor == 1))
+        && indexRestarts(in, size, chunk.getBandHeight(BandRows), restarts);
+
+    // Without a thumbnail a large serial file gets a 1/8 scaled decode as
+    // preview, it runs on the pool next to the main decode. Strips stream
+    // rows fast enough on their own, progressive files show a whole frame
+    // after their first scan anyway.
+    constexpr uint64_t PreviewMinPixels = 4096 * 4096;
+    if (onPreview && hasPreview == false && isParallel == false && scaleDenom == 1
+        && isCMYK == false && cinfo.data_precision == 8
+        && jpeg_has_multiple_scans(&cinfo) == false
+        && static_cast<uint64_t>(chunk.width) * chunk.height >= PreviewMinPixels)
+    {
+        cThreadPool::shared().submit(previewTask, [in, size, &onPreview, &stop] {
+            if (stop.isRequested() == false)
+            {
+                auto thumb = decodeThumbnail(in, size, 8);
+                if (thumb.width > 0 && thumb.height > 0)
+                {
+                    onPreview(std::move(thumb));
+                }
+            }
+        });
+    }
+
+    cinfo.buffered_image = isRefining ? TRUE : FALSE;
     jpeg_start_decompress(&cinfo);
 
     // Step 6: allocate bitmap as a band buffer
-    constexpr uint32_t BandRows = 8192;
     ePixelFormat fmt;
     if (isCMYK)
     {
@@ -226,12 +816,21 @@ cJpegDecoder::Result cJpegDecoder::decodeJpeg(const uint8_t* in, uint32_t size,
         chunk.effects |= eEffect::Cmyk;
         chunk.allocate(chunk.width, chunk.height, 32, fmt, BandRows);
     }
+    else if (isPlanar)
+    {
+        fmt = planarFormat;
+        chunk.effects |= eEffect::YCbCr;
+        chunk.allocatePlanar(chunk.width, chunk.height, fmt, BandRows);
+    }
     else
     {
+        // 12/16-bit color stays at 16 bits per sample up to the GPU.
+        const bool is16 = cinfo.output_components == 3
+            && (cinfo.data_precision == 12 || cinfo.data_precision == 16);
         fmt = (cinfo.output_components == 1)
             ? ePixelFormat::Luminance
-            : ePixelFormat::RGB;
-        chunk.allocate(chunk.width, chunk.height, cinfo.output_components * 8, fmt, BandRows);
+            : (is16 ? ePixelFormat::RGB16 : ePixelFormat::RGB);
+        chunk.allocate(chunk.width, chunk.height, cinfo.output_components * (is16 ? 16 : 8), fmt, BandRows);
     }
 
     // Step 7: generate 3D LUT from ICC profile (applied on GPU during rendering)
@@ -251,10 +850,28 @@ cJpegDecoder::Result cJpegDecoder::decodeJpeg(const uint8_t* in, uint32_t size,
     }
 
     // Step 8: read scanlines into ring buffer (no CPU transforms)
-    readScanlines(cinfo, chunk, stop, onProgress, 0.0f, 1.0f);
+    if (isParallel)
+    {
+        if (decodeStrips(in, restarts, chunk, isCMYK, isPlanar, stop, onProgress) == false)
+        {
+            jpeg_destroy_decompress(&cinfo);
+            return result;
+        }
+    }
+    else if (isRefining)
+    {
+        readRefinements(cinfo, chunk, isPlanar, stop, onProgress, onAllocated);
+    }
+    else
+    {
+        readPass(cinfo, chunk, isPlanar, stop, onProgress);
+    }
 
     // Step 9: Finish decompression
-    jpeg_finish_decompress(&cinfo);
+    if (isParallel == false)
+    {
+        jpeg_finish_decompress(&cinfo);
+    }
 
     // Step 10: Release JPEG decompression object
     jpeg_destroy_decompress(&cinfo);
@@ -263,7 +880,7 @@ cJpegDecoder::Result cJpegDecoder::decodeJpeg(const uint8_t* in, uint32_t size,
     return result;
 }
 
-cJpegDecoder::Bitmap cJpegDecoder::decodeThumbnail(const uint8_t* in, uint32_t size)
+cJpegDecoder::Bitmap cJpegDecoder::decodeThumbnail(const uint8_t* in, uint32_t size, uint32_t scaleDenom)
 {
     Bitmap bitmap;
 
@@ -282,6 +899,8 @@ cJpegDecoder::Bitmap cJpegDecoder::decodeThumbnail(const uint8_t* in, uint32_t s
     jpeg_mem_src(&cinfo, const_cast<uint8_t*>(in), size);
     jpeg_read_header(&cinfo, TRUE);
     cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num       = 1;
+    cinfo.scale_denom     = scaleDenom;
     jpeg_start_decompress(&cinfo);
 
     bitmap.width  = cinfo.output_width;
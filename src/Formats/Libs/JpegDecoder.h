@@ -16,6 +16,7 @@
 #include <functional>
 #include <vector>
 
+class cStopToken;
 struct jpeg_decompress_struct;
 struct sChunkData;
 struct sImageInfo;
@@ -45,12 +46,16 @@ public:
     using ImageInfoCallback = std::function<void()>;
     using PreviewCallback   = std::function<void(Bitmap&&)>;
 
+    // With a fitWidth × fitHeight box the image is decoded DCT-scaled down
+    // to the smallest size still covering it, info.fullWidth/fullHeight
+    // keep the natural size then.
     Result decodeJpeg(const uint8_t* in, uint32_t size, sChunkData& chunk, sImageInfo& info,
                       const ProgressCallback& onProgress, const AllocatedCallback& onAllocated,
                       const ImageInfoCallback& onImageInfo, const PreviewCallback& onPreview,
-                      const bool& stop);
+                      const cStopToken& stop, uint32_t fitWidth = 0, uint32_t fitHeight = 0);
 
-    static Bitmap decodeThumbnail(const uint8_t* in, uint32_t size);
+    // scaleDenom 1, 2, 4 or 8 decodes at that fraction of the size.
+    static Bitmap decodeThumbnail(const uint8_t* in, uint32_t size, uint32_t scaleDenom = 1);
 
 private:
     static void setupMarkers(jpeg_decompress_struct* cinfo);
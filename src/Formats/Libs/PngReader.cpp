@@ -13,6 +13,7 @@
 #include "Common/File.h"
 #include "Common/Helpers.h"
 #include "Common/ImageInfo.h"
+#include "Common/StopToken.h"
 #include "Log/Log.h"
 
 #include <cstring>
@@ -159,6 +160,38 @@ namespace
         return nullptr;
     }
 
+    // PLTE with the tRNS alphas, the indices are looked up on the GPU.
+    void readPalette(const png_structp png, const png_infop info, sChunkData& chunk)
+    {
+        chunk.palette.assign(256 * 4, 0);
+
+        png_colorp colors = nullptr;
+        int count         = 0;
+        if (png_get_PLTE(png, info, &colors, &count) != 0)
+        {
+            for (int i = 0; i < count && i < 256; i++)
+            {
+                auto entry = &chunk.palette[i * 4];
+                entry[0]   = colors[i].red;
+                entry[1]   = colors[i].green;
+                entry[2]   = colors[i].blue;
+                entry[3]   = 255;
+            }
+        }
+
+        png_bytep alpha = nullptr;
+        int alphaCount  = 0;
+        if (png_get_tRNS(png, info, &alpha, &alphaCount, nullptr) != 0 && alpha != nullptr)
+        {
+            for (int i = 0; i < alphaCount && i < 256; i++)
+            {
+                chunk.palette[i * 4 + 3] = alpha[i];
+            }
+        }
+
+        chunk.effects |= eEffect::Palette;
+    }
+
 } // namespace
 
 cPngReader::cPngReader()
@@ -244,19 +277,31 @@ bool cPngReader::doLoadPNG(const cPngWrapper& wrapper, sChunkData& chunk, sImage
     cLog::Debug("Source color type: {}.", colorType);
     if (colorType == PNG_COLOR_TYPE_PALETTE)
     {
-        cLog::Debug("Converting palette to RGB.");
-        png_set_palette_to_rgb(png);
+        cLog::Debug("Keeping palette indices.");
+        png_set_packing(png);
     }
-
-    if (png_get_valid(png, info, PNG_INFO_tRNS))
+    else if (png_get_valid(png, info, PNG_INFO_tRNS))
     {
         cLog::Debug("Converting tRNS to alpha.");
         png_set_tRNS_to_alpha(png);
     }
     if (png_get_bit_depth(png, info) == 16)
     {
-        cLog::Debug("Stripping 16-bit depth to 8-bit.");
-        png_set_strip_16(png);
+        if (colorType & PNG_COLOR_MASK_COLOR)
+        {
+            // Uploaded as 16-bit texture, PNG samples are big-endian.
+            const uint16_t probe = 1;
+            if (*reinterpret_cast<const uint8_t*>(&probe) == 1)
+            {
+                cLog::Debug("Swapping 16-bit samples to little-endian.");
+                png_set_swap(png);
+            }
+        }
+        else
+        {
+            cLog::Debug("Stripping 16-bit depth to 8-bit.");
+            png_set_strip_16(png);
+        }
     }
 
     // Update info structure to apply transformations
@@ -273,7 +318,8 @@ bool cPngReader::doLoadPNG(const cPngWrapper& wrapper, sChunkData& chunk, sImage
         cLog::Error("Source pitch {} is larger than destination pitch {}.", srcPitch, chunk.pitch);
     }
 
-    colorType = png_get_color_type(png, info);
+    colorType       = png_get_color_type(png, info);
+    const bool is16 = png_get_bit_depth(png, info) == 16;
     cLog::Debug("Result color type: {}, bpp: {}.", colorType, chunk.bpp);
 
     // #define PNG_COLOR_MASK_PALETTE    1
@@ -289,11 +335,20 @@ bool cPngReader::doLoadPNG(const cPngWrapper& wrapper, sChunkData& chunk, sImage
     }
     else if (colorType == PNG_COLOR_TYPE_RGB) // 0b00000010 (rgb)
     {
-        chunk.format = ePixelFormat::RGB;
+        chunk.format = is16
+            ? ePixelFormat::RGB16
+            : ePixelFormat::RGB;
     }
     else if (colorType == PNG_COLOR_TYPE_RGB_ALPHA) // 0b00000110 (rgb + alpha)
     {
-        chunk.format = ePixelFormat::RGBA;
+        chunk.format = is16
+            ? ePixelFormat::RGBA16
+            : ePixelFormat::RGBA;
+    }
+    else if (colorType == PNG_COLOR_TYPE_PALETTE) // 0b00000011 (palette)
+    {
+        chunk.format = ePixelFormat::Indexed8;
+        readPalette(png, info, chunk);
     }
     else
     {
@@ -311,9 +366,7 @@ bool cPngReader::doLoadPNG(const cPngWrapper& wrapper, sChunkData& chunk, sImage
 
     // Allocate band buffer
     constexpr uint32_t BandRows = 8192;
-    chunk.bandHeight            = BandRows < chunk.height
-        ? BandRows
-        : chunk.height;
+    chunk.bandHeight            = chunk.getBandHeight(BandRows);
     chunk.resizeBitmap(chunk.pitch, chunk.bandHeight);
 
     // Generate 3D LUT from ICC profile (applied on GPU during rendering)
@@ -334,13 +387,13 @@ bool cPngReader::doLoadPNG(const cPngWrapper& wrapper, sChunkData& chunk, sImage
 
     for (uint32_t y = 0; y < chunk.height; y++)
     {
-        if (m_stop != nullptr && *m_stop)
+        if (m_stop != nullptr && m_stop->isRequested())
         {
             return false;
         }
 
         // Wait for ring buffer room
-        while (m_stop != nullptr && *m_stop == false)
+        while (m_stop != nullptr && m_stop->isRequested() == false)
         {
             auto consumed = chunk.consumedHeight.load(std::memory_order_acquire);
             if (y - consumed < chunk.bandHeight)
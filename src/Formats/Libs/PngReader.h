@@ -15,6 +15,7 @@
 
 class cFile;
 class cPngWrapper;
+class cStopToken;
 struct sChunkData;
 struct sImageInfo;
 
@@ -37,7 +38,7 @@ public:
         m_allocated = callback;
     }
 
-    void setStopFlag(const bool* stop)
+    void setStopToken(const cStopToken* stop)
     {
         m_stop = stop;
     }
@@ -71,7 +72,7 @@ public:
 private:
     progressCallback m_progress   = nullptr;
     allocatedCallback m_allocated = nullptr;
-    const bool* m_stop            = nullptr;
+    const cStopToken* m_stop      = nullptr;
 
     IccProfile m_iccProfile;
 };
@@ -8,22 +8,39 @@
 \**********************************************/
 
 #include "ImageLoader.h"
+#include "BitmapCache.h"
 #include "Common/Callbacks.h"
 #include "Common/Config.h"
 #include "Common/File.h"
+#include "Common/Helpers.h"
 #include "Common/Timing.h"
 #include "Formats/Format.h"
 #include "Formats/FormatRegistry.h"
+#include "ImagePrefetcher.h"
 #include "Log/Log.h"
 #include "Network/Curl.h"
 #include "NotAvailable.h"
+#include "PreviewCache.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <string>
 
+namespace
+{
+    // Decoded animation frames waiting for upload.
+    constexpr uint32_t FramesAhead = 3;
+
+} // namespace
+
 cImageLoader::cImageLoader(const sConfig* config, sCallbacks* callbacks)
     : m_config(config)
     , m_callbacks(callbacks)
+    , m_silentCallbacks(sCallbacks::makeSilent())
+    , m_previewCache(std::make_unique<cPreviewCache>(config))
+    , m_prefetcher(std::make_unique<cImagePrefetcher>(config, m_previewCache.get()))
+    , m_cache(std::make_unique<cBitmapCache>(static_cast<size_t>(config->bitmapCacheMb) * 1024 * 1024))
 {
 }
 
@@ -33,6 +50,11 @@ cImageLoader::~cImageLoader()
     clear();
 }
 
+void cImageLoader::prefetch(const std::vector<std::string>& paths)
+{
+    m_prefetcher->schedule(paths);
+}
+
 cFormat* cImageLoader::getOrCreateReader(const sFormatEntry& entry)
 {
     auto it = m_formatCache.find(entry.name);
@@ -43,11 +65,159 @@ cFormat* cImageLoader::getOrCreateReader(const sFormatEntry& entry)
 
     auto reader = entry.factory(m_callbacks);
     reader->setConfig(m_config);
+    reader->setStopToken(&m_stopToken);
     auto* ptr = reader.get();
     m_formatCache.emplace(entry.name, std::move(reader));
     return ptr;
 }
 
+void cImageLoader::signalDecoded()
+{
+    // The bitmap is already complete: report it the way formats without
+    // progressive output do, the viewer picks it up on endLoading().
+    m_callbacks->onImageInfo(m_chunk, m_info);
+    m_chunk.readyHeight.store(m_chunk.height, std::memory_order_release);
+}
+
+bool cImageLoader::loadCached(const cBitmapCache::Key& key)
+{
+    auto entry = m_cache->take(key, m_chunk, m_info);
+    if (entry == nullptr)
+    {
+        return false;
+    }
+
+    if (m_activeFormat != entry)
+    {
+        m_activeFormat = entry;
+        m_activeReader = getOrCreateReader(*entry);
+        m_readerPrimed = false;
+        m_readerFrame  = -1;
+    }
+    m_metrics.cacheHit = true;
+
+    setChunkKey(key);
+    signalDecoded();
+
+    return true;
+}
+
+bool cImageLoader::loadPrefetched(const char* path)
+{
+    auto entry = m_prefetcher->take(path, m_chunk, m_info);
+    if (entry == nullptr)
+    {
+        return false;
+    }
+
+    m_activeFormat       = entry;
+    m_activeReader       = getOrCreateReader(*entry);
+    m_metrics.prefetched = true;
+
+    signalDecoded();
+
+    return true;
+}
+
+bool cImageLoader::primeReader()
+{
+    // Reader never opened this file (bitmap came from cache or prefetch).
+    // Decode the base image silently to get its state back.
+    m_activeReader->setCallbacks(&m_silentCallbacks);
+    const bool result = m_activeReader->Load(m_path.c_str(), m_chunk, m_info);
+    m_activeReader->setCallbacks(m_callbacks);
+
+    m_readerPrimed = result;
+    m_readerFrame  = result ? static_cast<int>(m_info.current) : -1;
+
+    return result;
+}
+
+bool cImageLoader::decodeSubImage(uint32_t subImage)
+{
+    if (m_readerPrimed == false && primeReader() == false)
+    {
+        return false;
+    }
+
+    // Composited sub-images need the canvas of the previous one. When the
+    // current canvas came from cache the reader state is stale: replay.
+    if (m_activeReader->isSubImageSequential() && subImage != 0
+        && (m_readerFrame != static_cast<int>(m_info.current) || subImage != m_info.current + 1))
+    {
+        m_activeReader->setCallbacks(&m_silentCallbacks);
+        for (uint32_t i = 0; i < subImage; i++)
+        {
+            if (m_activeReader->LoadSubImage(i, m_chunk, m_info) == false)
+            {
+                m_activeReader->setCallbacks(m_callbacks);
+                m_readerFrame = -1;
+                return false;
+            }
+        }
+        m_activeReader->setCallbacks(m_callbacks);
+    }
+
+    const bool result = m_activeReader->LoadSubImage(subImage, m_chunk, m_info);
+    m_readerFrame     = result ? static_cast<int>(subImage) : -1;
+
+    return result;
+}
+
+bool cImageLoader::fetchSubImage(uint32_t subImage, uint32_t targetWidth, uint32_t targetHeight)
+{
+    cBitmapCache::Key key;
+    const bool hasKey = makeChunkKey(subImage, targetWidth, targetHeight, key);
+    if (hasKey && loadCached(key))
+    {
+        return true;
+    }
+
+    if (decodeSubImage(subImage) == false)
+    {
+        return false;
+    }
+
+    if (hasKey)
+    {
+        setChunkKey(key);
+    }
+
+    return true;
+}
+
+bool cImageLoader::makeChunkKey(uint32_t subImage, uint32_t targetWidth, uint32_t targetHeight, cBitmapCache::Key& key) const
+{
+    if (m_path.empty() || cBitmapCache::makeKey(m_path.c_str(), key) == false)
+    {
+        return false;
+    }
+
+    key.subImage     = subImage;
+    key.targetWidth  = targetWidth;
+    key.targetHeight = targetHeight;
+
+    return true;
+}
+
+void cImageLoader::setChunkKey(const cBitmapCache::Key& key)
+{
+    m_chunkKey       = key;
+    m_chunkCacheable = true;
+}
+
+void cImageLoader::storeChunk(bool copy)
+{
+    const bool banded = m_chunk.bandHeight != 0 && m_chunk.bandHeight < m_chunk.height;
+    if (m_chunkCacheable && m_completed.load(std::memory_order_acquire)
+        && m_chunk.bitmap.empty() == false && banded == false)
+    {
+        m_cache->put(m_chunkKey, m_activeFormat, m_chunk, m_info, copy);
+    }
+
+    m_chunkCacheable = m_chunkCacheable && copy;
+}
+
 bool cImageLoader::loadFromFile(const char* path)
 {
     const auto t0 = timing::seconds();
@@ -67,8 +237,34 @@ bool cImageLoader::loadFromFile(const char* path)
 
     m_metrics.fileReadMs = (timing::seconds() - t0) * 1000.0;
 
+    m_activeFormat = entry;
     m_activeReader = getOrCreateReader(*entry);
-    bool result    = m_activeReader->Load(path, m_chunk, m_info);
+
+    // Only local files have a stable cache key.
+    bool hasPreview = false;
+    if (m_path.empty() == false)
+    {
+        sPreviewData preview;
+        hasPreview = m_previewCache->load(path, preview);
+        if (hasPreview)
+        {
+            m_activeReader->setCachedPreview(std::move(preview));
+        }
+    }
+
+    // Only local files can be read again at full size.
+    const bool canReduce = m_path.empty() == false;
+    m_activeReader->setTargetSize(canReduce ? m_fitWidth : 0, canReduce ? m_fitHeight : 0);
+
+    // The viewer samples the rows into a cache preview as it uploads them,
+    // banded images never hold all of them at once.
+    m_previewWanted.store(hasPreview == false && m_path.empty() == false && m_previewCache->isEnabled(),
+                          std::memory_order_release);
+
+    bool result = m_activeReader->Load(path, m_chunk, m_info);
+
+    m_readerPrimed = result;
+    m_readerFrame  = result ? static_cast<int>(m_info.current) : -1;
 
     if (result)
     {
@@ -81,6 +277,12 @@ bool cImageLoader::loadFromFile(const char* path)
 
 void cImageLoader::load(const char* path)
 {
+    m_path.clear();
+    m_activeFormat   = nullptr;
+    m_readerPrimed   = false;
+    m_readerFrame    = -1;
+    m_chunkCacheable = false;
+
     if (path != nullptr)
     {
         cCurl curl;
@@ -91,9 +293,31 @@ void cImageLoader::load(const char* path)
                 return;
             }
         }
-        else if (loadFromFile(path))
+        else
         {
-            return;
+            // Temporary downloads are not cached, local files are.
+            m_path = path;
+
+            cBitmapCache::Key key;
+            const bool hasKey = makeChunkKey(0, 0, 0, key);
+            if (hasKey && loadCached(key))
+            {
+                return;
+            }
+
+            if (loadPrefetched(path) || loadFromFile(path))
+            {
+                // A scaled-down decode is cheap to redo, only full-size
+                // bitmaps are cached.
+                if (hasKey && m_info.fullWidth == 0)
+                {
+                    key.subImage = m_info.current;
+                    setChunkKey(key);
+                }
+                return;
+            }
+
+            m_path.clear();
         }
     }
 
@@ -104,6 +328,7 @@ void cImageLoader::load(const char* path)
     if (it == m_formatCache.end())
     {
         auto na = std::make_unique<cNotAvailable>();
+        na->setStopToken(&m_stopToken);
         m_formatCache.emplace(NAkey, std::move(na));
         it = m_formatCache.find(NAkey);
     }
@@ -111,15 +336,20 @@ void cImageLoader::load(const char* path)
     m_activeReader->Load(path, m_chunk, m_info);
 }
 
-void cImageLoader::loadImage(const std::string& path)
+void cImageLoader::loadImage(const std::string& path, uint32_t fitWidth, uint32_t fitHeight)
 {
     stop();
+    resetAnimation();
     clear();
     m_metrics.reset();
 
+    m_fitWidth  = fitWidth;
+    m_fitHeight = fitHeight;
+
     m_mode = Mode::Image;
     m_completed.store(false, std::memory_order_relaxed);
-    m_loader = std::thread([this](const std::string& path) {
+    m_prefetcher->setPaused(true);
+    start([this, path] {
         if (m_config->debug)
         {
             cLog::Debug("=== loading: {} ===", path);
@@ -132,11 +362,13 @@ void cImageLoader::loadImage(const std::string& path)
             m_info.images = 1;
         }
         m_metrics.bitmapBytes = m_chunk.bitmap.size();
+        m_metrics.cacheHits   = m_cache->getHits();
+        m_metrics.cacheMisses = m_cache->getMisses();
         m_metrics.totalMs     = (timing::seconds() - t0) * 1000.0;
         m_completed.store(true, std::memory_order_release);
         m_callbacks->endLoading();
-    },
-                           path);
+        m_prefetcher->setPaused(false);
+    });
 }
 
 void cImageLoader::loadSubImage(unsigned subImage)
@@ -144,6 +376,11 @@ void cImageLoader::loadSubImage(unsigned subImage)
     assert(m_activeReader != nullptr);
 
     stop();
+    resetAnimation();
+
+    // Composited formats draw the next frame over this canvas, keep a copy.
+    storeChunk(m_activeReader->isSubImageSequential());
+    m_chunkCacheable = false;
 
     m_chunk.readyHeight.store(0, std::memory_order_relaxed);
     m_chunk.consumedHeight.store(0, std::memory_order_relaxed);
@@ -151,22 +388,27 @@ void cImageLoader::loadSubImage(unsigned subImage)
 
     m_metrics.reset();
 
+    // Pages are shown at full size, the raster size of the previous one
+    // doesn't apply.
+    m_activeReader->setTargetSize(0, 0);
+
     m_mode = Mode::SubImage;
     m_completed.store(false, std::memory_order_relaxed);
-    m_loader = std::thread([this](unsigned subImage) {
+    start([this, subImage] {
         const auto t0 = timing::seconds();
         m_callbacks->startLoading();
-        if (m_activeReader->LoadSubImage(subImage, m_chunk, m_info) == false)
+        if (fetchSubImage(subImage, 0, 0) == false)
         {
             cLog::Error("Failed to load sub-image {}.", subImage);
             m_chunk.reset();
         }
         m_metrics.bitmapBytes = m_chunk.bitmap.size();
+        m_metrics.cacheHits   = m_cache->getHits();
+        m_metrics.cacheMisses = m_cache->getMisses();
         m_metrics.totalMs     = (timing::seconds() - t0) * 1000.0;
         m_completed.store(true, std::memory_order_release);
         m_callbacks->endLoading();
-    },
-                           subImage);
+    });
 }
 
 void cImageLoader::rerasterize(uint32_t targetWidth, uint32_t targetHeight)
@@ -174,6 +416,10 @@ void cImageLoader::rerasterize(uint32_t targetWidth, uint32_t targetHeight)
     assert(m_activeReader != nullptr);
 
     stop();
+    resetAnimation();
+
+    storeChunk(false);
+    m_chunkCacheable = false;
 
     m_chunk.readyHeight.store(0, std::memory_order_relaxed);
     m_chunk.consumedHeight.store(0, std::memory_order_relaxed);
@@ -183,23 +429,266 @@ void cImageLoader::rerasterize(uint32_t targetWidth, uint32_t targetHeight)
 
     m_activeReader->setTargetSize(targetWidth, targetHeight);
 
+    // Pages of a multi-page pyramid keep their own levels.
+    const uint32_t current = m_info.current;
+
     m_mode = Mode::Rerasterize;
     m_completed.store(false, std::memory_order_relaxed);
-    m_loader = std::thread([this] {
+    start([this, current, targetWidth, targetHeight] {
         const auto t0 = timing::seconds();
         m_callbacks->startLoading();
-        if (m_activeReader->LoadSubImage(0, m_chunk, m_info) == false)
+        if (fetchSubImage(current, targetWidth, targetHeight) == false)
         {
             cLog::Error("Failed to re-rasterize image.");
             m_chunk.reset();
         }
         m_metrics.bitmapBytes = m_chunk.bitmap.size();
+        m_metrics.cacheHits   = m_cache->getHits();
+        m_metrics.cacheMisses = m_cache->getMisses();
         m_metrics.totalMs     = (timing::seconds() - t0) * 1000.0;
         m_completed.store(true, std::memory_order_release);
         m_callbacks->endLoading();
     });
 }
 
+void cImageLoader::loadWindow(const sImageInfo::Window& window)
+{
+    assert(m_activeReader != nullptr);
+
+    stop();
+    resetAnimation();
+
+    storeChunk(false);
+    m_chunkCacheable = false;
+
+    m_chunk.readyHeight.store(0, std::memory_order_relaxed);
+    m_chunk.consumedHeight.store(0, std::memory_order_relaxed);
+    m_chunk.lutData.clear();
+
+    m_metrics.reset();
+
+    m_activeReader->setTargetSize(window.levelWidth, window.levelHeight);
+    m_activeReader->setTargetWindow(window);
+
+    const uint32_t current = m_info.current;
+
+    // Windows change with every pan, they aren't worth a cache entry.
+    m_mode = Mode::Window;
+    m_completed.store(false, std::memory_order_relaxed);
+    start([this, current] {
+        const auto t0 = timing::seconds();
+        m_callbacks->startLoading();
+        if (decodeSubImage(current) == false)
+        {
+            cLog::Error("Failed to read image window.");
+        }
+        m_metrics.bitmapBytes = m_chunk.bitmap.size();
+        m_metrics.cacheHits   = m_cache->getHits();
+        m_metrics.cacheMisses = m_cache->getMisses();
+        m_metrics.totalMs     = (timing::seconds() - t0) * 1000.0;
+        m_completed.store(true, std::memory_order_release);
+        m_callbacks->endLoading();
+    });
+}
+
+bool cImageLoader::startAnimation(uint32_t depth)
+{
+    assert(m_activeReader != nullptr);
+
+    // Never cut the load of the shown frame short.
+    if (m_completed.load(std::memory_order_acquire) == false)
+    {
+        return false;
+    }
+
+    stop();
+    resetAnimation();
+
+    if (depth < 2 || m_info.images < 2)
+    {
+        return false;
+    }
+
+    m_animation.depth = depth;
+    m_animation.next  = (m_info.current + 1) % m_info.images;
+
+    // The reader continues from the shown frame unless the bitmap came
+    // from cache or prefetch, then the job replays it first.
+    m_animation.synced = m_readerPrimed && m_readerFrame == static_cast<int>(m_info.current);
+    if (m_animation.synced)
+    {
+        m_canvas.copyFrom(m_chunk);
+        m_canvasInfo = m_info;
+    }
+
+    decodeAhead();
+
+    return true;
+}
+
+void cImageLoader::stopAnimation()
+{
+    stop();
+    resetAnimation();
+}
+
+void cImageLoader::resetAnimation()
+{
+    // The reader went past the shown frame, decodeSubImage() replays.
+    if (m_animation.depth != 0)
+    {
+        m_readerFrame = -1;
+    }
+
+    m_animation = {};
+    m_canvas.reset();
+    m_canvasInfo = {};
+
+    std::lock_guard<std::mutex> lock(m_framesMutex);
+    m_frames.clear();
+}
+
+void cImageLoader::decodeAhead()
+{
+    if (m_animation.depth == 0 || m_job.isBusy() || m_animation.done)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_framesMutex);
+        if (m_frames.size() >= FramesAhead)
+        {
+            return;
+        }
+    }
+
+    start([this, current = m_info.current] {
+        m_activeReader->setCallbacks(&m_silentCallbacks);
+        if (m_animation.synced == false)
+        {
+            m_animation.synced = seekCanvas(current);
+            m_animation.done   = m_animation.synced == false;
+        }
+        bool more = m_animation.synced;
+        while (more && m_stopToken.isRequested() == false)
+        {
+            more = decodeFrame();
+        }
+        m_activeReader->setCallbacks(m_callbacks);
+    });
+}
+
+bool cImageLoader::seekCanvas(uint32_t frame)
+{
+    if (m_path.empty() || m_activeReader->Load(m_path.c_str(), m_canvas, m_canvasInfo) == false)
+    {
+        return false;
+    }
+    m_readerPrimed = true;
+
+    for (uint32_t i = 1; i <= frame; i++)
+    {
+        if (m_stopToken.isRequested() || m_activeReader->LoadSubImage(i, m_canvas, m_canvasInfo) == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool cImageLoader::decodeFrame()
+{
+    auto& anim = m_animation;
+    {
+        std::lock_guard<std::mutex> lock(m_framesMutex);
+        if (m_frames.size() >= FramesAhead)
+        {
+            return false;
+        }
+    }
+
+    if (m_activeReader->LoadSubImage(anim.next, m_canvas, m_canvasInfo) == false)
+    {
+        cLog::Error("Failed to decode animation frame {}.", anim.next);
+        anim.done = true;
+        return false;
+    }
+    anim.produced++;
+
+    // The frame lands in the slot of the frame depth steps back: send what
+    // changed since then, the whole canvas while the slots fill up.
+    anim.history.push_back(m_canvas.dirty);
+    if (anim.history.size() > anim.depth)
+    {
+        anim.history.pop_front();
+    }
+
+    bool whole = anim.produced < anim.depth;
+    uint32_t x0 = m_canvas.width;
+    uint32_t y0 = m_canvas.height;
+    uint32_t x1 = 0;
+    uint32_t y1 = 0;
+    for (const auto& rect : anim.history)
+    {
+        whole = whole || rect.w == 0;
+        x0    = std::min(x0, rect.x);
+        y0    = std::min(y0, rect.y);
+        x1    = std::max(x1, rect.x + rect.w);
+        y1    = std::max(y1, rect.y + rect.h);
+    }
+
+    Frame frame;
+    frame.index = anim.next;
+    frame.delay = m_canvasInfo.delay;
+    frame.rect  = whole
+        ? sChunkData::DirtyRect{ 0, 0, m_canvas.width, m_canvas.height }
+        : sChunkData::DirtyRect{ x0, y0, x1 - x0, y1 - y0 };
+    frame.pitch = helpers::calculatePitch(frame.rect.w, m_canvas.bpp);
+    frame.pixels.resize(static_cast<size_t>(frame.pitch) * frame.rect.h);
+
+    const uint32_t bytesPerPixel = m_canvas.bpp / 8;
+    for (uint32_t y = 0; y < frame.rect.h; y++)
+    {
+        const auto src = m_canvas.rowPtr(frame.rect.y + y) + static_cast<size_t>(frame.rect.x) * bytesPerPixel;
+        ::memcpy(frame.pixels.data() + static_cast<size_t>(y) * frame.pitch, src, static_cast<size_t>(frame.rect.w) * bytesPerPixel);
+    }
+
+    // With a slot per frame the first round leaves all of them resident.
+    const uint32_t images = m_canvasInfo.images;
+    anim.next             = (anim.next + 1) % images;
+    anim.done             = anim.depth >= images && anim.produced + 1 >= images;
+
+    {
+        std::lock_guard<std::mutex> lock(m_framesMutex);
+        m_frames.push_back(std::move(frame));
+    }
+    m_callbacks->onFrameDecoded();
+
+    return anim.done == false;
+}
+
+bool cImageLoader::popFrame(Frame& frame)
+{
+    std::lock_guard<std::mutex> lock(m_framesMutex);
+    if (m_frames.empty())
+    {
+        return false;
+    }
+
+    frame = std::move(m_frames.front());
+    m_frames.pop_front();
+
+    return true;
+}
+
+void cImageLoader::setCurrentFrame(uint32_t index, uint32_t delay)
+{
+    m_info.current = index;
+    m_info.delay   = delay;
+}
+
 bool cImageLoader::isLoaded() const
 {
     if (m_chunk.bitmap.empty() && m_chunk.width == 0)
@@ -216,17 +705,22 @@ bool cImageLoader::isLoaded() const
     return m_activeReader != nullptr;
 }
 
+void cImageLoader::start(cThreadPool::Task job)
+{
+    m_previewWanted.store(false, std::memory_order_relaxed);
+    m_previewBuilder.reset();
+    m_stopToken.reset();
+    cThreadPool::shared().submit(m_job, std::move(job));
+}
+
 void cImageLoader::stop()
 {
-    if (m_loader.joinable())
+    if (m_job.isBusy())
     {
         const bool completed = m_completed.load(std::memory_order_acquire);
-        if (m_activeReader != nullptr)
-        {
-            m_activeReader->stop();
-        }
+        m_stopToken.request();
         const auto t0 = timing::seconds();
-        m_loader.join();
+        m_job.wait();
         if (m_config->debug && completed == false)
         {
             const double joinMs = (timing::seconds() - t0) * 1000.0;
@@ -235,8 +729,41 @@ void cImageLoader::stop()
     }
 }
 
+void cImageLoader::setConsumedHeight(uint32_t h)
+{
+    if (m_previewWanted.load(std::memory_order_acquire))
+    {
+        if (m_previewBuilder.isActive() == false && m_previewBuilder.begin(m_chunk) == false)
+        {
+            m_previewWanted.store(false, std::memory_order_relaxed);
+        }
+        m_previewBuilder.addRows(m_chunk, h);
+    }
+
+    m_chunk.consumedHeight.store(h, std::memory_order_release);
+}
+
+void cImageLoader::storePreview()
+{
+    if (m_previewWanted.exchange(false) && m_previewBuilder.isComplete())
+    {
+        auto& preview           = m_previewBuilder.getPreview();
+        preview.fullImageWidth  = m_info.fullWidth != 0 ? m_info.fullWidth : m_chunk.width;
+        preview.fullImageHeight = m_info.fullWidth != 0 ? m_info.fullHeight : m_chunk.height;
+        m_previewCache->store(m_path.c_str(), std::move(preview));
+    }
+    m_previewBuilder.reset();
+}
+
+void cImageLoader::releaseBitmap()
+{
+    storeChunk(false);
+    Buffer().swap(m_chunk.bitmap);
+}
+
 void cImageLoader::clear()
 {
+    storeChunk(false);
     m_chunk.reset();
     m_info = {};
 }
@@ -9,17 +9,24 @@
 
 #pragma once
 
+#include "BitmapCache.h"
+#include "Common/Callbacks.h"
 #include "Common/ChunkData.h"
 #include "Common/ImageInfo.h"
+#include "Common/StopToken.h"
+#include "Common/ThreadPool.h"
+#include "PreviewCache.h"
 
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
-#include <thread>
 #include <unordered_map>
+#include <vector>
 
 class cFormat;
-struct sCallbacks;
+class cImagePrefetcher;
 struct sConfig;
 struct sFormatEntry;
 
@@ -33,6 +40,10 @@ public:
         double iccMs = 0.0;
         double totalMs = 0.0;
         size_t bitmapBytes = 0;
+        bool prefetched = false;
+        bool cacheHit = false;
+        size_t cacheHits = 0;   // bitmap cache totals since start
+        size_t cacheMisses = 0;
 
         void reset()
         {
@@ -40,19 +51,54 @@ public:
         }
     };
 
+    // Animation frame decoded ahead: the canvas area that changed since
+    // the frame depth steps back (or the whole canvas), tightly packed.
+    struct Frame
+    {
+        uint32_t index = 0;
+        uint32_t delay = 0;
+        sChunkData::DirtyRect rect;
+        uint32_t pitch = 0;
+        Buffer pixels;
+    };
+
     explicit cImageLoader(const sConfig* config, sCallbacks* callbacks);
     ~cImageLoader();
 
-    void loadImage(const std::string& path);
+    // fitWidth × fitHeight is the box the image is shown fit into, formats
+    // that decode scaled down (JPEG, pyramidal TIFF) stop at the smallest
+    // size covering it. rerasterize(0, 0) decodes such an image at full size.
+    void loadImage(const std::string& path, uint32_t fitWidth = 0, uint32_t fitHeight = 0);
+    void prefetch(const std::vector<std::string>& paths);
     void loadSubImage(unsigned subImage);
     void rerasterize(uint32_t targetWidth, uint32_t targetHeight);
+    // Reads a window of a pyramid level, the raster covers only the part of
+    // the image on screen. The loaded info tells the window actually read.
+    void loadWindow(const sImageInfo::Window& window);
     bool isLoaded() const;
 
+    // Decodes the frames after the shown one on the pool, a few ahead of
+    // playback. They rotate through depth GPU slots, each frame carries the
+    // area changed since the slot's previous frame. Ends on the next load.
+    // Returns false while the shown frame is still loading.
+    bool startAnimation(uint32_t depth);
+    void stopAnimation();
+    bool isAnimationActive() const
+    {
+        return m_animation.depth != 0;
+    }
+    // Resumes decoding once frames were taken, call it after popFrame().
+    void decodeAhead();
+    bool popFrame(Frame& frame);
+    // The frame shown now, for the info bar and manual stepping.
+    void setCurrentFrame(uint32_t index, uint32_t delay);
+
     enum class Mode
     {
         Image,
         SubImage,
-        Rerasterize
+        Rerasterize,
+        Window
     };
     Mode getMode() const
     {
@@ -76,10 +122,12 @@ public:
         return m_chunk.readyHeight.load(std::memory_order_acquire);
     }
 
-    void setConsumedHeight(uint32_t h)
-    {
-        m_chunk.consumedHeight.store(h, std::memory_order_release);
-    }
+    // Rows below h may be overwritten by the decoder from now on.
+    void setConsumedHeight(uint32_t h);
+
+    // Hands the preview sampled from the consumed rows to the preview
+    // cache, call it once the final upload of a loaded image completed.
+    void storePreview();
 
     const uint8_t* getBitmapData() const
     {
@@ -91,10 +139,8 @@ public:
         return m_chunk.bitmap.empty() == false;
     }
 
-    void releaseBitmap()
-    {
-        Buffer().swap(m_chunk.bitmap);
-    }
+    // Frees the bitmap, handing it to the bitmap cache when possible.
+    void releaseBitmap();
 
     const Metrics& getMetrics() const
     {
@@ -109,21 +155,65 @@ public:
 private:
     cFormat* getOrCreateReader(const sFormatEntry& entry);
 
+    void start(cThreadPool::Task job);
     void stop();
     void clear();
+    void signalDecoded();
+    bool loadCached(const cBitmapCache::Key& key);
+    bool loadPrefetched(const char* path);
+    bool primeReader();
+    bool decodeSubImage(uint32_t subImage);
+    bool fetchSubImage(uint32_t subImage, uint32_t targetWidth, uint32_t targetHeight);
+    bool makeChunkKey(uint32_t subImage, uint32_t targetWidth, uint32_t targetHeight, cBitmapCache::Key& key) const;
+    void setChunkKey(const cBitmapCache::Key& key);
+    void storeChunk(bool copy);
+    bool seekCanvas(uint32_t frame);
+    bool decodeFrame();
+    void resetAnimation();
     bool loadFromFile(const char* path);
     void load(const char* path);
 
 private:
     const sConfig* m_config;
     sCallbacks* m_callbacks;
+    sCallbacks m_silentCallbacks;
 
     Mode m_mode = Mode::Image;
-    std::thread m_loader;
+    cTaskGroup m_job;
+    cStopToken m_stopToken;
     cFormat* m_activeReader = nullptr;
+    const sFormatEntry* m_activeFormat = nullptr;
     std::unordered_map<std::string, std::unique_ptr<cFormat>> m_formatCache;
+    std::unique_ptr<cPreviewCache> m_previewCache;
+    cPreviewBuilder m_previewBuilder;           // viewer thread only
+    std::atomic<bool> m_previewWanted{ false }; // no cache entry yet for m_path
+    std::unique_ptr<cImagePrefetcher> m_prefetcher;
+    std::unique_ptr<cBitmapCache> m_cache;
+
+    uint32_t m_fitWidth = 0;
+    uint32_t m_fitHeight = 0;
+    std::string m_path;         // local file of the current image, empty if not cacheable
+    bool m_readerPrimed = false; // m_activeReader has opened m_path
+    int m_readerFrame = -1;      // last sub-image decoded by m_activeReader
+    cBitmapCache::Key m_chunkKey;
+    bool m_chunkCacheable = false;
     sChunkData m_chunk;
     sImageInfo m_info;
     Metrics m_metrics;
     std::atomic<bool> m_completed{ false };
+
+    struct Animation
+    {
+        uint32_t depth    = 0;     // GPU slots the frames rotate through, 0 = inactive
+        uint32_t next     = 0;     // frame to decode next
+        uint32_t produced = 0;     // frames decoded since start
+        bool synced       = false; // m_canvas holds the shown frame
+        bool done         = false; // every frame resident or decoding failed
+        std::deque<sChunkData::DirtyRect> history; // changed areas of the last depth frames
+    };
+    Animation m_animation;
+    sChunkData m_canvas; // decode-ahead copy of m_chunk, composited by the reader
+    sImageInfo m_canvasInfo;
+    std::mutex m_framesMutex;
+    std::deque<Frame> m_frames;
 };
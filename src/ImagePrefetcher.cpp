@@ -0,0 +1,316 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "ImagePrefetcher.h"
+#include "Common/Config.h"
+#include "Common/File.h"
+#include "Common/Timing.h"
+#include "Formats/Format.h"
+#include "Formats/FormatRegistry.h"
+#include "Log/Log.h"
+#include "Network/Curl.h"
+#include "PreviewCache.h"
+
+#include <algorithm>
+
+cImagePrefetcher::cImagePrefetcher(const sConfig* config, cPreviewCache* previewCache)
+    : m_config(config)
+    , m_previewCache(previewCache)
+    , m_budget(static_cast<size_t>(config->prefetchMemoryMb) * 1024 * 1024)
+    , m_callbacks(sCallbacks::makeSilent())
+{
+}
+
+cImagePrefetcher::~cImagePrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        cancel(m_current);
+    }
+
+    m_job.wait();
+}
+
+void cImagePrefetcher::schedule(const std::vector<std::string>& paths)
+{
+    if (m_budget == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_wanted = paths;
+
+    for (size_t i = m_entries.size(); i-- > 0;)
+    {
+        if (getPriority(m_entries[i]->path) == std::string::npos)
+        {
+            erase(i);
+        }
+    }
+
+    m_skipped.erase(std::remove_if(m_skipped.begin(), m_skipped.end(), [this](const std::string& path) {
+                        return getPriority(path) == std::string::npos;
+                    }),
+                    m_skipped.end());
+
+    // Direction changed or jumped away: the in-flight decode is useless.
+    if (getPriority(m_current) == std::string::npos)
+    {
+        cancel(m_current);
+    }
+
+    kick();
+}
+
+void cImagePrefetcher::setPaused(bool paused)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paused = paused;
+    kick();
+}
+
+const sFormatEntry* cImagePrefetcher::take(const std::string& path, sChunkData& chunk, sImageInfo& info)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t i = 0, count = m_entries.size(); i < count; i++)
+    {
+        auto& entry = *m_entries[i];
+        if (entry.path == path)
+        {
+            auto format = entry.format;
+            chunk.moveFrom(entry.chunk);
+            info = std::move(entry.info);
+            erase(i);
+            return format;
+        }
+    }
+
+    // The foreground loader decodes it anyway, don't do the work twice.
+    cancel(path);
+
+    return nullptr;
+}
+
+void cImagePrefetcher::cancel(const std::string& path)
+{
+    if (m_current.empty() == false && m_current == path)
+    {
+        m_stopToken.request();
+    }
+}
+
+void cImagePrefetcher::kick()
+{
+    // One decode per task, so the pool interleaves prefetching with other work.
+    if (m_running || m_quit || m_paused || getNextJob() == nullptr)
+    {
+        return;
+    }
+
+    m_running = true;
+    cThreadPool::shared().submit(m_job, [this] {
+        work();
+    });
+}
+
+void cImagePrefetcher::work()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto next = getNextJob();
+    if (m_quit || m_paused || next == nullptr)
+    {
+        m_running = false;
+        return;
+    }
+
+    auto entry  = std::make_unique<Entry>();
+    entry->path = *next;
+    m_current   = entry->path;
+    m_stopToken.reset();
+
+    lock.unlock();
+    const auto t0     = timing::seconds();
+    const bool result = decode(*entry);
+    const auto ms     = (timing::seconds() - t0) * 1000.0;
+    lock.lock();
+
+    m_current.clear();
+
+    if (m_stopToken.isRequested())
+    {
+        if (m_config->debug)
+        {
+            cLog::Debug("  prefetch:   cancelled '{}'", entry->path);
+        }
+    }
+    else if (result == false)
+    {
+        m_skipped.push_back(entry->path);
+    }
+    else
+    {
+        if (m_config->debug)
+        {
+            cLog::Debug("  prefetch:   '{}' {:.1f} ms, {:.1f} MB", entry->path, ms, entry->bytes / (1024.0 * 1024.0));
+        }
+        insert(std::move(entry));
+    }
+
+    m_running = false;
+    kick();
+}
+
+bool cImagePrefetcher::decode(Entry& entry)
+{
+    const char* path = entry.path.c_str();
+
+    cCurl curl;
+    if (curl.isUrl(path))
+    {
+        return false;
+    }
+
+    cFile file;
+    if (file.open(path) == false)
+    {
+        return false;
+    }
+
+    Buffer buffer;
+    auto format = FormatRegistry::detect(file, buffer);
+    if (format == nullptr)
+    {
+        return false;
+    }
+
+    auto reader = getOrCreateReader(*format);
+
+    entry.chunk.fullBitmap = true;
+    if (reader->Load(path, entry.chunk, entry.info) == false)
+    {
+        return false;
+    }
+
+    m_previewCache->store(path, entry.chunk, entry.info);
+
+    // Sub-images and re-rasterization need the reader state the foreground
+    // loader owns, so only single still images can be handed off.
+    auto& info = entry.info;
+    if (info.isAnimation || info.isVector || info.levels.empty() == false || info.images > 1)
+    {
+        return false;
+    }
+    info.images = 1;
+
+    entry.format = format;
+    entry.bytes  = entry.chunk.bitmap.size() + entry.chunk.lutData.size() + entry.chunk.palette.size();
+
+    return true;
+}
+
+void cImagePrefetcher::insert(std::unique_ptr<Entry> entry)
+{
+    const auto priority = getPriority(entry->path);
+    if (priority == std::string::npos)
+    {
+        return;
+    }
+
+    if (entry->bytes > m_budget)
+    {
+        m_skipped.push_back(entry->path);
+        return;
+    }
+
+    // Evict lower priority entries until the new one fits.
+    while (m_bytes + entry->bytes > m_budget)
+    {
+        size_t victim         = 0;
+        size_t victimPriority = 0;
+        for (size_t i = 0, count = m_entries.size(); i < count; i++)
+        {
+            const auto p = getPriority(m_entries[i]->path);
+            if (p >= victimPriority)
+            {
+                victim         = i;
+                victimPriority = p;
+            }
+        }
+
+        if (m_entries.empty() || victimPriority < priority)
+        {
+            m_skipped.push_back(entry->path);
+            return;
+        }
+
+        erase(victim);
+    }
+
+    m_bytes += entry->bytes;
+    m_entries.push_back(std::move(entry));
+}
+
+void cImagePrefetcher::erase(size_t index)
+{
+    m_bytes -= m_entries[index]->bytes;
+    m_entries.erase(m_entries.begin() + index);
+}
+
+cFormat* cImagePrefetcher::getOrCreateReader(const sFormatEntry& entry)
+{
+    auto it = m_formatCache.find(entry.name);
+    if (it != m_formatCache.end())
+    {
+        return it->second.get();
+    }
+
+    auto reader = entry.factory(&m_callbacks);
+    reader->setConfig(m_config);
+    reader->setStopToken(&m_stopToken);
+    auto* ptr = reader.get();
+    m_formatCache.emplace(entry.name, std::move(reader));
+    return ptr;
+}
+
+size_t cImagePrefetcher::getPriority(const std::string& path) const
+{
+    auto it = std::find(m_wanted.begin(), m_wanted.end(), path);
+    return it != m_wanted.end()
+        ? static_cast<size_t>(it - m_wanted.begin())
+        : std::string::npos;
+}
+
+bool cImagePrefetcher::isCached(const std::string& path) const
+{
+    return std::any_of(m_entries.begin(), m_entries.end(), [&path](const std::unique_ptr<Entry>& entry) {
+        return entry->path == path;
+    });
+}
+
+bool cImagePrefetcher::isSkipped(const std::string& path) const
+{
+    return std::find(m_skipped.begin(), m_skipped.end(), path) != m_skipped.end();
+}
+
+const std::string* cImagePrefetcher::getNextJob() const
+{
+    for (const auto& path : m_wanted)
+    {
+        if (isCached(path) == false && isSkipped(path) == false)
+        {
+            return &path;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,95 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include "Common/Callbacks.h"
+#include "Common/ChunkData.h"
+#include "Common/ImageInfo.h"
+#include "Common/StopToken.h"
+#include "Common/ThreadPool.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class cFormat;
+class cPreviewCache;
+struct sConfig;
+struct sFormatEntry;
+
+// Decodes neighbouring files one at a time on the shared thread pool and
+// keeps finished bitmaps in a byte-budgeted cache, so navigation becomes
+// a hand-off.
+class cImagePrefetcher final
+{
+public:
+    cImagePrefetcher(const sConfig* config, cPreviewCache* previewCache);
+    ~cImagePrefetcher();
+
+    // Replace the prefetch window (paths ordered by priority). Cached entries
+    // and an in-flight decode that fall out of the window are dropped.
+    void schedule(const std::vector<std::string>& paths);
+
+    // Hold back new decodes while the foreground loader is busy.
+    void setPaused(bool paused);
+
+    // Move a finished image out of the cache. Returns the format it was
+    // decoded with, or nullptr on miss.
+    const sFormatEntry* take(const std::string& path, sChunkData& chunk, sImageInfo& info);
+
+private:
+    struct Entry
+    {
+        std::string path;
+        const sFormatEntry* format = nullptr;
+        sChunkData chunk;
+        sImageInfo info;
+        size_t bytes = 0;
+    };
+
+    void kick();
+    void work();
+    void cancel(const std::string& path);
+    bool decode(Entry& entry);
+    void insert(std::unique_ptr<Entry> entry);
+    void erase(size_t index);
+    cFormat* getOrCreateReader(const sFormatEntry& entry);
+
+    size_t getPriority(const std::string& path) const;
+    bool isCached(const std::string& path) const;
+    bool isSkipped(const std::string& path) const;
+    const std::string* getNextJob() const;
+
+private:
+    const sConfig* m_config;
+    cPreviewCache* m_previewCache;
+    const size_t m_budget;
+    sCallbacks m_callbacks; // no-op, background decodes are invisible
+
+    std::unordered_map<std::string, std::unique_ptr<cFormat>> m_formatCache;
+
+    std::mutex m_mutex;
+    cTaskGroup m_job;
+    bool m_running = false; // a decode task is queued or running
+    bool m_quit    = false;
+    bool m_paused  = false;
+
+    std::vector<std::string> m_wanted;  // current window in priority order
+    std::vector<std::string> m_skipped; // failed or not cacheable (animated, vector, too large)
+
+    std::string m_current; // path being decoded
+    cStopToken m_stopToken;
+
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    size_t m_bytes = 0;
+};
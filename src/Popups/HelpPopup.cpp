@@ -61,6 +61,8 @@ namespace
         { "<shift>+<r>", "rotate counterclockwise" },
         { "<f>", "flip horizontal" },
         { "<shift>+<f>", "flip vertical" },
+        { "<[> / <]>", "decrease / increase HDR exposure" },
+        { "<\\>", "reset HDR exposure" },
     };
 
     constexpr KeyBinding PanBindings[] = {
@@ -0,0 +1,546 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "PreviewCache.h"
+#include "BitmapCache.h"
+#include "Common/Callbacks.h"
+#include "Common/ChunkData.h"
+#include "Common/Config.h"
+#include "Common/File.h"
+#include "Common/Helpers.h"
+#include "Common/ImageInfo.h"
+#include "Common/Timing.h"
+#include "Common/YCbCr.h"
+#include "Log/Log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <lz4/lz4.h>
+#include <lz4/xxhash.h>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <vector>
+
+namespace
+{
+    constexpr char Magic[4]         = { 'S', 'V', 'P', 'C' };
+    constexpr uint32_t Version      = 1;
+    constexpr uint32_t PreviewSize  = 256; // longest side of a stored preview
+    constexpr uint32_t MinImageSize = PreviewSize * 2;
+    constexpr const char* Extension = ".svpc";
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t keySize;
+        uint32_t width;
+        uint32_t height;
+        uint32_t fullWidth;
+        uint32_t fullHeight;
+        uint32_t rawSize;
+        uint32_t packedSize;
+    };
+
+    constexpr uint32_t Samples = 4; // per axis and output pixel
+
+} // namespace
+
+bool cPreviewBuilder::getLayout(const sChunkData& chunk, Layout& layout)
+{
+    switch (chunk.format)
+    {
+    case ePixelFormat::RGB:
+        layout = { 3, 0, 1, 2, -1 };
+        break;
+    case ePixelFormat::RGBA:
+        layout = { 4, 0, 1, 2, 3 };
+        break;
+    case ePixelFormat::BGR:
+        layout = { 3, 2, 1, 0, -1 };
+        break;
+    case ePixelFormat::BGRA:
+        layout = { 4, 2, 1, 0, 3 };
+        break;
+    case ePixelFormat::Luminance:
+        layout = { 1, 0, 0, 0, -1 };
+        break;
+    case ePixelFormat::LuminanceAlpha:
+        layout = { 2, 0, 0, 0, 1 };
+        break;
+    case ePixelFormat::YCbCr420:
+    case ePixelFormat::YCbCr422:
+        // Sampled pixels are converted to RGB first.
+        layout = { 3, 0, 1, 2, -1 };
+        return true;
+    case ePixelFormat::Indexed8:
+        // Indices are looked up in the RGBA palette.
+        layout = { 4, 0, 1, 2, 3 };
+        return chunk.palette.size() >= 256 * 4;
+    default:
+        return false;
+    }
+
+    return chunk.bpp == layout.bytes * 8;
+}
+
+bool cPreviewBuilder::begin(const sChunkData& chunk)
+{
+    reset();
+
+    const uint32_t bandHeight = chunk.bandHeight != 0 ? chunk.bandHeight : chunk.height;
+    if (std::max(chunk.width, chunk.height) < MinImageSize
+        || chunk.isCompressedTexture
+        || chunk.bitmap.size() < static_cast<size_t>(chunk.pitch) * bandHeight
+        || (chunk.effects & eEffect::Cmyk)
+        || getLayout(chunk, m_layout) == false)
+    {
+        return false;
+    }
+
+    const float scale = static_cast<float>(PreviewSize) / std::max(chunk.width, chunk.height);
+
+    m_preview.width  = std::max(1u, static_cast<uint32_t>(chunk.width * scale));
+    m_preview.height = std::max(1u, static_cast<uint32_t>(chunk.height * scale));
+    m_preview.bpp    = 32;
+    m_preview.pitch  = m_preview.width * 4;
+    m_preview.format = ePixelFormat::RGBA;
+    m_preview.bitmap.resize(static_cast<size_t>(m_preview.pitch) * m_preview.height);
+
+    m_height = chunk.height;
+    m_stepX  = static_cast<float>(chunk.width) / m_preview.width;
+    m_stepY  = static_cast<float>(chunk.height) / m_preview.height;
+    m_sums.assign(static_cast<size_t>(m_preview.width) * 4, 0);
+
+    return true;
+}
+
+void cPreviewBuilder::reset()
+{
+    m_rows    = 0;
+    m_sample  = 0;
+    m_preview = {};
+    m_sums    = {};
+}
+
+bool cPreviewBuilder::isComplete() const
+{
+    return isActive() && m_sample == m_preview.height * Samples;
+}
+
+uint32_t cPreviewBuilder::getSourceRow(uint32_t sample) const
+{
+    const uint32_t y  = sample / Samples;
+    const uint32_t sy = sample % Samples;
+    return std::min(m_height - 1, static_cast<uint32_t>((y + (sy + 0.5f) / Samples) * m_stepY));
+}
+
+void cPreviewBuilder::addRows(const sChunkData& chunk, uint32_t rows)
+{
+    if (isActive() == false)
+    {
+        return;
+    }
+
+    if (rows < m_rows)
+    {
+        m_sample = 0;
+        std::fill(m_sums.begin(), m_sums.end(), 0);
+    }
+    m_rows = rows;
+
+    // Sample rows only go down, each one is read while still in the band.
+    const uint32_t samples = m_preview.height * Samples;
+    while (m_sample < samples)
+    {
+        const uint32_t srcY = getSourceRow(m_sample);
+        if (srcY >= rows)
+        {
+            break;
+        }
+
+        sampleRow(chunk, srcY);
+        m_sample++;
+        if (m_sample % Samples == 0)
+        {
+            storeRow(chunk, m_sample / Samples - 1);
+        }
+    }
+}
+
+void cPreviewBuilder::sampleRow(const sChunkData& chunk, uint32_t srcY)
+{
+    auto getRow = [&chunk](uint32_t y) {
+        return chunk.bandHeight != 0
+            ? chunk.rowPtr(y)
+            : chunk.bitmap.data() + static_cast<size_t>(y) * chunk.pitch;
+    };
+
+    const bool planar  = ycbcr::isPlanar(chunk.format);
+    const bool indexed = chunk.format == ePixelFormat::Indexed8;
+    const auto planes  = ycbcr::getLayout(chunk.format, chunk.width);
+
+    // Chroma is on the luma row its chroma row starts at.
+    const auto row    = getRow(srcY);
+    const auto chroma = planar ? getRow(srcY - srcY % planes.factorY) : row;
+
+    auto sum = m_sums.data();
+    for (uint32_t x = 0; x < m_preview.width; x++)
+    {
+        for (uint32_t sx = 0; sx < Samples; sx++)
+        {
+            const auto srcX = std::min(chunk.width - 1, static_cast<uint32_t>((x + (sx + 0.5f) / Samples) * m_stepX));
+
+            uint8_t rgb[3];
+            const uint8_t* p = rgb;
+            if (planar)
+            {
+                const auto cx = srcX / planes.factorX;
+                ycbcr::toRgb(row[srcX], chroma[planes.cbOffset + cx], chroma[planes.crOffset + cx], rgb);
+            }
+            else if (indexed)
+            {
+                p = &chunk.palette[row[srcX] * 4];
+            }
+            else
+            {
+                p = row + static_cast<size_t>(srcX) * m_layout.bytes;
+            }
+            sum[0] += p[m_layout.r];
+            sum[1] += p[m_layout.g];
+            sum[2] += p[m_layout.b];
+            sum[3] += m_layout.a >= 0 ? p[m_layout.a] : 255;
+        }
+        sum += 4;
+    }
+}
+
+void cPreviewBuilder::storeRow(const sChunkData& chunk, uint32_t y)
+{
+    const bool unpremultiply = chunk.effects & eEffect::Unpremultiply;
+
+    constexpr uint32_t Count = Samples * Samples;
+
+    auto sum = m_sums.data();
+    auto dst = m_preview.bitmap.data() + static_cast<size_t>(y) * m_preview.pitch;
+    for (uint32_t x = 0; x < m_preview.width; x++)
+    {
+        const uint32_t a = sum[3] / Count;
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            uint32_t v = sum[c] / Count;
+            if (unpremultiply && a != 0)
+            {
+                v = std::min(255u, v * 255 / a);
+            }
+            dst[c] = static_cast<uint8_t>(v);
+        }
+        dst[3] = static_cast<uint8_t>(a);
+        dst += 4;
+        sum += 4;
+    }
+
+    std::fill(m_sums.begin(), m_sums.end(), 0);
+}
+
+cPreviewCache::cPreviewCache(const sConfig* config)
+    : m_config(config)
+    , m_budget(static_cast<size_t>(config->previewCacheMb) * 1024 * 1024)
+{
+    if (m_budget != 0)
+    {
+        m_directory = helpers::getCacheDirectory("previews");
+        if (m_directory.empty())
+        {
+            cLog::Error("Can't create preview cache directory.");
+        }
+    }
+}
+
+cPreviewCache::~cPreviewCache()
+{
+    m_tasks.wait();
+}
+
+bool cPreviewCache::makeFileName(const char* path, std::string& key, std::string& fileName) const
+{
+    cBitmapCache::Key fileKey;
+    if (isEnabled() == false || cBitmapCache::makeKey(path, fileKey) == false)
+    {
+        return false;
+    }
+
+    key = fileKey.path + "\n" + std::to_string(fileKey.fileSize) + "\n" + std::to_string(fileKey.mtime);
+
+    char name[32];
+    ::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(XXH64(key.data(), key.size(), 0)));
+    fileName = m_directory + "/" + name + Extension;
+
+    return true;
+}
+
+bool cPreviewCache::load(const char* path, sPreviewData& preview)
+{
+    const auto t0 = timing::seconds();
+
+    std::string key;
+    std::string fileName;
+    if (makeFileName(path, key, fileName) == false)
+    {
+        return false;
+    }
+
+    cFile file;
+    if (file.open(fileName.c_str()) == false)
+    {
+        return false;
+    }
+
+    Header header;
+    if (file.read(&header, sizeof(header)) != sizeof(header)
+        || ::memcmp(header.magic, Magic, sizeof(Magic)) != 0
+        || header.version != Version
+        || header.keySize != key.size()
+        || header.rawSize != header.width * header.height * 4)
+    {
+        return false;
+    }
+
+    // Hash collision or stale entry.
+    std::string storedKey(header.keySize, '\0');
+    if (file.read(&storedKey[0], header.keySize) != header.keySize || storedKey != key)
+    {
+        return false;
+    }
+
+    std::vector<char> packed(header.packedSize);
+    if (file.read(packed.data(), header.packedSize) != header.packedSize)
+    {
+        return false;
+    }
+
+    preview.bitmap.resize(header.rawSize);
+    const int unpacked = LZ4_decompress_safe(packed.data(), reinterpret_cast<char*>(preview.bitmap.data()),
+                                             static_cast<int>(header.packedSize), static_cast<int>(header.rawSize));
+    if (unpacked != static_cast<int>(header.rawSize))
+    {
+        cLog::Error("Corrupted preview cache entry '{}'.", fileName);
+        ::unlink(fileName.c_str());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(fileName);
+        if (it != m_entries.end())
+        {
+            m_total -= it->second.size;
+            m_entries.erase(it);
+        }
+        return false;
+    }
+
+    preview.width           = header.width;
+    preview.height          = header.height;
+    preview.bpp             = 32;
+    preview.pitch           = header.width * 4;
+    preview.format          = ePixelFormat::RGBA;
+    preview.fullImageWidth  = header.fullWidth;
+    preview.fullImageHeight = header.fullHeight;
+
+    // Recently used entries survive eviction.
+    ::utime(fileName.c_str(), nullptr);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(fileName);
+        if (it != m_entries.end())
+        {
+            it->second.lastUsed = ::time(nullptr);
+        }
+    }
+
+    if (m_config->debug)
+    {
+        cLog::Debug("  preview:    cached {}x{}, {:.1f} ms", header.width, header.height, (timing::seconds() - t0) * 1000.0);
+    }
+
+    return true;
+}
+
+void cPreviewCache::store(const char* path, sPreviewData&& preview)
+{
+    std::string key;
+    std::string fileName;
+    if (preview.width == 0 || makeFileName(path, key, fileName) == false || ::access(fileName.c_str(), F_OK) == 0)
+    {
+        return;
+    }
+
+    queue(std::move(key), std::move(fileName), std::move(preview));
+}
+
+void cPreviewCache::store(const char* path, const sChunkData& chunk, const sImageInfo& info)
+{
+    if (chunk.bandHeight != 0 && chunk.bandHeight < chunk.height)
+    {
+        return;
+    }
+
+    std::string key;
+    std::string fileName;
+    if (makeFileName(path, key, fileName) == false || ::access(fileName.c_str(), F_OK) == 0)
+    {
+        return;
+    }
+
+    cPreviewBuilder builder;
+    if (builder.begin(chunk) == false)
+    {
+        return;
+    }
+    builder.addRows(chunk, chunk.height);
+
+    auto& preview           = builder.getPreview();
+    preview.fullImageWidth  = info.fullWidth != 0 ? info.fullWidth : chunk.width;
+    preview.fullImageHeight = info.fullWidth != 0 ? info.fullHeight : chunk.height;
+
+    queue(std::move(key), std::move(fileName), std::move(preview));
+}
+
+void cPreviewCache::queue(std::string&& key, std::string&& fileName, sPreviewData&& preview)
+{
+    // Tasks must be copyable, the pixels are shared rather than copied.
+    auto data = std::make_shared<sPreviewData>(std::move(preview));
+    cThreadPool::shared().submit(m_tasks, [this, key = std::move(key), fileName = std::move(fileName), data] {
+        write(key, fileName, *data);
+    });
+}
+
+void cPreviewCache::write(const std::string& key, const std::string& fileName, const sPreviewData& preview)
+{
+    const auto rawSize = static_cast<int>(preview.bitmap.size());
+    std::vector<char> packed(LZ4_compressBound(rawSize));
+    const int packedSize = LZ4_compress_default(reinterpret_cast<const char*>(preview.bitmap.data()), packed.data(),
+                                                rawSize, static_cast<int>(packed.size()));
+    if (packedSize <= 0)
+    {
+        return;
+    }
+
+    Header header;
+    ::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version    = Version;
+    header.keySize    = static_cast<uint32_t>(key.size());
+    header.width      = preview.width;
+    header.height     = preview.height;
+    header.fullWidth  = preview.fullImageWidth;
+    header.fullHeight = preview.fullImageHeight;
+    header.rawSize    = static_cast<uint32_t>(rawSize);
+    header.packedSize = static_cast<uint32_t>(packedSize);
+
+    // Write to a temporary name so readers never see a partial entry.
+    const auto tmpName = fileName + ".tmp";
+    auto file          = ::fopen(tmpName.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    const bool written = ::fwrite(&header, sizeof(header), 1, file) == 1
+        && ::fwrite(key.data(), key.size(), 1, file) == 1
+        && ::fwrite(packed.data(), packedSize, 1, file) == 1;
+    ::fclose(file);
+
+    if (written == false || ::rename(tmpName.c_str(), fileName.c_str()) != 0)
+    {
+        ::unlink(tmpName.c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_isScanned == false)
+    {
+        scan();
+    }
+    else
+    {
+        const size_t size = sizeof(header) + key.size() + static_cast<size_t>(packedSize);
+        auto& entry       = m_entries[fileName];
+        m_total           = m_total - entry.size + size;
+        entry             = { ::time(nullptr), size };
+    }
+
+    if (m_total > m_budget)
+    {
+        evict();
+    }
+}
+
+void cPreviewCache::scan()
+{
+    m_isScanned = true;
+
+    auto dir = ::opendir(m_directory.c_str());
+    if (dir == nullptr)
+    {
+        return;
+    }
+
+    const size_t extLength = ::strlen(Extension);
+    while (auto entry = ::readdir(dir))
+    {
+        const size_t length = ::strlen(entry->d_name);
+        if (length <= extLength || ::strcmp(entry->d_name + length - extLength, Extension) != 0)
+        {
+            continue;
+        }
+
+        auto path = m_directory + "/" + entry->d_name;
+        struct stat st;
+        if (::stat(path.c_str(), &st) == 0)
+        {
+            const auto size = static_cast<size_t>(st.st_size);
+            m_entries[std::move(path)] = { st.st_mtime, size };
+            m_total += size;
+        }
+    }
+    ::closedir(dir);
+}
+
+void cPreviewCache::evict()
+{
+    // Drop least recently used entries down to 90% of the budget.
+    std::vector<std::pair<time_t, const std::string*>> items;
+    items.reserve(m_entries.size());
+    for (const auto& entry : m_entries)
+    {
+        items.push_back({ entry.second.lastUsed, &entry.first });
+    }
+    std::sort(items.begin(), items.end());
+
+    std::vector<std::string> removed;
+    const size_t target = m_budget / 10 * 9;
+    for (const auto& item : items)
+    {
+        if (m_total <= target)
+        {
+            break;
+        }
+        // Entries deleted behind our back don't count any more either.
+        ::unlink(item.second->c_str());
+        m_total -= m_entries[*item.second].size;
+        removed.push_back(*item.second);
+    }
+
+    for (const auto& path : removed)
+    {
+        m_entries.erase(path);
+    }
+}
@@ -0,0 +1,124 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include "Common/Callbacks.h"
+#include "Common/ThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct sChunkData;
+struct sConfig;
+struct sImageInfo;
+
+// Box-filtered RGBA preview sampled from rows as they arrive, so banded
+// images are covered before the ring reuses their rows.
+class cPreviewBuilder final
+{
+public:
+    // False if the chunk is too small or its format isn't supported.
+    bool begin(const sChunkData& chunk);
+    void reset();
+
+    // Samples rows up to `rows`, rows are expected in order. A lower count
+    // than before starts over (refinement passes rewrite the image).
+    void addRows(const sChunkData& chunk, uint32_t rows);
+
+    bool isActive() const
+    {
+        return m_preview.width != 0;
+    }
+
+    bool isComplete() const;
+
+    sPreviewData& getPreview()
+    {
+        return m_preview;
+    }
+
+private:
+    struct Layout
+    {
+        uint32_t bytes; // bytes per pixel
+        int r;          // channel offsets, -1 = absent
+        int g;
+        int b;
+        int a;
+    };
+
+    static bool getLayout(const sChunkData& chunk, Layout& layout);
+    uint32_t getSourceRow(uint32_t sample) const;
+    void sampleRow(const sChunkData& chunk, uint32_t srcY);
+    void storeRow(const sChunkData& chunk, uint32_t y);
+
+private:
+    Layout m_layout     = {};
+    uint32_t m_rows     = 0; // source rows seen
+    uint32_t m_sample   = 0; // next sample row, preview row * Samples + sub-row
+    uint32_t m_height   = 0; // source height
+    float m_stepX       = 0.0f;
+    float m_stepY       = 0.0f;
+    std::vector<uint32_t> m_sums;
+    sPreviewData m_preview;
+};
+
+// Persistent LZ4-compressed previews, one file per image keyed by
+// path + size + mtime, so the first paint doesn't wait for the decoder.
+class cPreviewCache final
+{
+public:
+    explicit cPreviewCache(const sConfig* config);
+    ~cPreviewCache();
+
+    bool isEnabled() const
+    {
+        return m_directory.empty() == false;
+    }
+
+    bool load(const char* path, sPreviewData& preview);
+
+    // Compresses and writes a built preview on the pool.
+    void store(const char* path, sPreviewData&& preview);
+
+    // Downscales a fully decoded chunk and queues it for the cache.
+    void store(const char* path, const sChunkData& chunk, const sImageInfo& info);
+
+private:
+    bool makeFileName(const char* path, std::string& key, std::string& fileName) const;
+    void queue(std::string&& key, std::string&& fileName, sPreviewData&& preview);
+    void write(const std::string& key, const std::string& fileName, const sPreviewData& preview);
+    void scan();
+    void evict();
+
+private:
+    const sConfig* m_config;
+    const size_t m_budget;
+    std::string m_directory;
+
+    struct Entry
+    {
+        time_t lastUsed;
+        size_t size;
+    };
+
+    // Entries on disk by file name, read once by the first store.
+    std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    size_t m_total   = 0;
+    bool m_isScanned = false;
+
+    cTaskGroup m_tasks; // pending writes, waited for on destruction
+};
@@ -19,6 +19,10 @@ public:
 
     void show();
     void hide();
+    bool isVisible() const
+    {
+        return m_visible;
+    }
 
     void setStatus(const std::string& text);
     void setPercent(float progress);
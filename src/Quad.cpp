@@ -11,6 +11,7 @@
 \**********************************************/
 
 #include "Quad.h"
+#include "Common/YCbCr.h"
 
 #include <cmath>
 
@@ -20,6 +21,7 @@ cQuad::cQuad(uint32_t tw, uint32_t th, const uint8_t* data, ePixelFormat bitmapF
     , m_format(bitmapFormat)
     , m_size(tw, th)
     , m_filter(true)
+    , m_mipmaps(false)
 {
     if (data != nullptr)
     {
@@ -31,24 +33,28 @@ cQuad::cQuad(uint32_t tw, uint32_t th, const uint8_t* data, ePixelFormat bitmapF
     setSpriteSize({ static_cast<float>(tw), static_cast<float>(th) });
 }
 
-cQuad::cQuad(uint32_t tw, uint32_t th, const uint8_t* data, GLenum internalFormat, uint32_t dataSize)
+cQuad::cQuad(uint32_t tw, uint32_t th, const uint8_t* data, eCompressedFormat format, uint32_t dataSize)
     : m_tw(tw)
     , m_th(th)
     , m_format(ePixelFormat::RGBA)
     , m_size(tw, th)
     , m_filter(true)
+    , m_mipmaps(false)
 {
     m_quad.tex = render::createTexture();
-    render::setCompressedData(m_quad.tex, data, tw, th, internalFormat, dataSize);
+    render::setCompressedData(m_quad.tex, data, tw, th, format, dataSize);
 
     setSpriteSize({ static_cast<float>(tw), static_cast<float>(th) });
 }
 
 cQuad::~cQuad()
 {
-    if (m_quad.tex != 0)
+    for (auto tex : getTextures())
     {
-        render::deleteTexture(m_quad.tex);
+        if (tex != 0)
+        {
+            render::deleteTexture(tex);
+        }
     }
 }
 
@@ -59,22 +65,53 @@ const Quad& cQuad::getQuad() const
 
 void cQuad::setData(const uint8_t* data)
 {
-    m_filter = true;
+    m_filter  = true;
+    m_mipmaps = false;
     if (data != nullptr && m_quad.tex == 0)
     {
         m_quad.tex = render::createTexture();
     }
-    render::setData(m_quad.tex, data, m_tw, m_th, m_format);
+
+    if (ycbcr::isPlanar(m_format))
+    {
+        if (data != nullptr && m_quad.chroma[0] == 0)
+        {
+            m_quad.chroma[0] = render::createTexture();
+            m_quad.chroma[1] = render::createTexture();
+        }
+        render::setPlanarData(m_quad.tex, m_quad.chroma[0], m_quad.chroma[1], data, m_tw, m_th, m_format);
+    }
+    else
+    {
+        render::setData(m_quad.tex, data, m_tw, m_th, m_format);
+    }
 }
 
 void cQuad::updateSubData(const uint8_t* data, uint32_t yOffset, uint32_t height)
 {
-    if (m_quad.tex != 0 && data != nullptr)
+    if (m_quad.tex == 0 || data == nullptr)
+    {
+        return;
+    }
+
+    if (ycbcr::isPlanar(m_format))
+    {
+        render::updatePlanarSubData(m_quad.tex, m_quad.chroma[0], m_quad.chroma[1], data, yOffset, m_tw, height, m_format);
+    }
+    else
     {
         render::updateSubData(m_quad.tex, data, yOffset, m_tw, height, m_format);
     }
 }
 
+void cQuad::updateRect(const uint8_t* data, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    if (m_quad.tex != 0 && data != nullptr && ycbcr::isPlanar(m_format) == false)
+    {
+        render::updateSubRect(m_quad.tex, data, x, y, w, h, m_format);
+    }
+}
+
 void cQuad::setColor(const cColor& color)
 {
     render::setColor(&m_quad, color);
@@ -148,22 +185,57 @@ void cQuad::renderEx(const Vectorf& pos, const Vectorf& size, int angle)
 }
 
 void cQuad::setupVertices(const Vectorf& pos)
+{
+    setupVertices(pos, m_size);
+}
+
+void cQuad::setupVertices(const Vectorf& pos, const Vectorf& size)
 {
     m_quad.v[0].x = pos.x;
     m_quad.v[0].y = pos.y;
-    m_quad.v[1].x = pos.x + m_size.x;
+    m_quad.v[1].x = pos.x + size.x;
     m_quad.v[1].y = pos.y;
-    m_quad.v[2].x = pos.x + m_size.x;
-    m_quad.v[2].y = pos.y + m_size.y;
+    m_quad.v[2].x = pos.x + size.x;
+    m_quad.v[2].y = pos.y + size.y;
     m_quad.v[3].x = pos.x;
-    m_quad.v[3].y = pos.y + m_size.y;
+    m_quad.v[3].y = pos.y + size.y;
+}
+
+void cQuad::generateMipmaps()
+{
+    // Averaged palette indices are meaningless.
+    if (m_quad.tex != 0 && m_format != ePixelFormat::Indexed8)
+    {
+        m_mipmaps = true;
+        for (auto tex : getTextures())
+        {
+            if (tex != 0)
+            {
+                render::generateMipmaps(tex);
+                render::setTextureFilter(tex, m_filter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST, GL_NEAREST);
+            }
+        }
+    }
 }
 
 void cQuad::useFilter(bool filter)
 {
-    if (m_filter != filter)
+    if (m_filter != filter && m_format != ePixelFormat::Indexed8)
     {
         m_filter = filter;
-        render::setTextureFilter(m_quad.tex, filter ? GL_LINEAR : GL_NEAREST, GL_NEAREST);
+
+        const GLenum linear = m_mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+        for (auto tex : getTextures())
+        {
+            if (tex != 0)
+            {
+                render::setTextureFilter(tex, filter ? linear : GL_NEAREST, GL_NEAREST);
+            }
+        }
     }
 }
+
+std::array<GLuint, 3> cQuad::getTextures() const
+{
+    return { m_quad.tex, m_quad.chroma[0], m_quad.chroma[1] };
+}
@@ -11,21 +11,29 @@
 
 #include "Renderer.h"
 
+#include <array>
+
 class cQuad
 {
 public:
     cQuad(uint32_t tw, uint32_t th, const uint8_t* data = 0, ePixelFormat bitmapFormat = ePixelFormat::RGB);
-    cQuad(uint32_t tw, uint32_t th, const uint8_t* data, GLenum internalFormat, uint32_t dataSize);
+    cQuad(uint32_t tw, uint32_t th, const uint8_t* data, eCompressedFormat format, uint32_t dataSize);
     virtual ~cQuad();
 
     virtual void setData(const uint8_t* data);
     virtual void updateSubData(const uint8_t* data, uint32_t yOffset, uint32_t height);
+    // Packed formats only, data rows are 4-byte aligned.
+    void updateRect(const uint8_t* data, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
     virtual void setColor(const cColor& color);
     virtual void setTextureRect(const Vectorf& pos, const Vectorf& size);
     virtual void setSpriteSize(const Vectorf& size);
     virtual void render(const Vectorf& pos);
     virtual void renderEx(const Vectorf& pos, const Vectorf& size, int rot = 0);
     void setupVertices(const Vectorf& pos);
+    void setupVertices(const Vectorf& pos, const Vectorf& size);
+
+    // Builds the mip chain from level 0, minification then samples it.
+    void generateMipmaps();
 
     const Quad& getQuad() const;
 
@@ -50,6 +58,10 @@ public:
         return m_format;
     }
 
+protected:
+    // The texture and, for planar YCbCr, the chroma planes.
+    std::array<GLuint, 3> getTextures() const;
+
 protected:
     // texture size
     uint32_t m_tw;
@@ -60,6 +72,7 @@ protected:
     Vectorf m_size;
 
     bool m_filter;
+    bool m_mipmaps;
 
     Quad m_quad;
 };
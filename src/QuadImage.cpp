@@ -10,12 +10,100 @@
 #include "QuadImage.h"
 #include "Common/Cms.h"
 #include "Common/Helpers.h"
+#include "Common/ThreadPool.h"
+#include "Common/Timing.h"
+#include "Common/YCbCr.h"
+#include "Formats/Libs/GpuDecode.h"
 #include "Log/Log.h"
 #include "Quad.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
 
+namespace
+{
+    float halfToFloat(uint16_t h)
+    {
+        const uint32_t sign     = static_cast<uint32_t>(h & 0x8000) << 16;
+        const uint32_t exponent = (h >> 10) & 0x1f;
+        uint32_t mantissa       = h & 0x3ff;
+
+        uint32_t bits = sign;
+        if (exponent == 0x1f)
+        {
+            bits |= 0x7f800000 | (mantissa << 13);
+        }
+        else if (exponent != 0)
+        {
+            bits |= ((exponent + 112) << 23) | (mantissa << 13);
+        }
+        else if (mantissa != 0)
+        {
+            // Subnormal, normalized for the wider exponent.
+            uint32_t e = 113;
+            while ((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                e--;
+            }
+            bits |= (e << 23) | ((mantissa & 0x3ff) << 13);
+        }
+
+        float f;
+        ::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    uint16_t floatToHalf(float f)
+    {
+        uint32_t bits;
+        ::memcpy(&bits, &f, sizeof(bits));
+
+        const auto sign    = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const int exponent = static_cast<int>((bits >> 23) & 0xff) - 112;
+        const uint32_t man = bits & 0x7fffff;
+
+        if (exponent >= 0x1f)
+        {
+            // Overflow to infinity, NaN stays NaN.
+            const bool isNan = ((bits >> 23) & 0xff) == 0xff && man != 0;
+            return static_cast<uint16_t>(sign | 0x7c00 | (isNan ? 0x200 : 0));
+        }
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+            {
+                return sign;
+            }
+            const uint32_t m = (man | 0x800000) >> (1 - exponent);
+            return static_cast<uint16_t>(sign | ((m + 0x1000) >> 13));
+        }
+
+        // Rounding may carry into the exponent, which is still correct.
+        return static_cast<uint16_t>(sign | ((static_cast<uint32_t>(exponent) << 10) + ((man + 0x1000) >> 13)));
+    }
+
+    // Sums the pixels [x0, x1) of a row into bins of step pixels, the last
+    // bin takes the remainder. decode() writes the channels of a pixel.
+    template <typename Decode>
+    void binRow(uint32_t x0, uint32_t x1, uint32_t step, uint32_t bins, uint32_t channels, float* sums, Decode decode)
+    {
+        float v[4] = {};
+        for (uint32_t x = x0; x < x1; x++)
+        {
+            decode(x, v);
+            auto out = sums + static_cast<size_t>(std::min(x / step, bins - 1)) * channels;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                out[c] += v[c];
+            }
+        }
+    }
+
+} // namespace
+
 cQuadImage::cQuadImage()
 {
 }
@@ -28,8 +116,8 @@ cQuadImage::~cQuadImage()
 void cQuadImage::clear()
 {
     m_compressed       = false;
-    m_compressedFormat = 0;
-    m_compressedSize   = 0;
+    m_compressedFormat = eCompressedFormat::None;
+    m_compressedData   = {};
 
     m_texWidth  = 0;
     m_texHeight = 0;
@@ -46,6 +134,7 @@ void cQuadImage::clear()
 
     clearOld();
     m_chunks.clear();
+    m_overview.reset();
     m_gpuMemory = 0;
 
     m_buffer = {};
@@ -56,32 +145,74 @@ void cQuadImage::clear()
         m_lutTexture = 0;
     }
     m_lutData.clear();
+    if (m_paletteTexture != 0)
+    {
+        render::deleteTexture(m_paletteTexture);
+        m_paletteTexture = 0;
+    }
+    m_paletteData.clear();
     m_effects = eEffect::None;
 
     m_pixelCache.x = std::numeric_limits<uint32_t>::max();
     m_pixelCache.y = std::numeric_limits<uint32_t>::max();
+    m_texels.clear();
 }
 
 void cQuadImage::clearOld()
 {
     for (const auto& chunk : m_chunksOld)
     {
-        m_gpuMemory -= chunkGpuBytes(chunk.quad->getTexWidth(), chunk.quad->getTexHeight());
+        m_gpuMemory -= residentBytes(chunk);
     }
     m_chunksOld.clear();
 }
 
 size_t cQuadImage::chunkGpuBytes(uint32_t tw, uint32_t th) const
 {
-    return m_compressed
-        ? m_compressedSize
-        : static_cast<size_t>(tw) * th * (m_bitsPerPixel / 8);
+    // The mip chain of uncompressed tiles adds a third.
+    if (m_compressed)
+    {
+        return compressed::getDataSize(m_compressedFormat, tw, th);
+    }
+
+    return ycbcr::isPlanar(m_format)
+        ? getTileBytes(tw, th) * 4 / 3
+        : static_cast<size_t>(tw) * th * (m_bitsPerPixel / 8) * 4 / 3;
+}
+
+size_t cQuadImage::overviewGpuBytes(uint32_t tw, uint32_t th) const
+{
+    return static_cast<size_t>(tw) * th * (m_overviewBpp / 8) * 4 / 3;
+}
+
+size_t cQuadImage::getTileBytes(uint32_t w, uint32_t rows) const
+{
+    if (ycbcr::isPlanar(m_format))
+    {
+        const auto layout = ycbcr::getLayout(m_format, m_width);
+        const size_t cw   = ycbcr::getChromaSize(w, layout.factorX);
+        return static_cast<size_t>(w) * rows + 2 * cw * ycbcr::getChromaSize(rows, layout.factorY);
+    }
+
+    return static_cast<size_t>(helpers::calculatePitch(w, m_bitsPerPixel)) * rows;
+}
+
+size_t cQuadImage::residentBytes(const Chunk& chunk) const
+{
+    return chunk.quad != nullptr
+        ? chunkGpuBytes(chunk.quad->getTexWidth(), chunk.quad->getTexHeight())
+        : 0;
 }
 
 void cQuadImage::setBuffer(uint32_t width, uint32_t height, uint32_t pitch,
                            ePixelFormat format, uint32_t bpp, const uint8_t* image,
                            uint32_t bandHeight, eEffect effects)
 {
+    // A new pass over the same image (progressive refinement, the next
+    // sub-image) keeps the tiles on screen until its rows replace them.
+    const bool isSameLayout = m_compressed == false && m_chunks.empty() == false
+        && width == m_width && height == m_height && format == m_format;
+
     m_texWidth  = render::calculateTextureSize(width);
     m_texHeight = render::calculateTextureSize(height);
 
@@ -90,8 +221,20 @@ void cQuadImage::setBuffer(uint32_t width, uint32_t height, uint32_t pitch,
     m_cols = (width + m_texWidth - 1) / m_texWidth;
     m_rows = (height + m_texHeight - 1) / m_texHeight;
 
-    clearOld();
-    m_chunks.clear();
+    if (isSameLayout)
+    {
+        moveToOld();
+    }
+    else
+    {
+        clearOld();
+        m_chunks.clear();
+    }
+    releaseOverview();
+
+    m_compressed       = false;
+    m_compressedFormat = eCompressedFormat::None;
+    m_compressedData   = {};
 
     m_width        = width;
     m_height       = height;
@@ -101,12 +244,26 @@ void cQuadImage::setBuffer(uint32_t width, uint32_t height, uint32_t pitch,
     m_bitsPerPixel = bpp;
     m_image        = image;
 
-    m_buffer.resize(m_texPitch * m_texHeight);
-
+    // A reused chunk may still carry the flag of an earlier indexed frame.
+    if (format != ePixelFormat::Indexed8)
+    {
+        effects = static_cast<eEffect>(static_cast<uint32_t>(effects) & ~static_cast<uint32_t>(eEffect::Palette));
+    }
     m_effects = effects;
 
+    // Planar and indexed tiles leave an RGB(A) overview, drawn without the
+    // conversion.
+    const uint32_t converted = static_cast<uint32_t>(eEffect::YCbCr) | static_cast<uint32_t>(eEffect::Palette);
+    m_overviewEffects        = static_cast<eEffect>(static_cast<uint32_t>(effects) & ~converted);
+
     m_pixelCache.x = std::numeric_limits<uint32_t>::max();
     m_pixelCache.y = std::numeric_limits<uint32_t>::max();
+    m_texels.clear();
+
+    // Tiles keep a CPU copy to be paged back in only when the whole image
+    // doesn't fit the budget.
+    m_paging = m_gpuBudget != 0 && chunkGpuBytes(width, height) > m_gpuBudget;
+    prepareOverview();
 
     m_started = true;
 }
@@ -126,31 +283,64 @@ void cQuadImage::setLutData(const std::vector<uint8_t>& data)
     m_pixelCache.y = std::numeric_limits<uint32_t>::max();
 }
 
-void cQuadImage::setCompressedBuffer(uint32_t width, uint32_t height,
-                                     uint32_t format, uint32_t compressedSize,
-                                     const uint8_t* image)
+void cQuadImage::setPaletteData(const std::vector<uint8_t>& data)
+{
+    if (m_paletteTexture != 0)
+    {
+        render::deleteTexture(m_paletteTexture);
+        m_paletteTexture = 0;
+    }
+
+    m_paletteData    = data;
+    m_paletteData.resize(256 * 4, 0);
+    m_paletteTexture = render::createPaletteTexture(m_paletteData.data());
+
+    m_pixelCache.x = std::numeric_limits<uint32_t>::max();
+    m_pixelCache.y = std::numeric_limits<uint32_t>::max();
+}
+
+void cQuadImage::setCompressedBuffer(uint32_t width, uint32_t height, eCompressedFormat format, const uint8_t* image)
 {
-    moveToOld();
+    clearOld();
+    m_chunks.clear();
+    releaseOverview();
 
     m_pixelCache.x = std::numeric_limits<uint32_t>::max();
     m_pixelCache.y = std::numeric_limits<uint32_t>::max();
+    m_texels.clear();
 
     m_compressed       = true;
     m_compressedFormat = format;
-    m_compressedSize   = compressedSize;
+    m_compressedData.assign(image, image + compressed::getDataSize(format, width, height));
+
+    // Tiles are cut on block boundaries, e.g. ASTC 6x6 doesn't divide the
+    // power-of-two texture size limit.
+    const auto& block = compressed::getBlockInfo(format);
+    auto getTileSize  = [](uint32_t size, uint32_t blockSize) {
+        const uint32_t limit = render::calculateTextureSize(size);
+        return limit == size
+            ? size
+            : limit / blockSize * blockSize;
+    };
 
-    m_texWidth  = width;
-    m_texHeight = height;
+    m_texWidth  = getTileSize(width, block.width);
+    m_texHeight = getTileSize(height, block.height);
     m_texPitch  = 0;
-    m_cols      = 1;
-    m_rows      = 1;
+    m_cols      = (width + m_texWidth - 1) / m_texWidth;
+    m_rows      = (height + m_texHeight - 1) / m_texHeight;
 
     m_width        = width;
     m_height       = height;
     m_pitch        = 0;
+    m_bandHeight   = height;
     m_format       = ePixelFormat::RGBA;
     m_bitsPerPixel = 0;
-    m_image        = image;
+    m_image        = nullptr;
+
+    m_effects = eEffect::None;
+
+    // Compressed tiles page back in from m_compressedData.
+    m_paging = m_gpuBudget != 0 && chunkGpuBytes(width, height) > m_gpuBudget;
 
     m_started = true;
 }
@@ -169,35 +359,113 @@ uint32_t cQuadImage::getChunkWidth(uint32_t col) const
         : (m_width - m_texWidth * (m_cols - 1));
 }
 
-void cQuadImage::createChunk(uint32_t col, uint32_t row, uint32_t readyHeight)
+uint8_t* cQuadImage::mapUploadBuffer(size_t size)
+{
+    auto out = render::mapUploadBuffer(size);
+    if (out == nullptr)
+    {
+        // No buffer object free, stage in client memory instead.
+        m_buffer.resize(size);
+        out = m_buffer.data();
+    }
+
+    return out;
+}
+
+void cQuadImage::copyRows(uint8_t* out, uint32_t sx, uint32_t sy, uint32_t rows, uint32_t dstPitch, uint32_t step) const
+{
+    auto copy = [=](uint32_t from, uint32_t to) {
+        for (uint32_t y = from; y < to; y++)
+        {
+            const auto bandRow = (sy + y * step) % m_bandHeight;
+            const auto src     = static_cast<size_t>(sx) + static_cast<size_t>(bandRow) * m_pitch;
+            ::memcpy(out + static_cast<size_t>(y) * dstPitch, m_image + src, dstPitch);
+        }
+    };
+
+    // Large tiles are copied by the pool straight into the mapped buffer.
+    constexpr size_t ParallelCopyBytes = 1024 * 1024;
+    auto& pool                         = cThreadPool::shared();
+    const bool parallel                = static_cast<size_t>(rows) * dstPitch >= ParallelCopyBytes;
+    const uint32_t strips              = parallel ? pool.getThreadsCount() + 1 : 1;
+    const uint32_t stripRows           = (rows + strips - 1) / strips;
+    pool.parallelFor(0, strips, [&](uint32_t strip) {
+        copy(strip * stripRows, std::min(rows, (strip + 1) * stripRows));
+    });
+}
+
+void cQuadImage::copyTile(uint8_t* out, uint32_t col, uint32_t sy, uint32_t rows, uint32_t dy, uint32_t tileRows) const
+{
+    const uint32_t w = getChunkWidth(col);
+    if (ycbcr::isPlanar(m_format) == false)
+    {
+        const uint32_t dstPitch = helpers::calculatePitch(w, m_bitsPerPixel);
+        const uint32_t sx       = col * m_texWidth * (m_bitsPerPixel / 8);
+        copyRows(out + static_cast<size_t>(dy) * dstPitch, sx, sy, rows, dstPitch);
+        return;
+    }
+
+    // Y, Cb and Cr planes one after another. Chroma rows are read from the
+    // luma rows they start at, sy and dy are on such rows.
+    const auto layout         = ycbcr::getLayout(m_format, m_width);
+    const uint32_t cw         = ycbcr::getChromaSize(w, layout.factorX);
+    const uint32_t cx         = col * m_texWidth / layout.factorX;
+    const uint32_t chromaRows = ycbcr::getChromaSize(rows, layout.factorY);
+    const size_t cbPlane      = static_cast<size_t>(w) * tileRows;
+    const size_t crPlane      = cbPlane + static_cast<size_t>(cw) * ycbcr::getChromaSize(tileRows, layout.factorY);
+    const size_t chromaDst    = static_cast<size_t>(dy / layout.factorY) * cw;
+
+    copyRows(out + static_cast<size_t>(dy) * w, col * m_texWidth, sy, rows, w);
+    copyRows(out + cbPlane + chromaDst, layout.cbOffset + cx, sy, chromaRows, cw, layout.factorY);
+    copyRows(out + crPlane + chromaDst, layout.crOffset + cx, sy, chromaRows, cw, layout.factorY);
+}
+
+size_t cQuadImage::createChunk(uint32_t col, uint32_t row, uint32_t readyHeight)
 {
     const uint32_t chunkTop  = row * m_texHeight;
     const uint32_t chunkH    = getChunkHeight(row);
     const uint32_t w         = getChunkWidth(col);
     const uint32_t available = std::min(readyHeight - chunkTop, chunkH);
 
-    const uint32_t bytesPerPixel = m_bitsPerPixel / 8;
-    const uint32_t sx            = col * m_texWidth * bytesPerPixel;
-    const uint32_t dstPitch      = helpers::calculatePitch(w, m_bitsPerPixel);
+    // Copy available rows, zero-fill the rest of the chunk
+    const size_t size  = getTileBytes(w, chunkH);
+    uint32_t oldHeight = 0;
+    cQuad* quad        = findAndRemoveOld(col, row, oldHeight);
 
-    // Zero-fill for the full chunk, then copy available rows
-    ::memset(m_buffer.data(), 0, dstPitch * chunkH);
+    if (m_paging)
+    {
+        // Only the CPU copy, updateResidency() pages in the tiles around
+        // the view within the GPU budget.
+        delete quad;
+
+        std::vector<uint8_t> pixels(size, 0);
+        copyTile(pixels.data(), col, chunkTop, available, 0, chunkH);
+        m_chunks.push_back({ col, row, available, nullptr, std::move(pixels) });
+        addOverviewRows(m_chunks.back(), 0, available);
+        if (available == chunkH)
+        {
+            completeChunk(m_chunks.back());
+        }
 
-    auto out      = m_buffer.data();
-    const auto in = m_image;
+        return size;
+    }
 
-    for (uint32_t y = 0; y < available; y++)
+    auto out = mapUploadBuffer(size);
+    if (available < chunkH)
+    {
+        ::memset(out, 0, size);
+    }
+    copyTile(out, col, chunkTop, available, 0, chunkH);
+
+    if (quad != nullptr
+        && (quad->getTexWidth() != w || quad->getTexHeight() != chunkH
+            || quad->getFormat() != m_format))
     {
-        const auto bandRow = (chunkTop + y) % m_bandHeight;
-        const auto src     = static_cast<size_t>(sx) + static_cast<size_t>(bandRow) * m_pitch;
-        const uint32_t dst = y * dstPitch;
-        ::memcpy(out + dst, in + src, dstPitch);
+        delete quad;
+        quad = nullptr;
     }
 
-    cQuad* quad = findAndRemoveOld(col, row);
-    if (quad == nullptr
-        || quad->getTexWidth() != w || quad->getTexHeight() != chunkH
-        || quad->getFormat() != m_format)
+    if (quad == nullptr)
     {
         auto newQuad = std::make_unique<cQuad>(w, chunkH, out, m_format);
         newQuad->useFilter(m_filter);
@@ -207,7 +475,18 @@ void cQuadImage::createChunk(uint32_t col, uint32_t row, uint32_t readyHeight)
                                     { static_cast<float>(w), static_cast<float>(available) });
         }
         m_gpuMemory += chunkGpuBytes(w, chunkH);
-        m_chunks.push_back({ col, row, available, std::move(newQuad) });
+        m_chunks.push_back({ col, row, available, std::move(newQuad), {} });
+    }
+    else if (available < chunkH && oldHeight == chunkH)
+    {
+        // Refine the complete old tile from the top, its lower rows stay
+        // visible until the new ones arrive.
+        quad->updateSubData(out, 0, available);
+        quad->useFilter(m_filter);
+        quad->setSpriteSize({ static_cast<float>(w), static_cast<float>(chunkH) });
+        m_gpuMemory += chunkGpuBytes(w, chunkH);
+        m_chunks.push_back({ col, row, available, std::unique_ptr<cQuad>(quad), {} });
+        m_chunks.back().isRefining = true;
     }
     else
     {
@@ -223,108 +502,799 @@ void cQuadImage::createChunk(uint32_t col, uint32_t row, uint32_t readyHeight)
             quad->setSpriteSize({ static_cast<float>(w), static_cast<float>(chunkH) });
         }
         m_gpuMemory += chunkGpuBytes(w, chunkH);
-        m_chunks.push_back({ col, row, available, std::unique_ptr<cQuad>(quad) });
+        m_chunks.push_back({ col, row, available, std::unique_ptr<cQuad>(quad), {} });
+    }
+
+    addOverviewRows(m_chunks.back(), 0, available);
+    if (available == chunkH)
+    {
+        completeChunk(m_chunks.back());
     }
+
+    return size;
 }
 
-void cQuadImage::updateChunkSubData(Chunk& chunk, uint32_t available)
+size_t cQuadImage::updateChunkSubData(Chunk& chunk, uint32_t available)
 {
-    const uint32_t w             = getChunkWidth(chunk.col);
-    const uint32_t newRows       = available - chunk.uploadedHeight;
-    const uint32_t bytesPerPixel = m_bitsPerPixel / 8;
-    const uint32_t sx            = chunk.col * m_texWidth * bytesPerPixel;
-    const uint32_t sy            = chunk.row * m_texHeight + chunk.uploadedHeight;
-    const uint32_t dstPitch      = helpers::calculatePitch(w, m_bitsPerPixel);
-
-    auto out      = m_buffer.data();
-    const auto in = m_image;
+    const uint32_t w       = getChunkWidth(chunk.col);
+    const uint32_t newRows = available - chunk.uploadedHeight;
+    const uint32_t sy      = chunk.row * m_texHeight + chunk.uploadedHeight;
+    const uint32_t chunkH  = getChunkHeight(chunk.row);
 
-    for (uint32_t y = 0; y < newRows; y++)
+    const size_t size = getTileBytes(w, newRows);
+    if (m_paging)
     {
-        const auto bandRow = (sy + y) % m_bandHeight;
-        const auto src     = static_cast<size_t>(sx) + static_cast<size_t>(bandRow) * m_pitch;
-        const uint32_t dst = y * dstPitch;
-        ::memcpy(out + dst, in + src, dstPitch);
+        copyTile(chunk.pixels.data(), chunk.col, sy, newRows, chunk.uploadedHeight, chunkH);
     }
+    addOverviewRows(chunk, chunk.uploadedHeight, newRows);
 
-    chunk.quad->updateSubData(out, chunk.uploadedHeight, newRows);
+    // A paged out tile takes the rows in its CPU copy only.
+    if (chunk.quad != nullptr)
+    {
+        auto out = mapUploadBuffer(size);
+        copyTile(out, chunk.col, sy, newRows, 0, newRows);
+        chunk.quad->updateSubData(out, chunk.uploadedHeight, newRows);
+    }
     chunk.uploadedHeight = available;
 
-    const uint32_t chunkH = getChunkHeight(chunk.row);
-    const auto fw         = static_cast<float>(w);
+    const auto fw = static_cast<float>(w);
     if (available < chunkH)
     {
-        chunk.quad->setTextureRect({ 0.0f, 0.0f }, { fw, static_cast<float>(available) });
+        if (chunk.quad != nullptr && chunk.isRefining == false)
+        {
+            chunk.quad->setTextureRect({ 0.0f, 0.0f }, { fw, static_cast<float>(available) });
+        }
     }
     else
     {
-        chunk.quad->setSpriteSize({ fw, static_cast<float>(chunkH) });
+        if (chunk.quad != nullptr)
+        {
+            chunk.quad->setSpriteSize({ fw, static_cast<float>(chunkH) });
+        }
+        completeChunk(chunk);
     }
+
+    return size;
 }
 
-bool cQuadImage::upload(uint32_t readyHeight)
+void cQuadImage::completeChunk(Chunk& chunk)
 {
-    if (m_compressed)
+    if (chunk.quad != nullptr)
     {
-        clearOld();
+        chunk.quad->generateMipmaps();
+    }
+    chunk.overviewSums = {};
+}
 
-        auto quad = std::make_unique<cQuad>(m_width, m_height, m_image, static_cast<GLenum>(m_compressedFormat), m_compressedSize);
-        quad->useFilter(m_filter);
-        m_gpuMemory += m_compressedSize;
-        m_chunks.push_back({ 0, 0, 0, std::move(quad) });
+uint32_t cQuadImage::getOverviewChannels() const
+{
+    switch (m_format)
+    {
+    case ePixelFormat::RGB565:
+    case ePixelFormat::YCbCr420:
+    case ePixelFormat::YCbCr422:
+        return 3;
+
+    case ePixelFormat::RGBA5551:
+    case ePixelFormat::RGBA4444:
+    case ePixelFormat::RGBA16F:
+    case ePixelFormat::Indexed8:
+        return 4;
+
+    case ePixelFormat::RGB16:
+    case ePixelFormat::RGBA16:
+        return m_bitsPerPixel / 16;
+
+    default:
+        return m_bitsPerPixel / 8;
+    }
+}
 
-        m_started = false;
-        return true;
+void cQuadImage::storeOverviewPixel(const float* v, uint8_t* out) const
+{
+    auto round = [](float value) {
+        return static_cast<uint32_t>(value + 0.5f);
+    };
+
+    float rgb[3];
+    if (ycbcr::isPlanar(m_format))
+    {
+        ycbcr::toRgb(v[0] / 255.0f, v[1] / 255.0f, v[2] / 255.0f, rgb);
+        for (auto& c : rgb)
+        {
+            c *= 255.0f;
+        }
+        v = rgb;
     }
 
-    const auto totalChunks = m_rows * m_cols;
+    uint16_t p[4] = {};
+    switch (m_overviewFormat)
+    {
+    case ePixelFormat::RGB565:
+        p[0] = static_cast<uint16_t>((round(v[0]) << 11) | (round(v[1]) << 5) | round(v[2]));
+        ::memcpy(out, p, 2);
+        break;
+
+    case ePixelFormat::RGBA5551:
+        p[0] = static_cast<uint16_t>((round(v[0]) << 11) | (round(v[1]) << 6) | (round(v[2]) << 1) | round(v[3]));
+        ::memcpy(out, p, 2);
+        break;
+
+    case ePixelFormat::RGBA4444:
+        p[0] = static_cast<uint16_t>((round(v[0]) << 12) | (round(v[1]) << 8) | (round(v[2]) << 4) | round(v[3]));
+        ::memcpy(out, p, 2);
+        break;
+
+    case ePixelFormat::RGBA16F:
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            p[c] = floatToHalf(v[c]);
+        }
+        ::memcpy(out, p, 8);
+        break;
 
-    // Phase 1: Update partially uploaded existing chunks with new rows
-    for (auto& chunk : m_chunks)
+    case ePixelFormat::RGB16:
+    case ePixelFormat::RGBA16:
+        for (uint32_t c = 0, channels = m_overviewBpp / 16; c < channels; c++)
+        {
+            p[c] = static_cast<uint16_t>(round(v[c]));
+        }
+        ::memcpy(out, p, m_overviewBpp / 8);
+        break;
+
+    default:
+        for (uint32_t c = 0, channels = m_overviewBpp / 8; c < channels; c++)
+        {
+            out[c] = static_cast<uint8_t>(round(v[c]));
+        }
+        break;
+    }
+}
+
+void cQuadImage::addOverviewRows(Chunk& chunk, uint32_t dy, uint32_t rows)
+{
+    const uint32_t channels = getOverviewChannels();
+    if (m_overviewData.empty() || rows == 0
+        || (m_format == ePixelFormat::Indexed8 && m_paletteData.size() < 256 * 4))
+    {
+        return;
+    }
+
+    // Each overview pixel averages a step × step block of the tile, the
+    // share of its mip level. Sums of the block row being uploaded wait in
+    // the chunk, the ring may drop the rows before the block is complete.
+    const uint32_t level = m_overviewLevel;
+    const uint32_t step  = 1u << level;
+    const uint32_t w     = getChunkWidth(chunk.col);
+    const uint32_t h     = getChunkHeight(chunk.row);
+    const uint32_t lw    = std::max(1u, w >> level);
+    const uint32_t lh    = std::max(1u, h >> level);
+    if (chunk.overviewSums.empty())
     {
-        const uint32_t chunkTop = chunk.row * m_texHeight;
-        const uint32_t chunkH   = getChunkHeight(chunk.row);
+        chunk.overviewSums.assign(static_cast<size_t>(lw) * channels, 0.0f);
+    }
+
+    const uint32_t pitch = helpers::calculatePitch(m_overviewWidth, m_overviewBpp);
+    const uint32_t ox    = chunk.col * (m_texWidth >> level);
+    const uint32_t oy    = chunk.row * (m_texHeight >> level);
+    const uint32_t sx    = chunk.col * m_texWidth;
+    const uint32_t sy    = chunk.row * m_texHeight;
+    auto sums            = chunk.overviewSums.data();
+    const auto layout    = ycbcr::getLayout(m_format, m_width);
 
-        if (chunk.uploadedHeight >= chunkH)
+    auto binEnd = [step](uint32_t bin, uint32_t bins, uint32_t size) {
+        return bin + 1 == bins ? size : (bin + 1) * step;
+    };
+
+    auto addRow = [&](uint32_t y, uint32_t b0, uint32_t b1) {
+        const auto row    = m_image + static_cast<size_t>((sy + y) % m_bandHeight) * m_pitch;
+        const auto chroma = m_image + static_cast<size_t>((sy + y - (sy + y) % layout.factorY) % m_bandHeight) * m_pitch;
+        const uint32_t x0 = b0 * step;
+        const uint32_t x1 = binEnd(b1 - 1, lw, w);
+        switch (m_format)
         {
-            continue;
+        case ePixelFormat::RGB565:
+            binRow(x0, x1, step, lw, channels, sums, [row, sx](uint32_t x, float* v) {
+                uint16_t p;
+                ::memcpy(&p, row + static_cast<size_t>(sx + x) * 2, 2);
+                v[0] = static_cast<float>(p >> 11);
+                v[1] = static_cast<float>((p >> 5) & 0x3f);
+                v[2] = static_cast<float>(p & 0x1f);
+            });
+            break;
+
+        case ePixelFormat::RGBA5551:
+            binRow(x0, x1, step, lw, channels, sums, [row, sx](uint32_t x, float* v) {
+                uint16_t p;
+                ::memcpy(&p, row + static_cast<size_t>(sx + x) * 2, 2);
+                v[0] = static_cast<float>(p >> 11);
+                v[1] = static_cast<float>((p >> 6) & 0x1f);
+                v[2] = static_cast<float>((p >> 1) & 0x1f);
+                v[3] = static_cast<float>(p & 1);
+            });
+            break;
+
+        case ePixelFormat::RGBA4444:
+            binRow(x0, x1, step, lw, channels, sums, [row, sx](uint32_t x, float* v) {
+                uint16_t p;
+                ::memcpy(&p, row + static_cast<size_t>(sx + x) * 2, 2);
+                v[0] = static_cast<float>(p >> 12);
+                v[1] = static_cast<float>((p >> 8) & 0xf);
+                v[2] = static_cast<float>((p >> 4) & 0xf);
+                v[3] = static_cast<float>(p & 0xf);
+            });
+            break;
+
+        case ePixelFormat::RGBA16F:
+            binRow(x0, x1, step, lw, channels, sums, [row, sx](uint32_t x, float* v) {
+                uint16_t p[4];
+                ::memcpy(p, row + static_cast<size_t>(sx + x) * 8, 8);
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    v[c] = halfToFloat(p[c]);
+                }
+            });
+            break;
+
+        case ePixelFormat::YCbCr420:
+        case ePixelFormat::YCbCr422:
+            // Planes are averaged apart, the RGB conversion is affine. Chroma
+            // is read from the luma row its chroma row starts at.
+            binRow(x0, x1, step, lw, channels, sums, [&layout, row, chroma, sx](uint32_t x, float* v) {
+                const uint32_t cx = (sx + x) / layout.factorX;
+                v[0]              = static_cast<float>(row[sx + x]);
+                v[1]              = static_cast<float>(chroma[layout.cbOffset + cx]);
+                v[2]              = static_cast<float>(chroma[layout.crOffset + cx]);
+            });
+            break;
+
+        case ePixelFormat::Indexed8:
+            // Indices are filtered through the palette, the overview is RGBA.
+            binRow(x0, x1, step, lw, channels, sums, [this, row, sx](uint32_t x, float* v) {
+                const auto entry = &m_paletteData[static_cast<size_t>(row[sx + x]) * 4];
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    v[c] = static_cast<float>(entry[c]);
+                }
+            });
+            break;
+
+        case ePixelFormat::RGB16:
+        case ePixelFormat::RGBA16:
+            binRow(x0, x1, step, lw, channels, sums, [row, sx, channels](uint32_t x, float* v) {
+                uint16_t p[4];
+                ::memcpy(p, row + static_cast<size_t>(sx + x) * channels * 2, channels * 2);
+                for (uint32_t c = 0; c < channels; c++)
+                {
+                    v[c] = static_cast<float>(p[c]);
+                }
+            });
+            break;
+
+        default:
+            binRow(x0, x1, step, lw, channels, sums, [row, sx, channels](uint32_t x, float* v) {
+                const auto p = row + static_cast<size_t>(sx + x) * channels;
+                for (uint32_t c = 0; c < channels; c++)
+                {
+                    v[c] = static_cast<float>(p[c]);
+                }
+            });
+            break;
+        }
+    };
+
+    auto storeBins = [&](uint32_t by, uint32_t b0, uint32_t b1) {
+        const uint32_t blockRows = binEnd(by, lh, h) - by * step;
+        auto out                 = m_overviewData.data() + static_cast<size_t>(oy + by) * pitch;
+        for (uint32_t b = b0; b < b1; b++)
+        {
+            auto sum       = sums + static_cast<size_t>(b) * channels;
+            const auto n   = static_cast<float>((binEnd(b, lw, w) - b * step) * blockRows);
+            const size_t x = ox + b;
+            float v[4]     = {};
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                v[c]   = sum[c] / n;
+                sum[c] = 0.0f;
+            }
+
+            storeOverviewPixel(v, out + x * (m_overviewBpp / 8));
         }
+    };
 
-        const uint32_t available = (readyHeight > chunkTop)
-            ? std::min(readyHeight - chunkTop, chunkH)
-            : 0;
+    // Bins are independent, large uploads are split between the pool.
+    constexpr size_t ParallelBytes = 1024 * 1024;
+    auto& pool                     = cThreadPool::shared();
+    const bool parallel            = static_cast<size_t>(rows) * w * std::max(1u, m_bitsPerPixel / 8) >= ParallelBytes;
+    const uint32_t strips          = parallel ? std::min(lw, pool.getThreadsCount() + 1) : 1;
+    const uint32_t stripBins       = (lw + strips - 1) / strips;
+    pool.parallelFor(0, strips, [&](uint32_t strip) {
+        const uint32_t b0 = strip * stripBins;
+        const uint32_t b1 = std::min(lw, b0 + stripBins);
+        if (b0 >= b1)
+        {
+            return;
+        }
 
-        if (available > chunk.uploadedHeight)
+        for (uint32_t y = dy; y < dy + rows; y++)
         {
-            updateChunkSubData(chunk, available);
+            addRow(y, b0, b1);
+
+            const uint32_t by = std::min(y / step, lh - 1);
+            if (y + 1 == binEnd(by, lh, h))
+            {
+                storeBins(by, b0, b1);
+            }
         }
+    });
+}
+
+std::unique_ptr<cQuad> cQuadImage::createCompressedQuad(uint32_t col, uint32_t row)
+{
+    const auto& block = compressed::getBlockInfo(m_compressedFormat);
+    const uint32_t w  = getChunkWidth(col);
+    const uint32_t h  = getChunkHeight(row);
+    const size_t size = compressed::getDataSize(m_compressedFormat, w, h);
+
+    const uint8_t* data = m_compressedData.data();
+    if (m_cols > 1 || m_rows > 1)
+    {
+        // Gather the tile's block rows into one contiguous image.
+        const size_t srcPitch    = static_cast<size_t>((m_width + block.width - 1) / block.width) * block.bytes;
+        const size_t dstPitch    = static_cast<size_t>((w + block.width - 1) / block.width) * block.bytes;
+        const size_t sx          = static_cast<size_t>(col * m_texWidth / block.width) * block.bytes;
+        const uint32_t sy        = row * m_texHeight / block.height;
+        const uint32_t blockRows = (h + block.height - 1) / block.height;
+
+        auto out = mapUploadBuffer(size);
+        for (uint32_t y = 0; y < blockRows; y++)
+        {
+            ::memcpy(out + y * dstPitch, data + (sy + y) * srcPitch + sx, dstPitch);
+        }
+        data = out;
     }
 
-    // Phase 2: Create new chunks when data becomes available
-    while (m_chunks.size() < totalChunks)
+    auto quad = std::make_unique<cQuad>(w, h, data, m_compressedFormat, static_cast<uint32_t>(size));
+    quad->useFilter(m_filter);
+    m_gpuMemory += size;
+
+    return quad;
+}
+
+size_t cQuadImage::createCompressedChunk(uint32_t col, uint32_t row)
+{
+    // Paged tiles are created by updateResidency() when they are in view.
+    auto quad = m_paging ? nullptr : createCompressedQuad(col, row);
+    m_chunks.push_back({ col, row, getChunkHeight(row), std::move(quad), {} });
+
+    return residentBytes(m_chunks.back());
+}
+
+cQuadImage::Chunk* cQuadImage::findChunk(uint32_t col, uint32_t row)
+{
+    for (auto& chunk : m_chunks)
     {
-        const auto idx          = m_chunks.size();
-        const uint32_t col      = idx % m_cols;
-        const uint32_t row      = idx / m_cols;
-        const uint32_t chunkTop = row * m_texHeight;
+        if (chunk.col == col && chunk.row == row)
+        {
+            return &chunk;
+        }
+    }
+
+    return nullptr;
+}
+
+bool cQuadImage::upload(uint32_t readyHeight)
+{
+    m_uploadedBytes = 0;
 
+    if (m_compressed)
+    {
+        clearOld();
+        readyHeight = m_height;
+    }
+    else if (ycbcr::isPlanar(m_format) && readyHeight < m_height)
+    {
+        // A chroma row covers factorY luma rows, wait for all of them.
+        readyHeight -= readyHeight % ycbcr::getLayout(m_format, m_width).factorY;
+    }
+
+    // Collect tiles that have rows ready but not uploaded yet.
+    struct Pending
+    {
+        uint32_t col;
+        uint32_t row;
+        uint32_t available;
+        bool isInside;
+        float distance;
+    };
+    std::vector<Pending> pending;
+
+    const auto& rc = render::getRect();
+    const auto center = (rc.tl + rc.br) * 0.5f;
+
+    for (uint32_t row = 0; row < m_rows; row++)
+    {
+        const uint32_t chunkTop = row * m_texHeight;
         if (readyHeight <= chunkTop)
         {
             break;
         }
 
-        createChunk(col, row, readyHeight);
+        const uint32_t chunkH    = getChunkHeight(row);
+        const uint32_t available = std::min(readyHeight - chunkTop, chunkH);
+
+        for (uint32_t col = 0; col < m_cols; col++)
+        {
+            const auto chunk = findChunk(col, row);
+            if (chunk != nullptr && chunk->uploadedHeight >= available)
+            {
+                continue;
+            }
+
+            const auto pos = getChunkPos(col, row);
+            const Vectorf size{ static_cast<float>(getChunkWidth(col)), static_cast<float>(chunkH) };
+            const auto delta = pos + size * 0.5f - center;
+            pending.push_back({ col, row, available,
+                                isInsideViewport(pos, size),
+                                delta.x * delta.x + delta.y * delta.y });
+        }
+    }
+
+    // Visible tiles first, then the rest outwards from the view center.
+    std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+        return a.isInside != b.isInside
+            ? a.isInside
+            : a.distance < b.distance;
+    });
+
+    // Always make progress, but stop once the frame budget is spent.
+    const double start = timing::seconds();
+    for (const auto& p : pending)
+    {
+        if (m_uploadedBytes > 0 && isBudgetSpent(m_uploadedBytes, start))
+        {
+            break;
+        }
+
+        auto chunk = findChunk(p.col, p.row);
+        if (chunk != nullptr)
+        {
+            m_uploadedBytes += updateChunkSubData(*chunk, p.available);
+        }
+        else if (m_compressed)
+        {
+            m_uploadedBytes += createCompressedChunk(p.col, p.row);
+        }
+        else
+        {
+            m_uploadedBytes += createChunk(p.col, p.row, readyHeight);
+        }
+    }
+
+    // Tiles read back so far may predate these rows.
+    if (m_uploadedBytes != 0)
+    {
+        m_texels.clear();
     }
 
     const bool isDone = isUploading() == false;
     if (isDone)
     {
+        createOverview();
         stop();
     }
 
     return isDone;
 }
 
+bool cQuadImage::updateRect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint8_t* data, uint32_t pitch)
+{
+    if (m_compressed || ycbcr::isPlanar(m_format) || m_paging || m_overview != nullptr || isUploading())
+    {
+        return false;
+    }
+
+    const uint32_t x1            = std::min(x + w, m_width);
+    const uint32_t y1            = std::min(y + h, m_height);
+    const uint32_t bytesPerPixel = m_bitsPerPixel / 8;
+    for (auto& chunk : m_chunks)
+    {
+        const uint32_t cx = chunk.col * m_texWidth;
+        const uint32_t cy = chunk.row * m_texHeight;
+        const uint32_t l  = std::max(x, cx);
+        const uint32_t t  = std::max(y, cy);
+        const uint32_t r  = std::min(x1, cx + getChunkWidth(chunk.col));
+        const uint32_t b  = std::min(y1, cy + getChunkHeight(chunk.row));
+        if (l >= r || t >= b)
+        {
+            continue;
+        }
+
+        const uint32_t dstPitch = helpers::calculatePitch(r - l, m_bitsPerPixel);
+        auto out                = mapUploadBuffer(static_cast<size_t>(dstPitch) * (b - t));
+        for (uint32_t row = t; row < b; row++)
+        {
+            const auto src = data + static_cast<size_t>(row - y) * pitch + static_cast<size_t>(l - x) * bytesPerPixel;
+            ::memcpy(out + static_cast<size_t>(row - t) * dstPitch, src, static_cast<size_t>(r - l) * bytesPerPixel);
+        }
+
+        chunk.quad->updateRect(out, l - cx, t - cy, r - l, b - t);
+        chunk.quad->generateMipmaps();
+    }
+
+    m_pixelCache.x = std::numeric_limits<uint32_t>::max();
+    m_pixelCache.y = std::numeric_limits<uint32_t>::max();
+    m_texels.clear();
+
+    return true;
+}
+
+uint32_t cQuadImage::getUploadedHeight() const
+{
+    // Tiles of a row may be uploaded out of order, count rows only up to
+    // the first incomplete tile row.
+    for (uint32_t row = 0; row < m_rows; row++)
+    {
+        const uint32_t chunkH = getChunkHeight(row);
+
+        uint32_t uploaded = chunkH;
+        uint32_t count    = 0;
+        for (const auto& chunk : m_chunks)
+        {
+            if (chunk.row == row)
+            {
+                uploaded = std::min(uploaded, chunk.uploadedHeight);
+                count++;
+            }
+        }
+
+        if (count < m_cols)
+        {
+            uploaded = 0;
+        }
+
+        if (uploaded < chunkH)
+        {
+            return row * m_texHeight + uploaded;
+        }
+    }
+
+    return m_height;
+}
+
+bool cQuadImage::isBudgetSpent(size_t bytes, double start) const
+{
+    const bool overBytes = m_budgetBytes != 0 && bytes >= m_budgetBytes;
+    const bool overTime  = m_budgetMs > 0.0 && (timing::seconds() - start) * 1000.0 >= m_budgetMs;
+    return overBytes || overTime;
+}
+
+void cQuadImage::prepareOverview()
+{
+    // A single tile has its own mip chain, compressed tiles have none.
+    if (m_compressed || m_cols * m_rows < 2)
+    {
+        return;
+    }
+
+    constexpr uint32_t OverviewSize = 2048;
+
+    uint32_t level = 1;
+    while ((std::max(m_width, m_height) >> level) > OverviewSize)
+    {
+        level++;
+    }
+
+    // Full tiles are powers of two, so their levels line up exactly.
+    // addOverviewRows() fills in each tile's share.
+    auto levelSize   = [level](uint32_t size) {
+        return std::max(1u, size >> level);
+    };
+    m_overviewLevel  = level;
+    m_overviewWidth  = (m_texWidth >> level) * (m_cols - 1) + levelSize(getChunkWidth(m_cols - 1));
+    m_overviewHeight = (m_texHeight >> level) * (m_rows - 1) + levelSize(getChunkHeight(m_rows - 1));
+
+    // Planar and indexed tiles are converted, the overview is a single RGB
+    // or RGBA texture.
+    const bool planar = ycbcr::isPlanar(m_format);
+    if (m_format == ePixelFormat::Indexed8)
+    {
+        m_overviewFormat = ePixelFormat::RGBA;
+        m_overviewBpp    = 32;
+    }
+    else
+    {
+        m_overviewFormat = planar ? ePixelFormat::RGB : m_format;
+        m_overviewBpp    = planar ? 24 : m_bitsPerPixel;
+    }
+    m_overviewData.assign(static_cast<size_t>(helpers::calculatePitch(m_overviewWidth, m_overviewBpp)) * m_overviewHeight, 0);
+}
+
+void cQuadImage::createOverview()
+{
+    if (m_overviewData.empty())
+    {
+        return;
+    }
+
+    m_overview = std::make_unique<cQuad>(m_overviewWidth, m_overviewHeight, m_overviewData.data(), m_overviewFormat);
+    m_overview->generateMipmaps();
+    m_overview->useFilter(m_filter);
+    m_gpuMemory += overviewGpuBytes(m_overviewWidth, m_overviewHeight);
+
+    m_overviewData = {};
+}
+
+void cQuadImage::releaseOverview()
+{
+    if (m_overview != nullptr)
+    {
+        m_gpuMemory -= overviewGpuBytes(m_overview->getTexWidth(), m_overview->getTexHeight());
+        m_overview.reset();
+    }
+    m_overviewData = {};
+}
+
+bool cQuadImage::isOverviewVisible() const
+{
+    return m_overview != nullptr
+        && render::getZoom() * static_cast<float>(1u << m_overviewLevel) <= 1.0f;
+}
+
+bool cQuadImage::updateResidency()
+{
+    if (m_paging == false || m_chunks.empty())
+    {
+        return false;
+    }
+
+    m_frame++;
+
+    // Tiles around the view with a margin of half a viewport for panning,
+    // none while the overview stands in for the grid.
+    struct Missing
+    {
+        Chunk* chunk;
+        float distance;
+    };
+    std::vector<Missing> missing;
+
+    if (isOverviewVisible() == false)
+    {
+        // The view rect is unrotated, its center is the same in image space.
+        const auto& rc    = render::getRect();
+        const auto center = (rc.tl + rc.br) * 0.5f;
+
+        for (auto& chunk : m_chunks)
+        {
+            const auto pos = getChunkPos(chunk.col, chunk.row);
+            const Vectorf size{ static_cast<float>(getChunkWidth(chunk.col)), static_cast<float>(getChunkHeight(chunk.row)) };
+            if (render::isRectVisible({ pos, pos + size }, 0.5f))
+            {
+                chunk.lastUsed = m_frame;
+                if (chunk.quad == nullptr)
+                {
+                    const auto delta = pos + size * 0.5f - center;
+                    missing.push_back({ &chunk, delta.x * delta.x + delta.y * delta.y });
+                }
+            }
+        }
+    }
+
+    std::sort(missing.begin(), missing.end(), [](const Missing& a, const Missing& b) {
+        return a.distance < b.distance;
+    });
+
+    bool changed = false;
+
+    // Evicts the least recently needed tile out of the view, partially
+    // loaded ones too, their rows are kept in the CPU copy.
+    auto evict = [this, &changed]() {
+        Chunk* victim = nullptr;
+        for (auto& chunk : m_chunks)
+        {
+            if (chunk.quad != nullptr && chunk.lastUsed != m_frame
+                && (victim == nullptr || chunk.lastUsed < victim->lastUsed))
+            {
+                victim = &chunk;
+            }
+        }
+
+        if (victim == nullptr)
+        {
+            return false;
+        }
+
+        m_gpuMemory -= residentBytes(*victim);
+        victim->quad.reset();
+        changed = true;
+        return true;
+    };
+
+    // Page in within the upload budget, the rest follows next frames. The
+    // GPU budget is hard: tiles that don't fit stay paged out, the overview
+    // stands in for them once the image is loaded.
+    size_t bytes       = 0;
+    const double start = timing::seconds();
+    for (const auto& m : missing)
+    {
+        if (bytes > 0 && isBudgetSpent(bytes, start))
+        {
+            break;
+        }
+
+        const size_t need = chunkGpuBytes(getChunkWidth(m.chunk->col), getChunkHeight(m.chunk->row));
+        bool isFitting    = m_gpuMemory + need <= m_gpuBudget;
+        while (isFitting == false && evict())
+        {
+            isFitting = m_gpuMemory + need <= m_gpuBudget;
+        }
+        if (isFitting == false)
+        {
+            break;
+        }
+
+        bytes += pageIn(*m.chunk);
+        changed = true;
+    }
+
+    // Tiles out of the view go down to the budget.
+    bool isOver = m_gpuMemory > m_gpuBudget;
+    while (isOver && evict())
+    {
+        isOver = m_gpuMemory > m_gpuBudget;
+    }
+
+    // Texture names of evicted tiles may be reused by others.
+    if (changed)
+    {
+        m_texels.clear();
+    }
+
+    return changed;
+}
+
+bool cQuadImage::updateReadback()
+{
+    return m_texels.update();
+}
+
+bool cQuadImage::isReadbackPending() const
+{
+    return m_texels.isPending();
+}
+
+size_t cQuadImage::pageIn(Chunk& chunk)
+{
+    if (m_compressed)
+    {
+        chunk.quad = createCompressedQuad(chunk.col, chunk.row);
+        return residentBytes(chunk);
+    }
+
+    const uint32_t w  = getChunkWidth(chunk.col);
+    const uint32_t h  = getChunkHeight(chunk.row);
+    const size_t size = chunk.pixels.size();
+
+    auto out = mapUploadBuffer(size);
+    ::memcpy(out, chunk.pixels.data(), size);
+
+    chunk.quad = std::make_unique<cQuad>(w, h, out, m_format);
+    chunk.quad->useFilter(m_filter);
+    if (chunk.uploadedHeight < h)
+    {
+        // Still loading, the rows below aren't there yet.
+        chunk.quad->setTextureRect({ 0.0f, 0.0f }, { static_cast<float>(w), static_cast<float>(chunk.uploadedHeight) });
+    }
+    else
+    {
+        chunk.quad->generateMipmaps();
+    }
+    m_gpuMemory += chunkGpuBytes(w, h);
+
+    return size;
+}
+
 void cQuadImage::stop()
 {
     clearOld();
@@ -336,9 +1306,11 @@ void cQuadImage::reset()
 {
     stop();
     m_chunks.clear();
-    m_gpuMemory = 0;
-    m_width     = 0;
-    m_height    = 0;
+    m_overview.reset();
+    m_compressedData = {};
+    m_gpuMemory      = 0;
+    m_width          = 0;
+    m_height         = 0;
 
     if (m_lutTexture != 0)
     {
@@ -346,6 +1318,12 @@ void cQuadImage::reset()
         m_lutTexture = 0;
     }
     m_lutData.clear();
+    if (m_paletteTexture != 0)
+    {
+        render::deleteTexture(m_paletteTexture);
+        m_paletteTexture = 0;
+    }
+    m_paletteData.clear();
     m_effects = eEffect::None;
 }
 
@@ -406,55 +1384,89 @@ void cQuadImage::useFilter(bool filter)
     m_filter = filter;
     for (auto& chunk : m_chunks)
     {
-        chunk.quad->useFilter(filter);
+        if (chunk.quad != nullptr)
+        {
+            chunk.quad->useFilter(filter);
+        }
     }
-}
 
-bool cQuadImage::isInsideViewport(const Chunk& chunk, const Vectorf& pos) const
-{
-    auto& rc         = render::getRect();
-    const auto& size = chunk.quad->getSize();
-    const Rectf rcQuad{ pos, pos + size };
-    return rc.intersect(rcQuad);
+    if (m_overview != nullptr)
+    {
+        m_overview->useFilter(filter);
+    }
 }
 
-void cQuadImage::render()
+Vectorf cQuadImage::getChunkPos(uint32_t col, uint32_t row) const
 {
     const float halfWidth  = static_cast<float>((m_width + 1) >> 1);
     const float halfHeight = static_cast<float>((m_height + 1) >> 1);
-    const float texWidth   = m_texWidth;
-    const float texHeight  = m_texHeight;
+    return {
+        col * static_cast<float>(m_texWidth) - halfWidth,
+        row * static_cast<float>(m_texHeight) - halfHeight
+    };
+}
 
-    bool isInside = render::getAngle() != 0;
+bool cQuadImage::isInsideViewport(const Vectorf& pos, const Vectorf& size) const
+{
+    return render::isRectVisible({ pos, pos + size });
+}
 
-    auto renderChunk = [&](const Chunk& chunk) {
-        const Vectorf pos{
-            chunk.col * texWidth - halfWidth,
-            chunk.row * texHeight - halfHeight
-        };
-        if (isInside || isInsideViewport(chunk, pos))
-        {
-            if (m_effects != eEffect::None)
+void cQuadImage::addOverviewQuad(const Vectorf& texPos, const Vectorf& texSize, const Vectorf& pos, const Vectorf& size)
+{
+    m_overview->setTextureRect(texPos, texSize);
+    m_overview->setupVertices(pos, size);
+    m_overviewBatch.push_back(m_overview->getQuad());
+}
+
+void cQuadImage::render()
+{
+    // All visible tiles go out in one batch, split only when they need
+    // more textures than the renderer binds at once.
+    m_batch.clear();
+    m_overviewBatch.clear();
+
+    if (isOverviewVisible())
+    {
+        // Far zoomed out, the merged low-resolution texture replaces the grid.
+        const Vectorf texSize{ static_cast<float>(m_overviewWidth), static_cast<float>(m_overviewHeight) };
+        const Vectorf size{ static_cast<float>(m_width), static_cast<float>(m_height) };
+        addOverviewQuad({ 0.0f, 0.0f }, texSize, getChunkPos(0, 0), size);
+    }
+    else
+    {
+        auto addChunk = [this](const Chunk& chunk) {
+            const auto pos = getChunkPos(chunk.col, chunk.row);
+            if (chunk.quad == nullptr)
             {
-                chunk.quad->setupVertices(pos);
-                render::renderPostProcessed(chunk.quad->getQuad(), m_lutTexture, m_effects);
+                // Paged out: stand in with the tile's part of the overview.
+                const Vectorf size{ static_cast<float>(getChunkWidth(chunk.col)), static_cast<float>(getChunkHeight(chunk.row)) };
+                if (m_overview != nullptr && isInsideViewport(pos, size))
+                {
+                    const float scale = 1.0f / static_cast<float>(1u << m_overviewLevel);
+                    const Vectorf texPos{ static_cast<float>(chunk.col * m_texWidth) * scale, static_cast<float>(chunk.row * m_texHeight) * scale };
+                    addOverviewQuad(texPos, size * scale, pos, size);
+                }
             }
-            else
+            else if (isInsideViewport(pos, chunk.quad->getSize()))
             {
-                chunk.quad->render(pos);
+                chunk.quad->setupVertices(pos);
+                m_batch.push_back(chunk.quad->getQuad());
             }
+        };
+
+        for (const auto& chunk : m_chunksOld)
+        {
+            addChunk(chunk);
         }
-    };
 
-    for (const auto& chunk : m_chunksOld)
-    {
-        renderChunk(chunk);
+        for (const auto& chunk : m_chunks)
+        {
+            addChunk(chunk);
+        }
     }
 
-    for (const auto& chunk : m_chunks)
-    {
-        renderChunk(chunk);
-    }
+    render::renderBatch(m_batch.data(), static_cast<uint32_t>(m_batch.size()), m_lutTexture, m_paletteTexture, m_effects);
+    render::renderBatch(m_overviewBatch.data(), static_cast<uint32_t>(m_overviewBatch.size()), m_lutTexture, 0, m_overviewEffects);
 }
 
 bool cQuadImage::getPixel(uint32_t x, uint32_t y, cColor& color) const
@@ -465,7 +1477,7 @@ bool cQuadImage::getPixel(uint32_t x, uint32_t y, cColor& color) const
     }
 
     // Return cached pixel if coordinates match
-    if (m_pixelCache.x == x && m_pixelCache.y == y)
+    if (m_pixelCache.x == x && m_pixelCache.y == y && m_pixelCache.exposure == render::getExposure())
     {
         color.r = m_pixelCache.rgba[0];
         color.g = m_pixelCache.rgba[1];
@@ -474,31 +1486,94 @@ bool cQuadImage::getPixel(uint32_t x, uint32_t y, cColor& color) const
         return true;
     }
 
-    const uint32_t col = x / m_texWidth;
-    const uint32_t row = y / m_texHeight;
-
-    // Find the chunk
-    const cQuad* quad = nullptr;
-    for (const auto& chunk : m_chunks)
+    // Float textures are read back unclamped, the rest as 8-bit.
+    float texel[4]  = {};
+    uint8_t rgba[4] = {};
+    if (m_compressed)
     {
-        if (chunk.col == col && chunk.row == row)
+        decodeCompressedPixel(x, y, rgba);
+    }
+    else
+    {
+        const uint32_t col = x / m_texWidth;
+        const uint32_t row = y / m_texHeight;
+
+        // Find the chunk
+        const cQuad* quad = nullptr;
+        for (const auto& chunk : m_chunks)
         {
-            quad = chunk.quad.get();
-            break;
+            if (chunk.col == col && chunk.row == row)
+            {
+                quad = chunk.quad.get();
+                break;
+            }
+        }
+
+        if (quad == nullptr)
+        {
+            return false;
+        }
+
+        // Texels come from tiles read back asynchronously, the popup keeps
+        // the last known color until the tile under the cursor lands.
+        const uint32_t lx = x - col * m_texWidth;
+        const uint32_t ly = y - row * m_texHeight;
+        const uint32_t w  = getChunkWidth(col);
+        const uint32_t h  = getChunkHeight(row);
+        const auto& q     = quad->getQuad();
+        bool found        = false;
+        if (m_format == ePixelFormat::RGBA16F)
+        {
+            found = m_texels.getTexel(q.tex, w, h, lx, ly, texel);
+        }
+        else if (ycbcr::isPlanar(m_format))
+        {
+            // Nearest chroma sample, as the shader does without filtering.
+            const auto layout = ycbcr::getLayout(m_format, m_width);
+            const uint32_t cw = ycbcr::getChromaSize(w, layout.factorX);
+            const uint32_t ch = ycbcr::getChromaSize(h, layout.factorY);
+            uint8_t y[4], cb[4], cr[4];
+            found = m_texels.getTexel(q.tex, w, h, lx, ly, y);
+            found = m_texels.getTexel(q.chroma[0], cw, ch, lx / layout.factorX, ly / layout.factorY, cb) && found;
+            found = m_texels.getTexel(q.chroma[1], cw, ch, lx / layout.factorX, ly / layout.factorY, cr) && found;
+            if (found)
+            {
+                ycbcr::toRgb(y[0], cb[0], cr[0], rgba);
+                rgba[3] = 255;
+            }
+        }
+        else if (m_format == ePixelFormat::Indexed8)
+        {
+            uint8_t index[4];
+            found = m_texels.getTexel(q.tex, w, h, lx, ly, index);
+            if (found && m_paletteData.size() >= 256 * 4)
+            {
+                ::memcpy(rgba, &m_paletteData[index[0] * 4], 4);
+            }
+        }
+        else
+        {
+            found = m_texels.getTexel(q.tex, w, h, lx, ly, rgba);
+        }
+
+        if (found == false)
+        {
+            color.r = m_pixelCache.rgba[0];
+            color.g = m_pixelCache.rgba[1];
+            color.b = m_pixelCache.rgba[2];
+            color.a = m_pixelCache.rgba[3];
+            return true;
         }
     }
 
-    if (quad == nullptr)
+    if (m_format != ePixelFormat::RGBA16F)
     {
-        return false;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            texel[i] = rgba[i] / 255.0f;
+        }
     }
 
-    // Read a single pixel from the texture via FBO
-    const uint32_t lx = x - col * m_texWidth;
-    const uint32_t ly = y - row * m_texHeight;
-    uint8_t rgba[4]   = {};
-    render::readTexPixel(quad->getQuad().tex, lx, ly, rgba);
-
     // FBO readback returns raw stored channels without applying texture swizzle
     // or shader post-processing. Apply the same transformations as the shader.
     float r, g, b;
@@ -506,28 +1581,29 @@ bool cQuadImage::getPixel(uint32_t x, uint32_t y, cColor& color) const
 
     if (m_format == ePixelFormat::Luminance)
     {
-        r = g = b = rgba[0] / 255.0f;
+        r = g = b = texel[0];
         alpha     = 1.0f;
     }
     else if (m_format == ePixelFormat::LuminanceAlpha)
     {
-        r = g = b = rgba[0] / 255.0f;
-        alpha     = rgba[1] / 255.0f;
+        r = g = b = texel[0];
+        alpha     = texel[1];
     }
     else if (m_format == ePixelFormat::Alpha)
     {
         r = g = b = 0.0f;
-        alpha     = rgba[0] / 255.0f;
+        alpha     = texel[0];
     }
     else
     {
-        r     = rgba[0] / 255.0f;
-        g     = rgba[1] / 255.0f;
-        b     = rgba[2] / 255.0f;
-        alpha = rgba[3] / 255.0f;
+        r     = texel[0];
+        g     = texel[1];
+        b     = texel[2];
+        alpha = texel[3];
     }
 
-    // Apply effects matching GPU shader order: CMYK→RGB, unpremultiply, LUT
+    // Apply effects matching GPU shader order: CMYK→RGB, unpremultiply,
+    // tone mapping, LUT
     if (m_effects & eEffect::Cmyk)
     {
         r     = r * alpha;
@@ -546,6 +1622,21 @@ bool cQuadImage::getPixel(uint32_t x, uint32_t y, cColor& color) const
         }
     }
 
+    if (m_effects & eEffect::ToneMap)
+    {
+        const float exposure = ::exp2f(render::getExposure());
+        auto toneMap         = [exposure](float c) {
+            c = std::max(c * exposure, 0.0f);
+            c = c / (1.0f + c);
+            return c < 0.0031308f
+                ? c * 12.92f
+                : 1.055f * ::powf(c, 1.0f / 2.4f) - 0.055f;
+        };
+        r = toneMap(r);
+        g = toneMap(g);
+        b = toneMap(b);
+    }
+
     // Apply 3D LUT (trilinear interpolation matching GPU shader)
     if (m_lutData.empty() == false && cms::LutGridSize > 1)
     {
@@ -604,16 +1695,32 @@ bool cQuadImage::getPixel(uint32_t x, uint32_t y, cColor& color) const
     color.a = static_cast<uint8_t>(alpha * 255.0f + 0.5f);
 
     // Cache this pixel
-    m_pixelCache.x       = x;
-    m_pixelCache.y       = y;
-    m_pixelCache.rgba[0] = color.r;
-    m_pixelCache.rgba[1] = color.g;
-    m_pixelCache.rgba[2] = color.b;
-    m_pixelCache.rgba[3] = color.a;
+    m_pixelCache.x        = x;
+    m_pixelCache.y        = y;
+    m_pixelCache.exposure = render::getExposure();
+    m_pixelCache.rgba[0]  = color.r;
+    m_pixelCache.rgba[1]  = color.g;
+    m_pixelCache.rgba[2]  = color.b;
+    m_pixelCache.rgba[3]  = color.a;
 
     return true;
 }
 
+void cQuadImage::decodeCompressedPixel(uint32_t x, uint32_t y, uint8_t* rgba) const
+{
+    // Compressed textures can't be attached to the readback FBO,
+    // decode the single block containing the pixel instead.
+    const auto& block      = compressed::getBlockInfo(m_compressedFormat);
+    const uint32_t blocksW = (m_width + block.width - 1) / block.width;
+    const size_t offset    = (static_cast<size_t>(y / block.height) * blocksW + x / block.width) * block.bytes;
+
+    uint8_t texels[8 * 8 * 4];
+    gpu_decode::decode(m_compressedFormat, m_compressedData.data() + offset, texels, block.width, block.height);
+
+    const uint32_t texel = (y % block.height) * block.width + x % block.width;
+    ::memcpy(rgba, &texels[texel * 4], 4);
+}
+
 void cQuadImage::moveToOld()
 {
     clearOld();
@@ -624,7 +1731,7 @@ void cQuadImage::moveToOld()
         auto& chunk = m_chunks[idx];
         if (chunk.col >= m_cols || chunk.row >= m_rows)
         {
-            m_gpuMemory -= chunkGpuBytes(chunk.quad->getTexWidth(), chunk.quad->getTexHeight());
+            m_gpuMemory -= residentBytes(chunk);
             m_chunks[idx] = std::move(m_chunks.back());
             m_chunks.pop_back();
         }
@@ -634,9 +1741,10 @@ void cQuadImage::moveToOld()
     m_chunks.clear();
 }
 
-cQuad* cQuadImage::findAndRemoveOld(uint32_t col, uint32_t row)
+cQuad* cQuadImage::findAndRemoveOld(uint32_t col, uint32_t row, uint32_t& uploadedHeight)
 {
-    cQuad* quad = nullptr;
+    cQuad* quad    = nullptr;
+    uploadedHeight = 0;
 
     for (size_t i = 0, size = m_chunksOld.size(); i < size; i++)
     {
@@ -644,7 +1752,8 @@ cQuad* cQuadImage::findAndRemoveOld(uint32_t col, uint32_t row)
         auto& chunk = m_chunksOld[idx];
         if (chunk.col == col && chunk.row == row)
         {
-            m_gpuMemory -= chunkGpuBytes(chunk.quad->getTexWidth(), chunk.quad->getTexHeight());
+            m_gpuMemory -= residentBytes(chunk);
+            uploadedHeight   = chunk.uploadedHeight;
             quad             = chunk.quad.release();
             m_chunksOld[idx] = std::move(m_chunksOld.back());
             m_chunksOld.pop_back();
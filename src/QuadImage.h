@@ -9,8 +9,10 @@
 
 #pragma once
 
+#include "Common/CompressedFormat.h"
 #include "Common/PixelFormat.h"
 #include "Renderer.h"
+#include "TexelCache.h"
 #include "Types/Color.h"
 #include "Types/Vector.h"
 
@@ -35,8 +37,43 @@ public:
         return m_lutTexture != 0;
     }
 
-    void setCompressedBuffer(uint32_t width, uint32_t height, uint32_t format, uint32_t compressedSize, const uint8_t* image);
+    // 256 RGBA entries looked up by Indexed8 tiles.
+    void setPaletteData(const std::vector<uint8_t>& data);
+
+    // Raw GPU blocks, copied and uploaded in tiles of whole blocks.
+    void setCompressedBuffer(uint32_t width, uint32_t height, eCompressedFormat format, const uint8_t* image);
     bool upload(uint32_t readyHeight);
+    // Replaces an area of a completely uploaded image, data rows are pitch
+    // bytes apart. False when the tiles can't be patched in place (planar,
+    // compressed, paged or with an overview).
+    bool updateRect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint8_t* data, uint32_t pitch);
+
+    // Per-frame upload limits, 0 = unlimited. Visible tiles go first.
+    void setUploadBudget(double ms, size_t bytes)
+    {
+        m_budgetMs    = ms;
+        m_budgetBytes = bytes;
+    }
+
+    // Bytes sent to the GPU by the last upload() call.
+    size_t getUploadedBytes() const
+    {
+        return m_uploadedBytes;
+    }
+
+    // Image rows whose tiles are all uploaded.
+    uint32_t getUploadedHeight() const;
+
+    // GPU memory ceiling for image tiles, 0 = unlimited. Images over it keep
+    // tiles on the CPU and only the ones around the view on the GPU.
+    void setGpuBudget(size_t bytes)
+    {
+        m_gpuBudget = bytes;
+    }
+
+    // Pages tiles in and out for the current view, once per frame.
+    // Returns true if any tile changed residency.
+    bool updateResidency();
 
     void stop();
     void reset();
@@ -51,7 +88,11 @@ public:
         return m_gpuMemory;
     }
 
+    // Until the texels under x, y are read back, color is the last pixel
+    // returned. updateReadback() collects the reads, true if any landed.
     bool getPixel(uint32_t x, uint32_t y, cColor& color) const;
+    bool updateReadback();
+    bool isReadbackPending() const;
 
     uint32_t getWidth() const
     {
@@ -89,25 +130,53 @@ private:
         uint32_t col;
         uint32_t row;
         uint32_t uploadedHeight = 0;
-        std::unique_ptr<cQuad> quad;
+        std::unique_ptr<cQuad> quad; // nullptr while paged out
+        std::vector<uint8_t> pixels; // CPU copy of the tile when paging
+        uint32_t lastUsed = 0;       // last frame the view needed the tile
+        bool isRefining   = false;   // previous content shows below the uploaded rows
+        std::vector<float> overviewSums = {}; // overview block row in progress
     };
 
-    bool isInsideViewport(const Chunk& chunk, const Vectorf& pos) const;
+    Vectorf getChunkPos(uint32_t col, uint32_t row) const;
+    bool isInsideViewport(const Vectorf& pos, const Vectorf& size) const;
+    Chunk* findChunk(uint32_t col, uint32_t row);
 
     void moveToOld();
     void clearOld();
-    cQuad* findAndRemoveOld(uint32_t col, uint32_t row);
-    void createChunk(uint32_t col, uint32_t row, uint32_t readyHeight);
-    void updateChunkSubData(Chunk& chunk, uint32_t available);
+    cQuad* findAndRemoveOld(uint32_t col, uint32_t row, uint32_t& uploadedHeight);
+    size_t createChunk(uint32_t col, uint32_t row, uint32_t readyHeight);
+    uint8_t* mapUploadBuffer(size_t size);
+    void copyRows(uint8_t* out, uint32_t sx, uint32_t sy, uint32_t rows, uint32_t dstPitch, uint32_t step = 1) const;
+    // Copies image rows [sy, sy + rows) of a tile column to row dy of a tile
+    // tileRows high, split into planes for planar formats.
+    void copyTile(uint8_t* out, uint32_t col, uint32_t sy, uint32_t rows, uint32_t dy, uint32_t tileRows) const;
+    size_t getTileBytes(uint32_t w, uint32_t rows) const;
+    std::unique_ptr<cQuad> createCompressedQuad(uint32_t col, uint32_t row);
+    size_t createCompressedChunk(uint32_t col, uint32_t row);
+    void completeChunk(Chunk& chunk);
+    // Box-filters tile rows [dy, dy + rows) into the overview as they are
+    // uploaded.
+    void addOverviewRows(Chunk& chunk, uint32_t dy, uint32_t rows);
+    uint32_t getOverviewChannels() const;
+    void storeOverviewPixel(const float* v, uint8_t* out) const;
+    size_t pageIn(Chunk& chunk);
+    bool isBudgetSpent(size_t bytes, double start) const;
+    void prepareOverview();
+    void createOverview();
+    void releaseOverview();
+    bool isOverviewVisible() const;
+    void addOverviewQuad(const Vectorf& texPos, const Vectorf& texSize, const Vectorf& pos, const Vectorf& size);
+    void decodeCompressedPixel(uint32_t x, uint32_t y, uint8_t* rgba) const;
+    size_t updateChunkSubData(Chunk& chunk, uint32_t available);
     uint32_t getChunkHeight(uint32_t row) const;
     uint32_t getChunkWidth(uint32_t col) const;
 
 private:
-    bool m_started              = false;
-    bool m_filter               = false;
-    bool m_compressed           = false;
-    uint32_t m_compressedFormat = 0; // GL internal format for compressed textures
-    uint32_t m_compressedSize   = 0;
+    bool m_started                       = false;
+    bool m_filter                        = false;
+    bool m_compressed                    = false;
+    eCompressedFormat m_compressedFormat = eCompressedFormat::None;
+    std::vector<uint8_t> m_compressedData; // kept for getPixel(), the bitmap is released after upload
 
     uint32_t m_texWidth  = 0;
     uint32_t m_texHeight = 0;
@@ -124,23 +193,53 @@ private:
     const uint8_t* m_image  = nullptr;
 
     size_t chunkGpuBytes(uint32_t tw, uint32_t th) const;
+    size_t overviewGpuBytes(uint32_t tw, uint32_t th) const;
+    size_t residentBytes(const Chunk& chunk) const;
 
     std::vector<Chunk> m_chunks;
     std::vector<Chunk> m_chunksOld;
+    std::vector<Quad> m_batch;         // visible quads of the frame, reused
+    std::vector<Quad> m_overviewBatch; // overview quads, drawn with m_overviewEffects
+
+    // Whole image at mip level m_overviewLevel, drawn when zoomed out that
+    // far and in place of paged-out tiles. Assembled in m_overviewData from
+    // the rows as they are uploaded.
+    std::unique_ptr<cQuad> m_overview;
+    std::vector<uint8_t> m_overviewData;
+    uint32_t m_overviewLevel      = 0;
+    uint32_t m_overviewWidth      = 0;
+    uint32_t m_overviewHeight     = 0;
+    ePixelFormat m_overviewFormat = ePixelFormat::RGB;
+    uint32_t m_overviewBpp        = 0;
+    eEffect m_overviewEffects     = eEffect::None;
+
+    bool m_paging      = false;
+    size_t m_gpuBudget = 0;
+    uint32_t m_frame   = 0;
 
     size_t m_gpuMemory = 0;
-    std::vector<uint8_t> m_buffer;
+
+    double m_budgetMs      = 0.0;
+    size_t m_budgetBytes   = 0;
+    size_t m_uploadedBytes = 0;
+    std::vector<uint8_t> m_buffer; // staging fallback when no upload buffer can be mapped
 
     // GPU ICC: 3D LUT texture + CPU-side data for getPixel()
     GLuint m_lutTexture = 0;
     std::vector<uint8_t> m_lutData;
     eEffect m_effects = eEffect::None;
 
+    // Palette of Indexed8 images + CPU-side copy for getPixel() and the overview
+    GLuint m_paletteTexture = 0;
+    std::vector<uint8_t> m_paletteData;
+
     // Pixel readback cache: stores the last-read pixel
     mutable struct PixelCache
     {
         uint32_t x      = std::numeric_limits<uint32_t>::max();
         uint32_t y      = std::numeric_limits<uint32_t>::max();
+        float exposure  = 0.0f; // tone mapped pixels depend on it
         uint8_t rgba[4] = {};
     } m_pixelCache;
+    mutable cTexelCache m_texels;
 };
@@ -11,13 +11,22 @@
 \**********************************************/
 
 #include "Renderer.h"
+#include "Common/Helpers.h"
+#include "Common/Timing.h"
+#include "Common/YCbCr.h"
 #include "Log/Log.h"
 #include "Types/Matrix.h"
 #include "Types/Vector.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iterator>
+#include <lz4/xxhash.h>
+#include <string>
+#include <unistd.h>
 #include <vector>
 
 namespace
@@ -25,36 +34,100 @@ namespace
     Rectf ViewRect;
     float ViewZoom = 1.0f;
     int ViewAngle  = 0;
+    float Exposure = 0.0f;
     Vectori ViewportSize;
     GLuint CurrentTextureId   = 0;
     uint32_t TextureSizeLimit = 1024;
 
-    // Shader programs
-    // FIXME: Consider to generate shaders on demand instead of compiling all variants at startup.
-    constexpr uint32_t PostProcessVariants = 8;
+    // Shader programs, built on first use of a variant
+    constexpr uint32_t PostProcessVariants = 64;
+
+    // Textures a batched draw can sample, bound to units 0..N-1. The LUT
+    // and the palette take the next units.
+    constexpr uint32_t BatchTextures      = 8;
+    constexpr uint32_t LutTextureUnit     = BatchTextures;
+    constexpr uint32_t PaletteTextureUnit = LutTextureUnit + 1;
+    constexpr uint32_t BatchMaxQuads      = 1024;
 
     struct PostProcessProgram
     {
         GLuint program = 0;
         GLint projLoc  = -1;
-        GLint texLoc   = -1;
-        GLint lutLoc   = -1;
+        GLint texLoc      = -1;
+        GLint lutLoc      = -1;
+        GLint paletteLoc  = -1;
+        GLint exposureLoc = -1;
     };
 
     PostProcessProgram PPPrograms[PostProcessVariants];
     GLuint ColoredProgram = 0;
     GLint ColoredProjLoc  = -1;
 
+    // Program binary cache. The entry points are missing from the GL 3.3
+    // loader, they stay nullptr if the driver can't save binaries.
+    typedef void(APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void(APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    typedef void(APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+    GetProgramBinaryProc GetProgramBinary   = nullptr;
+    ProgramBinaryProc ProgramBinary         = nullptr;
+    ProgramParameteriProc ProgramParameteri = nullptr;
+    std::string ProgramCacheDir;
+    std::string DriverKey; // vendor, renderer and version, binaries are only valid for these
+
+    constexpr char ProgramMagic[4]   = { 'S', 'V', 'S', 'H' };
+    constexpr uint32_t ProgramVersion = 1;
+
+    struct ProgramHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t keySize;
+        uint32_t binaryFormat;
+        uint32_t binarySize;
+    };
+
     // VAO/VBO/IBO
     GLuint Vao = 0;
     GLuint Vbo = 0;
     GLuint Ibo = 0;
 
-    // FBO for single-pixel readback
+    // Batched quads carry the texture slot per vertex.
+    struct BatchVertex
+    {
+        Vertex v;
+        GLfloat slot;
+    };
+
+    GLuint BatchVao = 0;
+    GLuint BatchVbo = 0;
+    GLuint BatchIbo = 0;
+    std::vector<BatchVertex> BatchVertices;
+
+    // FBO for texture readback
     GLuint ReadbackFbo = 0;
 
-    // Current projection matrix
-    Matrix4 Projection = Matrix4::Identity();
+    // Ring of pixel unpack buffers for streaming texture uploads. A slot is
+    // mapped again only after the fence of its previous copy has signaled.
+    // Fences are polled, never waited on: with every slot still in flight
+    // the upload is staged in client memory instead.
+    constexpr uint32_t UploadRingSize = 3;
+
+    struct UploadSlot
+    {
+        GLuint pbo      = 0;
+        size_t capacity = 0;
+        GLsync fence    = nullptr;
+    };
+
+    UploadSlot UploadRing[UploadRingSize];
+    uint32_t UploadIndex         = 0;
+    const uint8_t* UploadPending = nullptr;
+
+    // Current projection matrix, and the rotation/flip part of it that
+    // maps image space into the view rect
+    Matrix4 Projection    = Matrix4::Identity();
+    Matrix4 ViewTransform = Matrix4::Identity();
 
     struct GLState
     {
@@ -76,14 +149,17 @@ namespace
 layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec2 aTexCoord;
 layout(location = 2) in vec4 aColor;
+layout(location = 3) in float aSlot;
 uniform mat4 uProjection;
 out vec2 vTexCoord;
 out vec4 vColor;
+flat out int vSlot;
 void main()
 {
     gl_Position = uProjection * vec4(aPos, 0.0, 1.0);
     vTexCoord = aTexCoord;
     vColor = aColor;
+    vSlot = int(aSlot + 0.5);
 }
 )glsl";
 
@@ -91,20 +167,56 @@ void main()
     constexpr const char* PostProcessFragBody = R"glsl(
 in vec2 vTexCoord;
 in vec4 vColor;
-uniform sampler2D uTexture;
 #ifdef HAS_LUT
 uniform sampler3D uLut;
 #endif
+#ifdef TONE_MAP
+uniform float uExposure;
+#endif
+#ifdef PALETTE
+uniform sampler2D uPalette;
+#endif
 out vec4 FragColor;
+#ifdef YCBCR
+// Y is in the quad's slot, Cb and Cr in the next two. Chroma planes are the
+// luma plane subsampled and rounded up, the factor follows from the sizes.
+vec4 sampleYCbCr(vec2 uv)
+{
+    vec2 lumaSize = vec2(slotSize(vSlot));
+    vec2 chromaSize = vec2(slotSize(vSlot + 1));
+    vec2 factor = max(floor(lumaSize / chromaSize + 0.5), vec2(1.0));
+    vec2 chromaUv = uv * lumaSize / (chromaSize * factor);
+    float y = sampleSlot(vSlot, uv).r;
+    float cb = sampleSlot(vSlot + 1, chromaUv).r - 128.0 / 255.0;
+    float cr = sampleSlot(vSlot + 2, chromaUv).r - 128.0 / 255.0;
+    // JFIF full-range BT.601
+    vec3 rgb = vec3(y + 1.402 * cr, y - 0.344136 * cb - 0.714136 * cr, y + 1.772 * cb);
+    return vec4(clamp(rgb, 0.0, 1.0), 1.0);
+}
+#endif
 void main()
 {
-    vec4 texel = texture(uTexture, vTexCoord);
+#ifdef YCBCR
+    vec4 texel = sampleYCbCr(vTexCoord);
+#else
+    vec4 texel = sampleSlot(vSlot, vTexCoord);
+#endif
+#ifdef PALETTE
+    // Indices come normalized, one palette texel each.
+    texel = texelFetch(uPalette, ivec2(int(texel.r * 255.0 + 0.5), 0), 0);
+#endif
     vec3 rgb = texel.rgb;
     float alpha = texel.a;
 #ifdef UNPREMULTIPLY
     if (alpha > 0.0)
         rgb /= alpha;
 #endif
+#ifdef TONE_MAP
+    // Scene-linear: exposure, Reinhard, sRGB encoding
+    rgb = max(rgb * uExposure, 0.0);
+    rgb = rgb / (1.0 + rgb);
+    rgb = mix(rgb * 12.92, 1.055 * pow(rgb, vec3(1.0 / 2.4)) - 0.055, step(0.0031308, rgb));
+#endif
 #ifdef CMYK
 #ifdef HAS_LUT
     // ICC path: LUT maps raw (C,M,Y) → ICC-correct RGB, then darken by K
@@ -152,6 +264,43 @@ void main()
         {
             src += "#define HAS_LUT\n";
         }
+        if (flags & static_cast<uint32_t>(eEffect::ToneMap))
+        {
+            src += "#define TONE_MAP\n";
+        }
+        if (flags & static_cast<uint32_t>(eEffect::YCbCr))
+        {
+            src += "#define YCBCR\n";
+        }
+        if (flags & static_cast<uint32_t>(eEffect::Palette))
+        {
+            src += "#define PALETTE\n";
+        }
+
+        // Sampler arrays take only constant indices in GLSL 3.30, lookups
+        // by slot go through a switch.
+        auto addSwitch = [&src](const char* signature, const char* prefix, const char* suffix) {
+            auto lookup = [=](uint32_t i) {
+                return std::string(prefix) + "uTextures[" + std::to_string(i) + "]" + suffix;
+            };
+            src += std::string(signature) + "\n"
+                   "{\n"
+                   "    switch (slot)\n"
+                   "    {\n";
+            for (uint32_t i = 1; i < BatchTextures; i++)
+            {
+                src += "    case " + std::to_string(i) + ": return " + lookup(i) + ";\n";
+            }
+            src += "    }\n"
+                   "    return " + lookup(0) + ";\n"
+                   "}\n";
+        };
+
+        src += "uniform sampler2D uTextures[" + std::to_string(BatchTextures) + "];\n"
+               "flat in int vSlot;\n";
+        addSwitch("vec4 sampleSlot(int slot, vec2 uv)", "texture(", ", uv)");
+        addSwitch("ivec2 slotSize(int slot)", "textureSize(", ", 0)");
+
         src += PostProcessFragBody;
         return src;
     }
@@ -181,6 +330,10 @@ void main()
         GLuint program = glCreateProgram();
         glAttachShader(program, vert);
         glAttachShader(program, frag);
+        if (ProgramParameteri != nullptr)
+        {
+            ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
         glLinkProgram(program);
 
         GLint success = 0;
@@ -197,10 +350,396 @@ void main()
         return program;
     }
 
+    void initProgramCache(GLADloadproc loadProc)
+    {
+        GetProgramBinary  = nullptr;
+        ProgramBinary     = nullptr;
+        ProgramParameteri = nullptr;
+        ProgramCacheDir.clear();
+        DriverKey.clear();
+
+        GLint major = 0;
+        GLint minor = 0;
+        GL(glGetIntegerv(GL_MAJOR_VERSION, &major));
+        GL(glGetIntegerv(GL_MINOR_VERSION, &minor));
+
+        bool supported = major * 10 + minor >= 41;
+        GLint count    = 0;
+        GL(glGetIntegerv(GL_NUM_EXTENSIONS, &count));
+        for (GLint i = 0; i < count && supported == false; i++)
+        {
+            auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            supported = name != nullptr && ::strcmp(name, "GL_ARB_get_program_binary") == 0;
+        }
+
+        GLint formats = 0;
+        if (supported)
+        {
+            GL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+        }
+        if (formats == 0)
+        {
+            return;
+        }
+
+        GetProgramBinary  = reinterpret_cast<GetProgramBinaryProc>(loadProc("glGetProgramBinary"));
+        ProgramBinary     = reinterpret_cast<ProgramBinaryProc>(loadProc("glProgramBinary"));
+        ProgramParameteri = reinterpret_cast<ProgramParameteriProc>(loadProc("glProgramParameteri"));
+        if (GetProgramBinary == nullptr || ProgramBinary == nullptr)
+        {
+            GetProgramBinary = nullptr;
+            ProgramBinary    = nullptr;
+            return;
+        }
+
+        ProgramCacheDir = helpers::getCacheDirectory("shaders");
+
+        for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            auto value = reinterpret_cast<const char*>(glGetString(name));
+            DriverKey += value != nullptr ? value : "";
+            DriverKey += "\n";
+        }
+    }
+
+    std::string getProgramFileName(const std::string& key)
+    {
+        char name[32];
+        ::snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(XXH64(key.data(), key.size(), 0)));
+        return ProgramCacheDir + name;
+    }
+
+    GLuint loadProgram(const std::string& key)
+    {
+        auto file = ::fopen(getProgramFileName(key).c_str(), "rb");
+        if (file == nullptr)
+        {
+            return 0;
+        }
+
+        ProgramHeader header;
+        std::string storedKey;
+        std::vector<uint8_t> binary;
+        bool isValid = ::fread(&header, sizeof(header), 1, file) == 1
+            && ::memcmp(header.magic, ProgramMagic, sizeof(ProgramMagic)) == 0
+            && header.version == ProgramVersion
+            && header.keySize == key.size();
+        if (isValid)
+        {
+            storedKey.resize(header.keySize);
+            binary.resize(header.binarySize);
+            isValid = ::fread(&storedKey[0], header.keySize, 1, file) == 1
+                && storedKey == key
+                && ::fread(binary.data(), binary.size(), 1, file) == 1;
+        }
+        ::fclose(file);
+
+        if (isValid == false)
+        {
+            return 0;
+        }
+
+        // The driver may still reject a binary, e.g. after an update that
+        // kept the version string.
+        GLuint program = glCreateProgram();
+        ProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (success == 0)
+        {
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    void storeProgram(GLuint program, const std::string& key)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+        {
+            return;
+        }
+
+        std::vector<uint8_t> binary(length);
+        GLenum format = 0;
+        GetProgramBinary(program, length, &length, &format, binary.data());
+
+        ProgramHeader header;
+        ::memcpy(header.magic, ProgramMagic, sizeof(ProgramMagic));
+        header.version      = ProgramVersion;
+        header.keySize      = static_cast<uint32_t>(key.size());
+        header.binaryFormat = format;
+        header.binarySize   = static_cast<uint32_t>(length);
+
+        // Write to a temporary name so readers never see a partial entry.
+        const auto fileName = getProgramFileName(key);
+        const auto tmpName  = fileName + ".tmp";
+        auto file           = ::fopen(tmpName.c_str(), "wb");
+        if (file == nullptr)
+        {
+            return;
+        }
+
+        const bool written = ::fwrite(&header, sizeof(header), 1, file) == 1
+            && ::fwrite(key.data(), key.size(), 1, file) == 1
+            && ::fwrite(binary.data(), header.binarySize, 1, file) == 1;
+        ::fclose(file);
+
+        if (written == false || ::rename(tmpName.c_str(), fileName.c_str()) != 0)
+        {
+            ::unlink(tmpName.c_str());
+        }
+    }
+
+    // Links the program from the cache if possible, otherwise from source
+    // and caches the result.
+    GLuint buildProgram(const char* name, const char* vertSrc, const std::string& fragSrc)
+    {
+        const double start = timing::seconds();
+        const bool hasCache = ProgramBinary != nullptr && ProgramCacheDir.empty() == false;
+        const auto key      = hasCache ? DriverKey + vertSrc + fragSrc : std::string();
+
+        GLuint program = hasCache ? loadProgram(key) : 0;
+        const bool isCached = program != 0;
+        if (isCached == false)
+        {
+            program = createProgram(vertSrc, fragSrc.c_str());
+            if (hasCache)
+            {
+                storeProgram(program, key);
+            }
+        }
+
+        cLog::Debug("  shader {}: {:.1f} ms ({})", name, (timing::seconds() - start) * 1000.0,
+                    isCached ? "cached" : "compiled");
+
+        return program;
+    }
+
+    PostProcessProgram& getPostProcessProgram(eEffect effects)
+    {
+        const auto flags = static_cast<uint32_t>(effects) & (PostProcessVariants - 1);
+        auto& pp         = PPPrograms[flags];
+        if (pp.program != 0)
+        {
+            return pp;
+        }
+
+        const auto name = "variant " + std::to_string(flags);
+        pp.program      = buildProgram(name.c_str(), VertexShaderSource, buildPostProcessFrag(flags));
+        pp.projLoc      = glGetUniformLocation(pp.program, "uProjection");
+        pp.texLoc       = glGetUniformLocation(pp.program, "uTextures");
+        pp.lutLoc       = glGetUniformLocation(pp.program, "uLut");
+        pp.paletteLoc   = glGetUniformLocation(pp.program, "uPalette");
+        pp.exposureLoc  = glGetUniformLocation(pp.program, "uExposure");
+
+        // Sampler units never change, set them once.
+        GLint units[BatchTextures];
+        for (uint32_t i = 0; i < BatchTextures; i++)
+        {
+            units[i] = static_cast<GLint>(i);
+        }
+        GL(glUseProgram(pp.program));
+        GL(glUniform1iv(pp.texLoc, BatchTextures, units));
+        if (pp.lutLoc != -1)
+        {
+            GL(glUniform1i(pp.lutLoc, LutTextureUnit));
+        }
+        if (pp.paletteLoc != -1)
+        {
+            GL(glUniform1i(pp.paletteLoc, PaletteTextureUnit));
+        }
+
+        return pp;
+    }
+
+    GLuint getColoredProgram()
+    {
+        if (ColoredProgram == 0)
+        {
+            ColoredProgram = buildProgram("colored", VertexShaderSource, ColoredFragSource);
+            ColoredProjLoc = glGetUniformLocation(ColoredProgram, "uProjection");
+        }
+        return ColoredProgram;
+    }
+
+    // Compressed formats
+    struct CompressedMapping
+    {
+        eCompressedFormat format;
+        GLenum internalFormat;
+    };
+
+    constexpr CompressedMapping CompressedFormatTable[] = {
+        { eCompressedFormat::None, 0 },
+        { eCompressedFormat::BC1, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT },
+        { eCompressedFormat::BC2, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT },
+        { eCompressedFormat::BC3, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT },
+        { eCompressedFormat::BC4, GL_COMPRESSED_RED_RGTC1 },
+        { eCompressedFormat::BC5, GL_COMPRESSED_RG_RGTC2 },
+        { eCompressedFormat::BC7, GL_COMPRESSED_RGBA_BPTC_UNORM },
+        { eCompressedFormat::ETC2_RGB, GL_COMPRESSED_RGB8_ETC2 },
+        { eCompressedFormat::ETC2_RGBA, GL_COMPRESSED_RGBA8_ETC2_EAC },
+        { eCompressedFormat::ETC2_RGBA1, GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 },
+        { eCompressedFormat::EAC_R11, GL_COMPRESSED_R11_EAC },
+        { eCompressedFormat::EAC_RG11, GL_COMPRESSED_RG11_EAC },
+        { eCompressedFormat::ASTC_4x4, GL_COMPRESSED_RGBA_ASTC_4x4_KHR },
+        { eCompressedFormat::ASTC_6x6, GL_COMPRESSED_RGBA_ASTC_6x6_KHR },
+        { eCompressedFormat::ASTC_8x8, GL_COMPRESSED_RGBA_ASTC_8x8_KHR },
+    };
+    static_assert(std::size(CompressedFormatTable) == static_cast<size_t>(eCompressedFormat::Count), "Compressed format table mismatch");
+
+    void probeCompressedFormats()
+    {
+        bool s3tc = false;
+        bool bptc = false;
+        bool etc2 = false;
+        bool astc = false;
+
+        GLint count = 0;
+        GL(glGetIntegerv(GL_NUM_EXTENSIONS, &count));
+        for (GLint i = 0; i < count; i++)
+        {
+            auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (name == nullptr)
+            {
+                continue;
+            }
+
+            if (::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+            {
+                s3tc = true;
+            }
+            else if (::strcmp(name, "GL_ARB_texture_compression_bptc") == 0)
+            {
+                bptc = true;
+            }
+            else if (::strcmp(name, "GL_ARB_ES3_compatibility") == 0)
+            {
+                etc2 = true;
+            }
+            else if (::strcmp(name, "GL_KHR_texture_compression_astc_ldr") == 0)
+            {
+                astc = true;
+            }
+        }
+
+        // BPTC is core since 4.2, ETC2/EAC since 4.3.
+        GLint major = 0;
+        GLint minor = 0;
+        GL(glGetIntegerv(GL_MAJOR_VERSION, &major));
+        GL(glGetIntegerv(GL_MINOR_VERSION, &minor));
+        const GLint version = major * 10 + minor;
+        bptc                = bptc || version >= 42;
+        etc2                = etc2 || version >= 43;
+
+        compressed::setSupported(eCompressedFormat::BC1, s3tc);
+        compressed::setSupported(eCompressedFormat::BC2, s3tc);
+        compressed::setSupported(eCompressedFormat::BC3, s3tc);
+        // RGTC is core since 3.0.
+        compressed::setSupported(eCompressedFormat::BC4, true);
+        compressed::setSupported(eCompressedFormat::BC5, true);
+        compressed::setSupported(eCompressedFormat::BC7, bptc);
+        compressed::setSupported(eCompressedFormat::ETC2_RGB, etc2);
+        compressed::setSupported(eCompressedFormat::ETC2_RGBA, etc2);
+        compressed::setSupported(eCompressedFormat::ETC2_RGBA1, etc2);
+        compressed::setSupported(eCompressedFormat::EAC_R11, etc2);
+        compressed::setSupported(eCompressedFormat::EAC_RG11, etc2);
+        compressed::setSupported(eCompressedFormat::ASTC_4x4, astc);
+        compressed::setSupported(eCompressedFormat::ASTC_6x6, astc);
+        compressed::setSupported(eCompressedFormat::ASTC_8x8, astc);
+
+        auto yesNo = [](bool value) {
+            return value ? "yes" : "no";
+        };
+        cLog::Debug("Compressed textures: S3TC {}, RGTC yes, BPTC {}, ETC2 {}, ASTC {}.",
+                    yesNo(s3tc), yesNo(bptc), yesNo(etc2), yesNo(astc));
+    }
+
+    // True once the GPU is done with the slot's previous copy.
+    bool pollUploadSlot(UploadSlot& slot)
+    {
+        if (slot.fence == nullptr)
+        {
+            return true;
+        }
+
+        const GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            return false;
+        }
+
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        return true;
+    }
+
+    void releaseUploadSlot(UploadSlot& slot)
+    {
+        // A sync object still in use is deleted once it signals.
+        if (slot.fence != nullptr)
+        {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+    }
+
+    void cancelPendingUpload()
+    {
+        if (UploadPending != nullptr)
+        {
+            GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, UploadRing[UploadIndex].pbo));
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+            UploadPending = nullptr;
+        }
+    }
+
+    // Returns the pointer to hand to glTex*Image: an offset into the bound
+    // unpack buffer if data is the mapped upload buffer, data itself otherwise.
+    const uint8_t* beginUploadSource(const uint8_t* data)
+    {
+        if (data == nullptr || data != UploadPending)
+        {
+            return data;
+        }
+
+        GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, UploadRing[UploadIndex].pbo));
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+        {
+            // Buffer contents were lost (e.g. display mode change).
+            cLog::Warning("Upload buffer was corrupted.");
+        }
+
+        return nullptr;
+    }
+
+    void endUploadSource(const uint8_t* data)
+    {
+        if (data == nullptr || data != UploadPending)
+        {
+            return;
+        }
+
+        auto& slot = UploadRing[UploadIndex];
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+        UploadIndex   = (UploadIndex + 1) % UploadRingSize;
+        UploadPending = nullptr;
+    }
+
 } // namespace
 
-void render::init()
+void render::init(GLADloadproc loadProc)
 {
+    const double start = timing::seconds();
+
     CurrentTextureId = 0;
 
     int maxSize = 0;
@@ -208,19 +747,8 @@ void render::init()
     constexpr uint32_t MaxChunkSize = 4096;
     TextureSizeLimit                = std::min<uint32_t>(static_cast<uint32_t>(maxSize), MaxChunkSize);
 
-    // Create post-process shader variants (mega-shader)
-    for (uint32_t flags = 0; flags < PostProcessVariants; flags++)
-    {
-        auto fragSrc = buildPostProcessFrag(flags);
-        auto& pp     = PPPrograms[flags];
-        pp.program   = createProgram(VertexShaderSource, fragSrc.c_str());
-        pp.projLoc   = glGetUniformLocation(pp.program, "uProjection");
-        pp.texLoc    = glGetUniformLocation(pp.program, "uTexture");
-        pp.lutLoc    = glGetUniformLocation(pp.program, "uLut");
-    }
-
-    ColoredProgram = createProgram(VertexShaderSource, ColoredFragSource);
-    ColoredProjLoc = glGetUniformLocation(ColoredProgram, "uProjection");
+    probeCompressedFormats();
+    initProgramCache(loadProc);
 
     // Create FBO for pixel readback
     GL(glGenFramebuffers(1, &ReadbackFbo));
@@ -249,7 +777,38 @@ void render::init()
     GL(glEnableVertexAttribArray(2));
     GL(glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, color))));
 
+    // Batch VAO: the same layout plus the texture slot, indices for
+    // BatchMaxQuads quads
+    GL(glGenVertexArrays(1, &BatchVao));
+    GL(glBindVertexArray(BatchVao));
+
+    GL(glGenBuffers(1, &BatchVbo));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, BatchVbo));
+
+    std::vector<uint16_t> batchIndices(BatchMaxQuads * 6);
+    for (uint32_t i = 0; i < BatchMaxQuads; i++)
+    {
+        for (uint32_t j = 0; j < 6; j++)
+        {
+            batchIndices[i * 6 + j] = static_cast<uint16_t>(i * 4 + indices[j]);
+        }
+    }
+    GL(glGenBuffers(1, &BatchIbo));
+    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, BatchIbo));
+    GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, batchIndices.size() * sizeof(uint16_t), batchIndices.data(), GL_STATIC_DRAW));
+
+    GL(glEnableVertexAttribArray(0));
+    GL(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), reinterpret_cast<void*>(offsetof(BatchVertex, v) + offsetof(Vertex, x))));
+    GL(glEnableVertexAttribArray(1));
+    GL(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), reinterpret_cast<void*>(offsetof(BatchVertex, v) + offsetof(Vertex, tx))));
+    GL(glEnableVertexAttribArray(2));
+    GL(glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BatchVertex), reinterpret_cast<void*>(offsetof(BatchVertex, v) + offsetof(Vertex, color))));
+    GL(glEnableVertexAttribArray(3));
+    GL(glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), reinterpret_cast<void*>(offsetof(BatchVertex, slot))));
+
     GL(glBindVertexArray(0));
+
+    cLog::Debug("renderer init: {:.1f} ms", (timing::seconds() - start) * 1000.0);
 }
 
 void render::shutdown()
@@ -269,6 +828,22 @@ void render::shutdown()
         glDeleteBuffers(1, &Ibo);
         Ibo = 0;
     }
+    if (BatchVao)
+    {
+        glDeleteVertexArrays(1, &BatchVao);
+        BatchVao = 0;
+    }
+    if (BatchVbo)
+    {
+        glDeleteBuffers(1, &BatchVbo);
+        BatchVbo = 0;
+    }
+    if (BatchIbo)
+    {
+        glDeleteBuffers(1, &BatchIbo);
+        BatchIbo = 0;
+    }
+    BatchVertices = {};
     for (auto& pp : PPPrograms)
     {
         if (pp.program)
@@ -288,6 +863,18 @@ void render::shutdown()
         ReadbackFbo = 0;
     }
 
+    cancelPendingUpload();
+    for (auto& slot : UploadRing)
+    {
+        releaseUploadSlot(slot);
+        if (slot.pbo)
+        {
+            glDeleteBuffers(1, &slot.pbo);
+        }
+        slot = {};
+    }
+    UploadIndex = 0;
+
     ViewZoom         = 1.0f;
     ViewAngle        = 0;
     CurrentTextureId = 0;
@@ -375,23 +962,86 @@ void render::setTextureWrap(GLuint tex, GLenum wrap)
     GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(wrap)));
 }
 
-void render::readTexPixel(GLuint tex, uint32_t x, uint32_t y, uint8_t* rgba)
+bool render::beginReadback(Readback& readback, GLuint tex, uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool isFloat)
 {
-    if (tex == 0 || rgba == nullptr)
+    if (tex == 0 || w == 0 || h == 0)
     {
-        return;
+        return false;
     }
 
-    // Attach texture to readback FBO and read a single pixel
+    deleteReadback(readback);
+
+    const size_t size = static_cast<size_t>(w) * h * 4 * (isFloat ? sizeof(float) : 1);
+    GL(glGenBuffers(1, &readback.pbo));
+    GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo));
+    GL(glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ));
+
+    // With a pack buffer bound glReadPixels only queues the copy.
     GLint prevPackAlignment = 4;
     GL(glGetIntegerv(GL_PACK_ALIGNMENT, &prevPackAlignment));
     GL(glBindFramebuffer(GL_FRAMEBUFFER, ReadbackFbo));
     GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0));
     GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-    GL(glReadPixels(static_cast<GLint>(x), static_cast<GLint>(y), 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba));
+    GL(glReadPixels(static_cast<GLint>(x), static_cast<GLint>(y), static_cast<GLsizei>(w), static_cast<GLsizei>(h),
+                    GL_RGBA, isFloat ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr));
     GL(glPixelStorei(GL_PACK_ALIGNMENT, prevPackAlignment));
     GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0));
     GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.size  = size;
+
+    // Make sure the fence reaches the GPU even if nothing is drawn.
+    GL(glFlush());
+
+    return true;
+}
+
+bool render::finishReadback(Readback& readback, uint8_t* data)
+{
+    if (readback.fence == nullptr)
+    {
+        return false;
+    }
+
+    const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        return false;
+    }
+
+    bool result = false;
+    if (status != GL_WAIT_FAILED)
+    {
+        GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo));
+        auto ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(readback.size), GL_MAP_READ_BIT);
+        checkError("glMapBufferRange", __FILE__, __LINE__);
+        if (ptr != nullptr)
+        {
+            ::memcpy(data, ptr, readback.size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            result = true;
+        }
+        GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    }
+
+    deleteReadback(readback);
+
+    return result;
+}
+
+void render::deleteReadback(Readback& readback)
+{
+    if (readback.fence != nullptr)
+    {
+        glDeleteSync(readback.fence);
+    }
+    if (readback.pbo != 0)
+    {
+        glDeleteBuffers(1, &readback.pbo);
+    }
+    readback = {};
 }
 
 namespace
@@ -415,6 +1065,12 @@ namespace
         { ePixelFormat::RGB565, GL_RGB8, GL_RGB, GL_UNSIGNED_SHORT_5_6_5 },
         { ePixelFormat::RGBA5551, GL_RGB5_A1, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1 },
         { ePixelFormat::RGBA4444, GL_RGBA4, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4 },
+        { ePixelFormat::RGB16, GL_RGB16, GL_RGB, GL_UNSIGNED_SHORT },
+        { ePixelFormat::RGBA16, GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT },
+        { ePixelFormat::RGBA16F, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },
+        { ePixelFormat::YCbCr420, GL_R8, GL_RED, GL_UNSIGNED_BYTE }, // per plane
+        { ePixelFormat::YCbCr422, GL_R8, GL_RED, GL_UNSIGNED_BYTE },
+        { ePixelFormat::Indexed8, GL_R8, GL_RED, GL_UNSIGNED_BYTE },
     };
 
     const FormatMapping* getFormatMapping(ePixelFormat format)
@@ -434,7 +1090,8 @@ void render::setData(GLuint tex, const uint8_t* data, uint32_t w, uint32_t h, eP
 {
     if (tex != 0 && data != nullptr)
     {
-        setTextureFilter(tex, GL_LINEAR, GL_NEAREST);
+        // Palette indices must not be interpolated.
+        setTextureFilter(tex, format == ePixelFormat::Indexed8 ? GL_NEAREST : GL_LINEAR, GL_NEAREST);
         setTextureWrap(tex, GL_CLAMP_TO_EDGE);
 
         auto mapping = getFormatMapping(format);
@@ -444,7 +1101,8 @@ void render::setData(GLuint tex, const uint8_t* data, uint32_t w, uint32_t h, eP
         }
 
         GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
-        GL(glTexImage2D(GL_TEXTURE_2D, 0, mapping->internalFormat, w, h, 0, mapping->uploadFormat, mapping->type, data));
+        GL(glTexImage2D(GL_TEXTURE_2D, 0, mapping->internalFormat, w, h, 0, mapping->uploadFormat, mapping->type, beginUploadSource(data)));
+        endUploadSource(data);
 
         // Set swizzle masks for format compatibility
         if (format == ePixelFormat::Luminance)
@@ -467,7 +1125,12 @@ void render::setData(GLuint tex, const uint8_t* data, uint32_t w, uint32_t h, eP
 
 void render::updateSubData(GLuint tex, const uint8_t* data, uint32_t y, uint32_t w, uint32_t h, ePixelFormat format)
 {
-    if (tex == 0 || data == nullptr || h == 0)
+    updateSubRect(tex, data, 0, y, w, h, format);
+}
+
+void render::updateSubRect(GLuint tex, const uint8_t* data, uint32_t x, uint32_t y, uint32_t w, uint32_t h, ePixelFormat format)
+{
+    if (tex == 0 || data == nullptr || w == 0 || h == 0)
     {
         return;
     }
@@ -481,17 +1144,133 @@ void render::updateSubData(GLuint tex, const uint8_t* data, uint32_t y, uint32_t
     }
 
     GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
-    GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, w, h, mapping->uploadFormat, mapping->type, data));
+    GL(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, mapping->uploadFormat, mapping->type, beginUploadSource(data)));
+    endUploadSource(data);
 }
 
-void render::setCompressedData(GLuint tex, const uint8_t* data, uint32_t w, uint32_t h, GLenum internalFormat, uint32_t dataSize)
+void render::setPlanarData(GLuint y, GLuint cb, GLuint cr, const uint8_t* data, uint32_t w, uint32_t h, ePixelFormat format)
+{
+    if (y == 0 || cb == 0 || cr == 0 || data == nullptr)
+    {
+        return;
+    }
+
+    const auto layout      = ycbcr::getLayout(format, w);
+    const uint32_t cw      = ycbcr::getChromaSize(w, layout.factorX);
+    const uint32_t ch      = ycbcr::getChromaSize(h, layout.factorY);
+    const size_t lumaSize  = static_cast<size_t>(w) * h;
+    const size_t offsets[] = { 0, lumaSize, lumaSize + static_cast<size_t>(cw) * ch };
+    const GLuint planes[]  = { y, cb, cr };
+
+    // One source buffer for all planes, the upload buffer is offset into.
+    auto src = reinterpret_cast<uintptr_t>(beginUploadSource(data));
+    GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const uint32_t pw = i == 0 ? w : cw;
+        const uint32_t ph = i == 0 ? h : ch;
+        setTextureFilter(planes[i], GL_LINEAR, GL_NEAREST);
+        setTextureWrap(planes[i], GL_CLAMP_TO_EDGE);
+        GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, pw, ph, 0, GL_RED, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(src + offsets[i])));
+    }
+    GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    endUploadSource(data);
+}
+
+void render::updatePlanarSubData(GLuint y, GLuint cb, GLuint cr, const uint8_t* data, uint32_t row, uint32_t w, uint32_t h, ePixelFormat format)
+{
+    if (y == 0 || cb == 0 || cr == 0 || data == nullptr || h == 0)
+    {
+        return;
+    }
+
+    // Rows start on a chroma row, the last one may cover a single luma row.
+    const auto layout      = ycbcr::getLayout(format, w);
+    const uint32_t cw      = ycbcr::getChromaSize(w, layout.factorX);
+    const uint32_t chromaY = row / layout.factorY;
+    const uint32_t chromaH = ycbcr::getChromaSize(row + h, layout.factorY) - chromaY;
+    const size_t lumaSize  = static_cast<size_t>(w) * h;
+    const size_t offsets[] = { 0, lumaSize, lumaSize + static_cast<size_t>(cw) * chromaH };
+    const GLuint planes[]  = { y, cb, cr };
+
+    auto src = reinterpret_cast<uintptr_t>(beginUploadSource(data));
+    GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        bindTexture(planes[i]);
+        const uint32_t pw = i == 0 ? w : cw;
+        const uint32_t py = i == 0 ? row : chromaY;
+        const uint32_t ph = i == 0 ? h : chromaH;
+        GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, py, pw, ph, GL_RED, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(src + offsets[i])));
+    }
+    GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    endUploadSource(data);
+}
+
+void render::setCompressedData(GLuint tex, const uint8_t* data, uint32_t w, uint32_t h, eCompressedFormat format, uint32_t dataSize)
 {
     if (tex != 0 && data != nullptr)
     {
         setTextureFilter(tex, GL_LINEAR, GL_NEAREST);
         setTextureWrap(tex, GL_CLAMP_TO_EDGE);
 
-        GL(glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, dataSize, data));
+        const auto internalFormat = CompressedFormatTable[static_cast<size_t>(format)].internalFormat;
+        GL(glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, dataSize, beginUploadSource(data)));
+        endUploadSource(data);
+
+        // Match the CPU decoder, which expands single-channel EAC to gray.
+        if (format == eCompressedFormat::EAC_R11)
+        {
+            GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+            GL(glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle));
+        }
+    }
+}
+
+uint8_t* render::mapUploadBuffer(size_t size)
+{
+    cancelPendingUpload();
+
+    uint32_t index = 0;
+    while (index < UploadRingSize && pollUploadSlot(UploadRing[(UploadIndex + index) % UploadRingSize]) == false)
+    {
+        index++;
+    }
+    if (index == UploadRingSize)
+    {
+        return nullptr;
+    }
+    UploadIndex = (UploadIndex + index) % UploadRingSize;
+
+    auto& slot = UploadRing[UploadIndex];
+    if (slot.pbo == 0)
+    {
+        GL(glGenBuffers(1, &slot.pbo));
+    }
+
+    GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo));
+    if (slot.capacity < size)
+    {
+        GL(glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW));
+        slot.capacity = size;
+    }
+
+    // The signaled fence guarantees the GPU is done with this slot.
+    constexpr GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    auto ptr                    = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size), access));
+    checkError("glMapBufferRange", __FILE__, __LINE__);
+    GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    UploadPending = ptr;
+    return ptr;
+}
+
+void render::generateMipmaps(GLuint tex)
+{
+    if (tex != 0)
+    {
+        bindTexture(tex);
+        GL(glGenerateMipmap(GL_TEXTURE_2D));
     }
 }
 
@@ -545,6 +1324,16 @@ void render::deleteLutTexture(GLuint tex)
     GL(glDeleteTextures(1, &tex));
 }
 
+GLuint render::createPaletteTexture(const uint8_t* data)
+{
+    auto tex = createTexture();
+    setTextureFilter(tex, GL_NEAREST, GL_NEAREST);
+    setTextureWrap(tex, GL_CLAMP_TO_EDGE);
+    GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, data));
+    return tex;
+}
+
 GLuint render::getCurrentTexture()
 {
     return CurrentTextureId;
@@ -584,17 +1373,23 @@ void render::render(const Line& line)
 {
     bindTexture(line.tex);
 
-    auto& pp       = PPPrograms[static_cast<uint32_t>(eEffect::None)];
-    GLuint program = (line.tex != 0) ? pp.program : ColoredProgram;
-    GLint projLoc  = (line.tex != 0) ? pp.projLoc : ColoredProjLoc;
-
-    GL(glUseProgram(program));
-    GL(glUniformMatrix4fv(projLoc, 1, GL_FALSE, Projection.m));
+    GLuint program = 0;
+    GLint projLoc  = -1;
     if (line.tex != 0)
     {
-        GL(glUniform1i(pp.texLoc, 0));
+        const auto& pp = getPostProcessProgram(eEffect::None);
+        program        = pp.program;
+        projLoc        = pp.projLoc;
+    }
+    else
+    {
+        program = getColoredProgram();
+        projLoc = ColoredProjLoc;
     }
 
+    GL(glUseProgram(program));
+    GL(glUniformMatrix4fv(projLoc, 1, GL_FALSE, Projection.m));
+
     GL(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * 2, line.v, GL_STREAM_DRAW));
     GL(glDrawArrays(GL_LINES, 0, 2));
 }
@@ -603,48 +1398,127 @@ void render::render(const Quad& quad)
 {
     bindTexture(quad.tex);
 
-    auto& pp       = PPPrograms[static_cast<uint32_t>(eEffect::None)];
-    GLuint program = (quad.tex != 0) ? pp.program : ColoredProgram;
-    GLint projLoc  = (quad.tex != 0) ? pp.projLoc : ColoredProjLoc;
-
-    GL(glUseProgram(program));
-    GL(glUniformMatrix4fv(projLoc, 1, GL_FALSE, Projection.m));
+    GLuint program = 0;
+    GLint projLoc  = -1;
     if (quad.tex != 0)
     {
-        GL(glUniform1i(pp.texLoc, 0));
+        const auto& pp = getPostProcessProgram(eEffect::None);
+        program        = pp.program;
+        projLoc        = pp.projLoc;
     }
+    else
+    {
+        program = getColoredProgram();
+        projLoc = ColoredProjLoc;
+    }
+
+    GL(glUseProgram(program));
+    GL(glUniformMatrix4fv(projLoc, 1, GL_FALSE, Projection.m));
 
     GL(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * 4, quad.v, GL_STREAM_DRAW));
     GL(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr));
 }
 
-void render::renderPostProcessed(const Quad& quad, GLuint lutTex, eEffect effects)
+void render::renderBatch(const Quad* quads, uint32_t count, GLuint lutTex, GLuint paletteTex, eEffect effects)
 {
-    bindTexture(quad.tex);
+    if (count == 0)
+    {
+        return;
+    }
 
-    auto flags = static_cast<uint32_t>(effects);
-    auto& pp   = PPPrograms[flags & (PostProcessVariants - 1)];
+    const auto& pp = getPostProcessProgram(effects);
     GL(glUseProgram(pp.program));
     GL(glUniformMatrix4fv(pp.projLoc, 1, GL_FALSE, Projection.m));
-    GL(glUniform1i(pp.texLoc, 0));
+
+    if (effects & eEffect::ToneMap)
+    {
+        GL(glUniform1f(pp.exposureLoc, ::exp2f(Exposure)));
+    }
 
     if ((effects & eEffect::Lut) && lutTex != 0)
     {
-        GL(glActiveTexture(GL_TEXTURE1));
+        GL(glActiveTexture(GL_TEXTURE0 + LutTextureUnit));
         GL(glBindTexture(GL_TEXTURE_3D, lutTex));
         GL(glActiveTexture(GL_TEXTURE0));
-        GL(glUniform1i(pp.lutLoc, 1));
     }
 
-    GL(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * 4, quad.v, GL_STREAM_DRAW));
-    GL(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr));
+    if ((effects & eEffect::Palette) && paletteTex != 0)
+    {
+        GL(glActiveTexture(GL_TEXTURE0 + PaletteTextureUnit));
+        GL(glBindTexture(GL_TEXTURE_2D, paletteTex));
+        GL(glActiveTexture(GL_TEXTURE0));
+    }
+
+    GL(glBindVertexArray(BatchVao));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, BatchVbo));
+
+    GLuint slots[BatchTextures] = {};
+    uint32_t used               = 0;
+
+    // One draw per BatchTextures distinct textures, order is kept.
+    auto flush = [&]() {
+        for (uint32_t i = 0; i < used; i++)
+        {
+            GL(glActiveTexture(GL_TEXTURE0 + i));
+            GL(glBindTexture(GL_TEXTURE_2D, slots[i]));
+        }
+        GL(glActiveTexture(GL_TEXTURE0));
+        CurrentTextureId = slots[0];
+
+        GL(glBufferData(GL_ARRAY_BUFFER, sizeof(BatchVertex) * BatchVertices.size(), BatchVertices.data(), GL_STREAM_DRAW));
+        GL(glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(BatchVertices.size() / 4 * 6), GL_UNSIGNED_SHORT, nullptr));
+
+        BatchVertices.clear();
+        used = 0;
+    };
+
+    BatchVertices.clear();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const auto& quad = quads[i];
+
+        // Planar quads take three consecutive slots, Y first.
+        const bool planar     = quad.chroma[0] != 0;
+        const uint32_t planes = planar ? 3 : 1;
+
+        uint32_t slot = 0;
+        while (slot < used && slots[slot] != quad.tex)
+        {
+            slot++;
+        }
+
+        if ((slot == used && used + planes > BatchTextures) || BatchVertices.size() == BatchMaxQuads * 4)
+        {
+            flush();
+            slot = 0;
+        }
+
+        if (slot == used)
+        {
+            slots[used++] = quad.tex;
+            if (planar)
+            {
+                slots[used++] = quad.chroma[0];
+                slots[used++] = quad.chroma[1];
+            }
+        }
+
+        for (const auto& v : quad.v)
+        {
+            BatchVertices.push_back({ v, static_cast<GLfloat>(slot) });
+        }
+    }
+    flush();
+
+    GL(glBindVertexArray(Vao));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, Vbo));
 }
 
 void render::renderLines(const Vertex* vertices, uint32_t vertexCount)
 {
     bindTexture(0);
 
-    GL(glUseProgram(ColoredProgram));
+    GL(glUseProgram(getColoredProgram()));
     GL(glUniformMatrix4fv(ColoredProjLoc, 1, GL_FALSE, Projection.m));
 
     GL(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertexCount, vertices, GL_STREAM_DRAW));
@@ -679,8 +1553,9 @@ void render::setViewportSize(const Vectori& size)
 
 void render::resetGlobals()
 {
-    ViewRect = { { 0.0f, 0.0f }, { static_cast<float>(ViewportSize.x), static_cast<float>(ViewportSize.y) } };
-    ViewZoom = 1.0f;
+    ViewRect      = { { 0.0f, 0.0f }, { static_cast<float>(ViewportSize.x), static_cast<float>(ViewportSize.y) } };
+    ViewZoom      = 1.0f;
+    ViewTransform = Matrix4::Identity();
 
     Projection = Matrix4::Ortho(
         0.0f,
@@ -705,6 +1580,16 @@ int render::getAngle()
     return ViewAngle;
 }
 
+void render::setExposure(float stops)
+{
+    Exposure = stops;
+}
+
+float render::getExposure()
+{
+    return Exposure;
+}
+
 void render::setGlobals(const Vectorf& offset, int angle, float zoom, bool flipH, bool flipV)
 {
     const float z = 1.0f / zoom;
@@ -718,8 +1603,45 @@ void render::setGlobals(const Vectorf& offset, int angle, float zoom, bool flipH
     ViewZoom  = zoom;
     ViewAngle = angle;
 
-    auto ortho  = Matrix4::Ortho(x, x + w, y + h, y, -1.0f, 1.0f);
-    auto rotate = Matrix4::RotateZ(static_cast<float>(-angle));
-    auto flip   = Matrix4::Scale(flipH ? -1.0f : 1.0f, flipV ? -1.0f : 1.0f);
-    Projection  = ortho * rotate * flip;
+    auto ortho    = Matrix4::Ortho(x, x + w, y + h, y, -1.0f, 1.0f);
+    auto rotate   = Matrix4::RotateZ(static_cast<float>(-angle));
+    auto flip     = Matrix4::Scale(flipH ? -1.0f : 1.0f, flipV ? -1.0f : 1.0f);
+    ViewTransform = rotate * flip;
+    Projection    = ortho * ViewTransform;
+}
+
+Vectorf render::toView(const Vectorf& pos)
+{
+    const auto& m = ViewTransform.m;
+    return { m[0] * pos.x + m[4] * pos.y, m[1] * pos.x + m[5] * pos.y };
+}
+
+Vectorf render::toImage(const Vectorf& pos)
+{
+    // Rotation and flip are orthonormal, the inverse is the transpose.
+    const auto& m = ViewTransform.m;
+    return { m[0] * pos.x + m[1] * pos.y, m[4] * pos.x + m[5] * pos.y };
+}
+
+bool render::isRectVisible(const Rectf& rect, float margin)
+{
+    // Bounds of the rotated/flipped rect in view space against the view
+    // rect grown by margin (in view sizes) on each side.
+    const auto& m = ViewTransform.m;
+    const Vectorf corners[] = {
+        rect.tl,
+        { rect.br.x, rect.tl.y },
+        rect.br,
+        { rect.tl.x, rect.br.y },
+    };
+
+    Rectf bounds;
+    for (const auto& c : corners)
+    {
+        bounds.encapsulate({ m[0] * c.x + m[4] * c.y + m[12], m[1] * c.x + m[5] * c.y + m[13] });
+    }
+
+    const Vectorf extent{ ViewRect.width() * margin, ViewRect.height() * margin };
+    const Rectf view{ ViewRect.tl - extent, ViewRect.br + extent };
+    return view.intersect(bounds);
 }
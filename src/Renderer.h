@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "Common/CompressedFormat.h"
 #include "Common/Effects.h"
 #include "Common/PixelFormat.h"
 #include "Types/Color.h"
@@ -26,6 +27,36 @@
 #define GL_LUMINANCE_ALPHA 0x190A
 #endif
 
+// Compressed formats from extensions (or GL 4.2+ core) the GL 3.3 loader
+// doesn't declare. Availability is probed at init.
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_R11_EAC 0x9270
+#define GL_COMPRESSED_RG11_EAC 0x9272
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#define GL_COMPRESSED_RGBA_ASTC_6x6_KHR 0x93B4
+#define GL_COMPRESSED_RGBA_ASTC_8x8_KHR 0x93B7
+#endif
+
+// ARB_get_program_binary (GL 4.1+ core), used for the shader cache.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
 struct Vertex
 {
     GLfloat x, y;
@@ -39,15 +70,26 @@ struct Line
     Vertex v[2];
 };
 
+// Pixel pack buffer of an asynchronous texture readback and the fence
+// of the copy into it.
+struct Readback
+{
+    GLuint pbo   = 0;
+    GLsync fence = nullptr;
+    size_t size  = 0;
+};
+
 struct Quad
 {
-    GLuint tex = 0;
+    GLuint tex       = 0;
+    GLuint chroma[2] = {}; // Cb and Cr of planar YCbCr quads, tex is Y
     Vertex v[4];
 };
 
 namespace render
 {
-    void init();
+    // loadProc resolves entry points the GL 3.3 loader doesn't cover.
+    void init(GLADloadproc loadProc);
     void shutdown();
 
     void pushState();
@@ -56,7 +98,19 @@ namespace render
     GLuint createTexture();
     void setData(GLuint tex, const uint8_t* data, uint32_t w, uint32_t h, ePixelFormat format);
     void updateSubData(GLuint tex, const uint8_t* data, uint32_t y, uint32_t w, uint32_t h, ePixelFormat format);
-    void setCompressedData(GLuint tex, const uint8_t* data, uint32_t w, uint32_t h, GLenum internalFormat, uint32_t dataSize);
+    void updateSubRect(GLuint tex, const uint8_t* data, uint32_t x, uint32_t y, uint32_t w, uint32_t h, ePixelFormat format);
+    // Planar YCbCr into one R8 texture per plane. data holds the Y rows,
+    // then the Cb and then the Cr rows, all tightly packed.
+    void setPlanarData(GLuint y, GLuint cb, GLuint cr, const uint8_t* data, uint32_t w, uint32_t h, ePixelFormat format);
+    void updatePlanarSubData(GLuint y, GLuint cb, GLuint cr, const uint8_t* data, uint32_t row, uint32_t w, uint32_t h, ePixelFormat format);
+    void setCompressedData(GLuint tex, const uint8_t* data, uint32_t w, uint32_t h, eCompressedFormat format, uint32_t dataSize);
+    // Maps the next free buffer of the upload ring for writing, returns
+    // nullptr on failure or if all of them are still in flight. Passing
+    // the returned pointer to the next setData(), updateSubData() or
+    // setCompressedData() call sources the copy from the buffer. The
+    // memory may be filled from any thread until then.
+    uint8_t* mapUploadBuffer(size_t size);
+    void generateMipmaps(GLuint tex);
     void deleteTexture(GLuint tex);
     GLuint getCurrentTexture();
     void bindTexture(GLuint tex);
@@ -73,13 +127,28 @@ namespace render
 
     void render(const Line& line);
     void render(const Quad& quad);
-    void renderPostProcessed(const Quad& quad, GLuint lutTex, eEffect effects);
+    // Draws the quads in order with as few draw calls as the texture unit
+    // count allows, through the post-process shader for effects.
+    void renderBatch(const Quad* quads, uint32_t count, GLuint lutTex, GLuint paletteTex, eEffect effects);
     void renderLines(const Vertex* vertices, uint32_t vertexCount);
 
+    // Exposure in stops for images drawn with eEffect::ToneMap.
+    void setExposure(float stops);
+    float getExposure();
+
     GLuint createLutTexture(const uint8_t* data, uint32_t gridSize);
     void deleteLutTexture(GLuint tex);
 
-    void readTexPixel(GLuint tex, uint32_t x, uint32_t y, uint8_t* rgba);
+    // 256 RGBA entries for ePixelFormat::Indexed8 images.
+    GLuint createPaletteTexture(const uint8_t* data);
+
+    // Queues a read of a texture area as RGBA (8-bit or unclamped float)
+    // into a pack buffer without waiting for the GPU. finishReadback()
+    // copies the result out once the fence has signaled and returns false
+    // until then, or if the read failed, which leaves the readback empty.
+    bool beginReadback(Readback& readback, GLuint tex, uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool isFloat);
+    bool finishReadback(Readback& readback, uint8_t* data);
+    void deleteReadback(Readback& readback);
 
     void setClearColor(float r, float g, float b, float a);
     void clear();
@@ -91,6 +160,13 @@ namespace render
     void setGlobals(const Vectorf& offset, int angle, float zoom, bool flipH = false, bool flipV = false);
 
     const Rectf& getRect();
+    // True if the image-space rect is on screen under the current rotation
+    // and flip. margin widens the view by that fraction on each side.
+    bool isRectVisible(const Rectf& rect, float margin = 0.0f);
+    // Image space to view space and back under the current rotation and
+    // flip, the view rect is in view space.
+    Vectorf toView(const Vectorf& pos);
+    Vectorf toImage(const Vectorf& pos);
     float getZoom();
     int getAngle();
 
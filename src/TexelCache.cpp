@@ -0,0 +1,175 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#include "TexelCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t TileSize   = 32;
+    constexpr uint32_t MaxTiles   = 64;
+    constexpr uint32_t MaxPending = 4;
+
+} // namespace
+
+cTexelCache::~cTexelCache()
+{
+    clear();
+}
+
+bool cTexelCache::getTexel(GLuint tex, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint8_t* rgba)
+{
+    auto texel = findTexel(tex, width, height, x, y, false);
+    if (texel == nullptr)
+    {
+        return false;
+    }
+
+    ::memcpy(rgba, texel, 4);
+    return true;
+}
+
+bool cTexelCache::getTexel(GLuint tex, uint32_t width, uint32_t height, uint32_t x, uint32_t y, float* rgba)
+{
+    auto texel = findTexel(tex, width, height, x, y, true);
+    if (texel == nullptr)
+    {
+        return false;
+    }
+
+    ::memcpy(rgba, texel, 4 * sizeof(float));
+    return true;
+}
+
+const uint8_t* cTexelCache::findTexel(GLuint tex, uint32_t width, uint32_t height, uint32_t x, uint32_t y, bool isFloat)
+{
+    if (tex == 0 || x >= width || y >= height)
+    {
+        return nullptr;
+    }
+
+    const uint32_t tx = x - x % TileSize;
+    const uint32_t ty = y - y % TileSize;
+
+    uint32_t pending = 0;
+    for (auto& tile : m_tiles)
+    {
+        if (tile.tex == tex && tile.x == tx && tile.y == ty && tile.isFloat == isFloat)
+        {
+            tile.used = ++m_clock;
+            if (tile.ready == false)
+            {
+                return nullptr;
+            }
+
+            const size_t texelSize = isFloat ? 4 * sizeof(float) : 4;
+            return tile.data.data() + (static_cast<size_t>(y - ty) * tile.w + (x - tx)) * texelSize;
+        }
+
+        if (tile.ready == false)
+        {
+            pending++;
+        }
+    }
+
+    // Don't pile up reads while the cursor sweeps over the image, the
+    // latest position is asked for again once one lands.
+    if (pending >= MaxPending)
+    {
+        return nullptr;
+    }
+
+    Tile* slot = nullptr;
+    if (m_tiles.size() < MaxTiles)
+    {
+        slot = &m_tiles.emplace_back();
+    }
+    else
+    {
+        for (auto& tile : m_tiles)
+        {
+            if (tile.ready && (slot == nullptr || tile.used < slot->used))
+            {
+                slot = &tile;
+            }
+        }
+
+        if (slot == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    const uint32_t w = std::min(TileSize, width - tx);
+    const uint32_t h = std::min(TileSize, height - ty);
+
+    *slot         = {};
+    slot->tex     = tex;
+    slot->x       = tx;
+    slot->y       = ty;
+    slot->w       = w;
+    slot->isFloat = isFloat;
+    slot->used    = ++m_clock;
+    if (render::beginReadback(slot->readback, tex, tx, ty, w, h, isFloat) == false)
+    {
+        slot->tex = 0; // dropped by update()
+    }
+
+    return nullptr;
+}
+
+bool cTexelCache::update()
+{
+    bool arrived = false;
+    for (auto it = m_tiles.begin(); it != m_tiles.end();)
+    {
+        auto& tile = *it;
+        if (tile.ready == false)
+        {
+            tile.data.resize(tile.readback.size);
+            if (render::finishReadback(tile.readback, tile.data.data()))
+            {
+                tile.ready = true;
+                arrived    = true;
+            }
+            else if (tile.readback.fence == nullptr)
+            {
+                it = m_tiles.erase(it);
+                continue;
+            }
+        }
+        ++it;
+    }
+
+    return arrived;
+}
+
+bool cTexelCache::isPending() const
+{
+    for (const auto& tile : m_tiles)
+    {
+        if (tile.ready == false)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void cTexelCache::clear()
+{
+    for (auto& tile : m_tiles)
+    {
+        render::deleteReadback(tile.readback);
+    }
+    m_tiles.clear();
+}
@@ -0,0 +1,55 @@
+/**********************************************\
+*
+*  Simple Viewer GL edition
+*  by Andrey A. Ugolnik
+*  https://github.com/reybits
+*  and@reybits.dev
+*
+\**********************************************/
+
+#pragma once
+
+#include "Common/Buffer.h"
+#include "Renderer.h"
+
+#include <cstdint>
+#include <vector>
+
+// Raw texels of recently inspected texture areas, read back in tiles
+// through pack buffers so the pixel info never waits for the GPU.
+class cTexelCache final
+{
+public:
+    ~cTexelCache();
+
+    // Texel at x, y of a texture sized width × height. If its tile isn't
+    // cached yet, the read is queued and false is returned.
+    bool getTexel(GLuint tex, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint8_t* rgba);
+    bool getTexel(GLuint tex, uint32_t width, uint32_t height, uint32_t x, uint32_t y, float* rgba);
+
+    // Collects finished reads, true if a tile arrived.
+    bool update();
+    bool isPending() const;
+
+    void clear();
+
+private:
+    struct Tile
+    {
+        GLuint tex    = 0;
+        uint32_t x    = 0;
+        uint32_t y    = 0;
+        uint32_t w    = 0;
+        bool isFloat  = false;
+        bool ready    = false;
+        uint64_t used = 0;
+        Readback readback;
+        Buffer data;
+    };
+
+    const uint8_t* findTexel(GLuint tex, uint32_t width, uint32_t height, uint32_t x, uint32_t y, bool isFloat);
+
+private:
+    std::vector<Tile> m_tiles;
+    uint64_t m_clock = 0;
+};
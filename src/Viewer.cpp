@@ -8,10 +8,12 @@
 \**********************************************/
 
 #include "Viewer.h"
+#include "AnimationFrames.h"
 #include "Checkerboard.h"
 #include "Common/Config.h"
 #include "Common/Helpers.h"
 #include "Common/Timing.h"
+#include "Common/YCbCr.h"
 #include "DeletionMark.h"
 #include "FilesList.h"
 #include "Gui.h"
@@ -34,9 +36,28 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <vector>
 
 namespace
 {
+    // Extra frames after a change, ImGui settles hover and layout state
+    // one frame late.
+    constexpr uint32_t SettleFrames = 2;
+
+    // Longest sleep of an idle main loop.
+    constexpr double IdleTimeout = 1.0;
+
+    // Polling interval while a pixel readback is in flight.
+    constexpr double ReadbackPollTimeout = 0.004;
+
+    // Exposure change per key press, in stops.
+    constexpr float ExposureStep = 0.5f;
+
+    // Largest raster side requested from the loader, for vector images and
+    // pyramid windows.
+    constexpr uint32_t MaxRasterDim = 16384;
+
     bool AlignScale(int& scale, int step)
     {
         const int oldScale = scale;
@@ -51,25 +72,29 @@ cViewer::cViewer(sConfig& config, cWindow& window)
     : m_config(config)
     , m_window(window)
 {
-    m_windowEvents.onWindowResize      = [this](const Vectori& s) { onWindowResize(s); };
-    m_windowEvents.onFramebufferResize = [this](const Vectori& s) { onFramebufferResize(s); };
-    m_windowEvents.onWindowPosition    = [this](const Vectori& p) { onWindowPosition(p); };
-    m_windowEvents.onWindowRefresh     = [this]() { onWindowRefresh(); };
-    m_windowEvents.onKeyEvent          = [this](int k, int s, int a, int m) { onKeyEvent(k, s, a, m); };
-    m_windowEvents.onCharEvent         = [this](uint32_t c) { onCharEvent(c); };
-    m_windowEvents.onMouseButton       = [this](int b, int a, int m) { onMouseButton(b, a, m); };
-    m_windowEvents.onMouseMove         = [this](const Vectorf& p) { onMouseMove(p); };
-    m_windowEvents.onMouseScroll       = [this](const Vectorf& o) { onMouseScroll(o); };
-    m_windowEvents.onFileDrop          = [this](const StringsList& p) { onFileDrop(p); };
-
-    m_callbacks.startLoading      = [this]() { startLoading(); };
-    m_callbacks.onImageInfo       = [this](const sChunkData& c, const sImageInfo& i) { onImageInfo(c, i); };
-    m_callbacks.onPreviewReady    = [this](sPreviewData&& p) { onPreviewReady(std::move(p)); };
-    m_callbacks.onBitmapAllocated = [this](const sChunkData& c) { onBitmapAllocated(c); };
-    m_callbacks.doProgress        = [this](float p) { doProgress(p); };
-    m_callbacks.endLoading        = [this]() { endLoading(); };
-
-    m_image        = std::make_unique<cQuadImage>();
+    // Window events arrive on the main thread, loader callbacks on the
+    // loader thread and have to wake up the sleeping main loop.
+    m_windowEvents.onWindowResize      = [this](const Vectori& s) { requestRedraw(); onWindowResize(s); };
+    m_windowEvents.onFramebufferResize = [this](const Vectori& s) { requestRedraw(); onFramebufferResize(s); };
+    m_windowEvents.onWindowPosition    = [this](const Vectori& p) { requestRedraw(); onWindowPosition(p); };
+    m_windowEvents.onWindowRefresh     = [this]() { requestRedraw(); onWindowRefresh(); };
+    m_windowEvents.onKeyEvent          = [this](int k, int s, int a, int m) { requestRedraw(); onKeyEvent(k, s, a, m); };
+    m_windowEvents.onCharEvent         = [this](uint32_t c) { requestRedraw(); onCharEvent(c); };
+    m_windowEvents.onMouseButton       = [this](int b, int a, int m) { requestRedraw(); onMouseButton(b, a, m); };
+    m_windowEvents.onMouseMove         = [this](const Vectorf& p) { requestRedraw(); onMouseMove(p); };
+    m_windowEvents.onMouseScroll       = [this](const Vectorf& o) { requestRedraw(); onMouseScroll(o); };
+    m_windowEvents.onFileDrop          = [this](const StringsList& p) { requestRedraw(); onFileDrop(p); };
+
+    m_callbacks.startLoading      = [this]() { startLoading(); wakeUp(); };
+    m_callbacks.onImageInfo       = [this](const sChunkData& c, const sImageInfo& i) { onImageInfo(c, i); wakeUp(); };
+    m_callbacks.onPreviewReady    = [this](sPreviewData&& p) { onPreviewReady(std::move(p)); wakeUp(); };
+    m_callbacks.onBitmapAllocated = [this](const sChunkData& c) { onBitmapAllocated(c); wakeUp(); };
+    m_callbacks.doProgress        = [this](float p) { doProgress(p); wakeUp(); };
+    m_callbacks.endLoading        = [this]() { endLoading(); wakeUp(); };
+    m_callbacks.onFrameDecoded    = [this]() { m_window.postEmptyEvent(); };
+
+    m_image        = createImage();
+    m_frames       = std::make_unique<cAnimationFrames>([this]() { return createImage(); });
     m_loader       = std::make_unique<cImageLoader>(&config, &m_callbacks);
     m_checkerBoard = std::make_unique<cCheckerboard>(config);
     m_deletionMark = std::make_unique<cDeletionMark>();
@@ -90,6 +115,7 @@ cViewer::cViewer(sConfig& config, cWindow& window)
 
 cViewer::~cViewer()
 {
+    m_frames->stop();
     m_image->clear();
 
     m_imgui.reset();
@@ -98,7 +124,7 @@ cViewer::~cViewer()
 
 void cViewer::onContextRecreated()
 {
-    render::init();
+    render::init(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
 
     m_checkerBoard->init();
     m_pixelPopup->init();
@@ -127,6 +153,15 @@ void cViewer::addPaths(const StringsList& paths)
 
 void cViewer::onRender()
 {
+    if (m_dirty.exchange(false, std::memory_order_acquire))
+    {
+        m_settleFrames = SettleFrames;
+    }
+    else if (m_settleFrames > 0)
+    {
+        m_settleFrames--;
+    }
+
     // Sync viewport with current framebuffer size to avoid stale projection.
     render::setViewportSize(m_window.getFramebufferSize());
 
@@ -157,8 +192,8 @@ void cViewer::onRender()
         // When fitImage is active, compute the fit scale from the full-res
         // dimensions directly — m_image may still have old dimensions before
         // handleBitmapAllocated() runs.  When fitImage is off, scale is a
-        // user-set percentage (image-size-independent), so use it as-is.
-        auto displayScale = scale;
+        // user-set percentage of the full-res size, so use it as-is.
+        auto displayScale = m_scale.getScale();
         if (m_config.fitImage)
         {
             const auto centralFb = getCentralAreaFbSize();
@@ -167,14 +202,26 @@ void cViewer::onRender()
                 : 1.0f;
         }
 
+        // The camera is in m_image pixels.
+        const auto rasterW      = m_image->getWidth() > 0 ? static_cast<float>(m_image->getWidth()) : fw;
+        const auto previewRatio = static_cast<float>(m_preview->getWidth()) / rasterW;
         const auto previewScale = displayScale * fw / static_cast<float>(m_preview->getWidth());
-        render::setGlobals(getAdjustedCamera(previewScale), m_angle, previewScale, m_flipH, m_flipV);
+        const auto camera       = getAdjustedCamera(previewScale) - m_camera * (1.0f - previewRatio);
+        render::setGlobals(camera, m_angle, previewScale, m_flipH, m_flipV);
         m_preview->render();
         render::setGlobals(getAdjustedCamera(), m_angle, scale, m_flipH, m_flipV);
     }
 
     m_image->render();
 
+    // Pyramid level windows over the raster, each in its own scale.
+    if (m_detail != nullptr || m_detailNext != nullptr)
+    {
+        renderDetail(m_detail.get(), m_detailWindow);
+        renderDetail(m_detailNext.get(), m_detailNextWindow);
+        render::setGlobals(getAdjustedCamera(), m_angle, scale, m_flipH, m_flipV);
+    }
+
     auto isLoaded = m_loader->isLoaded();
     if (isLoaded)
     {
@@ -290,11 +337,27 @@ void cViewer::onUpdate()
         handleImageReady();
     }
 
-    if (isUploading())
+    if (m_detailNext != nullptr)
+    {
+        uploadDetail();
+    }
+    else if (isUploading())
     {
         const uint32_t ready = m_loader->getReadyHeight();
-        const bool isDone    = m_image->upload(ready);
-        m_loader->setConsumedHeight(ready);
+        const double t0      = timing::seconds();
+
+        // Tiles in the view as the next frame draws it go first.
+        render::setGlobals(getAdjustedCamera(), m_angle, getRenderScale(), m_flipH, m_flipV);
+        const bool isDone = m_image->upload(ready);
+        render::resetGlobals();
+        m_loader->setConsumedHeight(m_image->getUploadedHeight());
+
+        if (m_config.debug && m_image->getUploadedBytes() != 0)
+        {
+            cLog::Debug("  upload frame: {:.2f} MB in {:.1f} ms",
+                        m_image->getUploadedBytes() / (1024.0 * 1024.0),
+                        (timing::seconds() - t0) * 1000.0);
+        }
 
         const float uploadProgress = m_image->getProgress();
         if (uploadProgress > 0.0f)
@@ -321,6 +384,7 @@ void cViewer::onUpdate()
             {
                 m_progress->hide();
                 m_loadProgress.store(-1.0f, std::memory_order_relaxed);
+                m_loader->storePreview();
             }
             else
             {
@@ -333,6 +397,7 @@ void cViewer::onUpdate()
             {
                 m_anim.nextFrameTime = timing::seconds() + uploadInfo.delay * 0.001;
                 m_anim.timerStarted  = true;
+                startFramesAhead();
             }
 
             // Full-res upload complete — discard preview.
@@ -342,6 +407,8 @@ void cViewer::onUpdate()
                 m_previewData = {};
             }
 
+            requestRedraw();
+
             // Free bitmap memory — pixel readback now uses GPU textures.
             if (m_uploadFinal && m_anim.isAnimated == false && uploadInfo.images <= 1)
             {
@@ -352,14 +419,43 @@ void cViewer::onUpdate()
     }
     else if (m_anim.isAnimated && m_anim.autoAdvance && m_anim.timerStarted)
     {
-        if (timing::seconds() >= m_anim.nextFrameTime)
+        if (m_frames->isActive())
+        {
+            updateFramesAhead();
+        }
+        else if (timing::seconds() >= m_anim.nextFrameTime)
         {
             m_anim.timerStarted = false; // re-armed on next upload completion
             loadSubImage(1);
         }
     }
 
-    // Re-rasterization for vector formats: fire after debounce period.
+    // Tiles of paged images follow the view as the next frame draws it.
+    render::setGlobals(getAdjustedCamera(), m_angle, getRenderScale(), m_flipH, m_flipV);
+    const bool isResidencyChanged = m_image->updateResidency();
+    render::resetGlobals();
+    if (isResidencyChanged)
+    {
+        requestRedraw();
+    }
+
+    if (m_image->updateReadback() && m_config.showPixelInfo)
+    {
+        updatePixelInfo(m_lastMouse);
+        requestRedraw();
+    }
+
+    // JPEG decoded scaled down to fit the window: once it's shown past its
+    // decoded resolution, decode it at full size.
+    if (m_loader->getMode() == cImageLoader::Mode::Image && m_loader->isLoaded()
+        && m_loader->getImageInfo().fullWidth != 0 && m_loader->getImageInfo().levels.empty()
+        && isUploading() == false && getRenderScale() > 1.0f)
+    {
+        m_loader->rerasterize(0, 0);
+    }
+
+    // Re-rasterization for vector formats and pyramid levels: fire after
+    // debounce period.
     if (m_rerasterPending && isUploading() == false
         && timing::seconds() >= m_rerasterDebounceTime)
     {
@@ -367,12 +463,15 @@ void cViewer::onUpdate()
 
         const float scale = m_scale.getScale();
 
-        if (m_vectorBaseSize.x > 0 && m_vectorBaseSize.y > 0)
+        if (m_levels.empty() == false)
+        {
+            updateDetail();
+        }
+        else if (m_baseSize.x > 0 && m_baseSize.y > 0)
         {
-            auto targetW = static_cast<uint32_t>(m_vectorBaseSize.x * scale + 0.5f);
-            auto targetH = static_cast<uint32_t>(m_vectorBaseSize.y * scale + 0.5f);
+            auto targetW = static_cast<uint32_t>(m_baseSize.x * scale + 0.5f);
+            auto targetH = static_cast<uint32_t>(m_baseSize.y * scale + 0.5f);
 
-            constexpr uint32_t MaxRasterDim = 16384;
             if (targetW > MaxRasterDim || targetH > MaxRasterDim)
             {
                 auto clampScale = static_cast<float>(MaxRasterDim) / std::max(targetW, targetH);
@@ -386,6 +485,142 @@ void cViewer::onUpdate()
             }
         }
     }
+    else if (m_rerasterPending == false)
+    {
+        // Panning: a new window is read once the view leaves the current one.
+        updateDetail();
+    }
+}
+
+void cViewer::updateDetail()
+{
+    // Not before m_image is up and its own load has ended, a window load
+    // in flight is replaced when the view leaves it.
+    if (m_levels.empty() || m_baseSize.x <= 0 || m_image->getWidth() == 0 || isUploading()
+        || (m_uploadFinal == false && m_loader->getMode() != cImageLoader::Mode::Window))
+    {
+        return;
+    }
+
+    // The coarsest level covering the zoom, nothing to read while m_image
+    // is as fine.
+    const float targetW = m_baseSize.x * m_scale.getScale();
+    auto level          = m_levels.front();
+    for (auto it = m_levels.rbegin(); it != m_levels.rend(); ++it)
+    {
+        if (it->width + 1.0f >= targetW)
+        {
+            level = *it;
+            break;
+        }
+    }
+    if (level.width <= m_image->getWidth())
+    {
+        m_detail.reset();
+        m_detailWindow = {};
+        return;
+    }
+
+    // Visible part of m_image, in its pixels from the top-left corner.
+    render::setGlobals(getAdjustedCamera(), m_angle, getRenderScale(), m_flipH, m_flipV);
+    const auto& rc = render::getRect();
+    Rectf visible;
+    for (const auto& corner : { rc.tl, Vectorf{ rc.br.x, rc.tl.y }, rc.br, Vectorf{ rc.tl.x, rc.br.y } })
+    {
+        visible.encapsulate(render::toImage(corner));
+    }
+    render::resetGlobals();
+
+    const Vectorf half{ static_cast<float>((m_image->getWidth() + 1) >> 1),
+                        static_cast<float>((m_image->getHeight() + 1) >> 1) };
+    const float k = static_cast<float>(m_image->getWidth()) / level.width;
+
+    const float x0 = std::clamp((visible.tl.x + half.x) / k, 0.0f, static_cast<float>(level.width));
+    const float y0 = std::clamp((visible.tl.y + half.y) / k, 0.0f, static_cast<float>(level.height));
+    const float x1 = std::clamp((visible.br.x + half.x) / k, 0.0f, static_cast<float>(level.width));
+    const float y1 = std::clamp((visible.br.y + half.y) / k, 0.0f, static_cast<float>(level.height));
+    if (x1 - x0 < 1.0f || y1 - y0 < 1.0f)
+    {
+        return;
+    }
+
+    auto covers = [&](const sImageInfo::Window& w) {
+        return w.levelWidth == level.width
+            && w.x <= x0 && w.y <= y0
+            && x1 <= w.x + w.width && y1 <= w.y + w.height;
+    };
+    if (covers(m_detailWindow) || covers(m_detailNextWindow))
+    {
+        return;
+    }
+
+    // Half a view of margin on each side, so a short pan stays inside.
+    const float marginX = (x1 - x0) * 0.5f;
+    const float marginY = (y1 - y0) * 0.5f;
+    const auto right    = std::min(static_cast<uint32_t>(std::ceil(x1 + marginX)), level.width);
+    const auto bottom   = std::min(static_cast<uint32_t>(std::ceil(y1 + marginY)), level.height);
+
+    sImageInfo::Window window;
+    window.x           = static_cast<uint32_t>(std::max(x0 - marginX, 0.0f));
+    window.y           = static_cast<uint32_t>(std::max(y0 - marginY, 0.0f));
+    window.width       = std::min(right - window.x, MaxRasterDim);
+    window.height      = std::min(bottom - window.y, MaxRasterDim);
+    window.levelWidth  = level.width;
+    window.levelHeight = level.height;
+
+    // The loader reuses its bitmap, the pending upload can't outlive it.
+    m_detailNext.reset();
+    m_detailNextWindow = window;
+    m_loader->loadWindow(window);
+}
+
+void cViewer::uploadDetail()
+{
+    const bool isDone = m_detailNext->upload(m_loader->getReadyHeight());
+    m_loader->setConsumedHeight(m_detailNext->getUploadedHeight());
+    requestRedraw();
+
+    // A failed read leaves rows that never come, drop the window then. Its
+    // bounds are kept so it isn't requested again right away.
+    if (m_uploadFinal
+        && (isDone || m_detailNext->getUploadedHeight() >= m_loader->getReadyHeight()))
+    {
+        if (isDone)
+        {
+            m_detail       = std::move(m_detailNext);
+            m_detailWindow = m_detailNextWindow;
+        }
+        m_detailNext.reset();
+        m_loader->releaseBitmap();
+        updateInfobar();
+    }
+}
+
+void cViewer::renderDetail(cQuadImage* detail, const sImageInfo::Window& window)
+{
+    if (detail == nullptr || window.levelWidth == 0 || m_image->getWidth() == 0)
+    {
+        return;
+    }
+
+    // Window center in m_image pixels, the camera is in those.
+    const float k = static_cast<float>(m_image->getWidth()) / window.levelWidth;
+    const Vectorf center{
+        (window.x + static_cast<float>((detail->getWidth() + 1) >> 1)) * k - static_cast<float>((m_image->getWidth() + 1) >> 1),
+        (window.y + static_cast<float>((detail->getHeight() + 1) >> 1)) * k - static_cast<float>((m_image->getHeight() + 1) >> 1),
+    };
+
+    const auto camera = (getAdjustedCamera() - render::toView(center)) / k;
+    render::setGlobals(camera, m_angle, getRenderScale() * k, m_flipH, m_flipV);
+    detail->render();
+}
+
+void cViewer::resetDetail()
+{
+    m_detail.reset();
+    m_detailNext.reset();
+    m_detailWindow     = {};
+    m_detailNextWindow = {};
 }
 
 bool cViewer::isUploading() const
@@ -398,6 +633,59 @@ void cViewer::setFps(float fps)
     m_imgui->setFps(fps);
 }
 
+void cViewer::requestRedraw()
+{
+    m_dirty.store(true, std::memory_order_release);
+}
+
+void cViewer::wakeUp()
+{
+    requestRedraw();
+    m_window.postEmptyEvent();
+}
+
+bool cViewer::needsRender() const
+{
+    return m_dirty.load(std::memory_order_acquire)
+        || m_settleFrames > 0
+        || isUploading()
+        || m_detailNext != nullptr
+        || m_progress->isVisible();
+}
+
+double cViewer::getWaitTimeout() const
+{
+    if (needsRender())
+    {
+        return 0.0;
+    }
+
+    if (m_frames->isUploading())
+    {
+        return 0.0;
+    }
+
+    // Sleep until the next timed event: animation frame or re-raster.
+    // A frame decoded ahead that isn't ready yet wakes the loop itself.
+    const double now = timing::seconds();
+    double timeout   = IdleTimeout;
+    if (m_anim.isAnimated && m_anim.autoAdvance && m_anim.timerStarted
+        && (m_frames->isActive() == false || m_frames->isNextReady()))
+    {
+        timeout = std::min(timeout, m_anim.nextFrameTime - now);
+    }
+    if (m_rerasterPending)
+    {
+        timeout = std::min(timeout, m_rerasterDebounceTime - now);
+    }
+    if (m_image->isReadbackPending())
+    {
+        timeout = std::min(timeout, ReadbackPollTimeout);
+    }
+
+    return std::max(timeout, 0.0);
+}
+
 void cViewer::processDeferred()
 {
     if (m_fullscreenRequested)
@@ -425,20 +713,103 @@ void cViewer::handlePreviewReady()
     m_preview->upload(p.height);
 }
 
-void cViewer::handleBitmapAllocated()
+void cViewer::setImageBuffer(const sChunkData& chunk, uint32_t bandHeight)
 {
-    m_uploadActive.store(true, std::memory_order_relaxed);
-    m_uploadStartTime = timing::seconds();
+    if (chunk.isCompressedTexture)
+    {
+        m_image->setCompressedBuffer(chunk.width, chunk.height, chunk.compressedFormat, m_loader->getBitmapData());
+    }
+    else
+    {
+        m_image->setBuffer(chunk.width, chunk.height, chunk.pitch, chunk.format, chunk.bpp, m_loader->getBitmapData(), bandHeight, chunk.effects);
+        if (chunk.palette.empty() == false)
+        {
+            m_image->setPaletteData(chunk.palette);
+        }
+    }
+}
 
+void cViewer::setRasterBuffer(const sChunkData& chunk, uint32_t bandHeight)
+{
+    // Re-rasterize: scale (user-facing zoom) stays unchanged, getRenderScale()
+    // compensates via m_baseSize / raster ratio. The old raster is shown as
+    // preview until the new one is uploaded.
+    const auto oldW = m_image->getWidth();
+    if (oldW > 0)
+    {
+        m_camera *= static_cast<float>(chunk.width) / static_cast<float>(oldW);
+
+        m_preview                     = std::move(m_image);
+        m_previewData                 = {};
+        m_previewData.fullImageWidth  = static_cast<uint32_t>(m_baseSize.x);
+        m_previewData.fullImageHeight = static_cast<uint32_t>(m_baseSize.y);
+        m_image                       = createImage();
+    }
+
+    setImageBuffer(chunk, bandHeight);
+    m_selection->setImageDimension(chunk.width, chunk.height);
+}
+
+void cViewer::handleBitmapAllocated()
+{
     const auto& chunk = m_loader->getChunkData();
-    m_image->setBuffer(chunk.width, chunk.height, chunk.pitch, chunk.format, chunk.bpp, m_loader->getBitmapData(), chunk.bandHeight, chunk.effects);
+    const auto& info  = m_loader->getImageInfo();
+
+    // A window of a finer pyramid level, m_image stays as it is.
+    if (m_loader->getMode() == cImageLoader::Mode::Window)
+    {
+        if (info.window.levelWidth != 0)
+        {
+            m_detailNext       = createImage();
+            m_detailNextWindow = info.window;
+            m_detailNext->setBuffer(chunk.width, chunk.height, chunk.pitch, chunk.format, chunk.bpp, m_loader->getBitmapData(), chunk.bandHeight, chunk.effects);
+            if (chunk.palette.empty() == false)
+            {
+                m_detailNext->setPaletteData(chunk.palette);
+            }
+            if (chunk.lutData.empty() == false)
+            {
+                m_detailNext->setLutData(chunk.lutData);
+            }
+            updateFiltering();
+        }
+        return;
+    }
+
+    // Decoders refining the image pass by pass (progressive JPEG) signal
+    // again for each pass, the view stays as it is then.
+    const bool isRefinement = m_uploadActive.exchange(true, std::memory_order_relaxed);
+    if (isRefinement == false)
+    {
+        m_uploadStartTime = timing::seconds();
+    }
+
+    if (isRefinement == false && m_loader->getMode() == cImageLoader::Mode::Rerasterize)
+    {
+        setRasterBuffer(chunk, chunk.bandHeight);
+    }
+    else
+    {
+        setImageBuffer(chunk, chunk.bandHeight);
+    }
 
     if (chunk.lutData.empty() == false)
     {
         m_image->setLutData(chunk.lutData);
     }
 
-    if (m_loader->getMode() == cImageLoader::Mode::Image)
+    // Pages of a multi-page TIFF may or may not be pyramids.
+    if (isRefinement == false && m_loader->getMode() != cImageLoader::Mode::Rerasterize)
+    {
+        m_levels   = info.levels;
+        m_baseSize = info.fullWidth != 0
+            ? Vectori{ static_cast<int>(info.fullWidth), static_cast<int>(info.fullHeight) }
+            : (info.levels.empty() == false
+                   ? Vectori{ static_cast<int>(chunk.width), static_cast<int>(chunk.height) }
+                   : Vectori{});
+    }
+
+    if (isRefinement == false && m_loader->getMode() == cImageLoader::Mode::Image)
     {
         if (m_config.keepScale == false)
         {
@@ -468,6 +839,15 @@ void cViewer::handleImageReady()
                         ? info.formatName
                         : "?",
                     chunk.width, chunk.height, info.bppImage);
+        if (met.prefetched)
+        {
+            cLog::Debug("  prefetched: yes");
+        }
+        cLog::Debug("  cache:      {} ({} hits / {} misses)",
+                    met.cacheHit
+                        ? "hit"
+                        : "miss",
+                    met.cacheHits, met.cacheMisses);
         cLog::Debug("  file read:  {:.1f} ms", met.fileReadMs);
         cLog::Debug("  decode:     {:.1f} ms", met.decodeMs);
         if (met.iccMs > 0.0)
@@ -478,13 +858,20 @@ void cViewer::handleImageReady()
         cLog::Debug("  bitmap:     {:.1f} MB", met.bitmapBytes / (1024.0 * 1024.0));
     }
 
+    // Windows only replace the detail drawn over m_image.
+    if (m_loader->getMode() == cImageLoader::Mode::Window)
+    {
+        m_loadProgress.store(-1.0f, std::memory_order_relaxed);
+        return;
+    }
+
     // Formats that don't call signalBitmapAllocated() (e.g., AGE) never trigger
     // handleBitmapAllocated(), so the GPU buffer was never set up. Do it now.
     if (m_image->getWidth() == 0 && chunk.width > 0)
     {
         m_uploadActive.store(true, std::memory_order_relaxed);
         m_uploadStartTime = timing::seconds();
-        m_image->setBuffer(chunk.width, chunk.height, chunk.pitch, chunk.format, chunk.bpp, m_loader->getBitmapData(), 0, chunk.effects);
+        setImageBuffer(chunk, 0);
 
         if (m_loader->getMode() == cImageLoader::Mode::Image)
         {
@@ -495,7 +882,7 @@ void cViewer::handleImageReady()
                 m_camera = Vectorf();
             }
 
-            m_vectorBaseSize = info.isVector
+            m_baseSize = info.isVector
                 ? Vectori{ static_cast<int>(chunk.width), static_cast<int>(chunk.height) }
                 : Vectori{};
 
@@ -504,34 +891,29 @@ void cViewer::handleImageReady()
             enablePixelInfo(m_config.showPixelInfo);
         }
     }
-    else if (m_loader->getMode() == cImageLoader::Mode::Rerasterize && chunk.width > 0)
+    else if (m_loader->getMode() == cImageLoader::Mode::Rerasterize && chunk.width > 0
+             && m_uploadActive.load(std::memory_order_relaxed) == false)
     {
-        // Re-rasterize: replace GPU data. Scale (user-facing zoom) stays unchanged;
-        // getRenderScale() compensates via m_vectorBaseSize / raster ratio.
-        const auto oldW = m_image->getWidth();
+        // Re-rasterize of a format that didn't stream its rows (or a cache
+        // hit): replace GPU data now.
         m_uploadActive.store(true, std::memory_order_relaxed);
         m_uploadStartTime = timing::seconds();
-        m_image->setBuffer(chunk.width, chunk.height, chunk.pitch, chunk.format, chunk.bpp, m_loader->getBitmapData(), 0, chunk.effects);
-
-        if (oldW > 0)
-        {
-            const float sizeRatio = static_cast<float>(chunk.width) / static_cast<float>(oldW);
-            m_camera *= sizeRatio;
-        }
+        setRasterBuffer(chunk, 0);
     }
     else if (m_loader->getMode() == cImageLoader::Mode::SubImage && chunk.width > 0)
     {
-        // Sub-image: replace GPU data in-place. setBuffer() clears old chunks,
-        // so the previous frame is swapped out atomically with the new upload.
+        // Sub-image: replace GPU data in-place. setBuffer() keeps the tiles
+        // of the previous frame on screen until the new upload replaces them.
         m_uploadActive.store(true, std::memory_order_relaxed);
         m_uploadStartTime = timing::seconds();
-        m_image->setBuffer(chunk.width, chunk.height, chunk.pitch, chunk.format, chunk.bpp, m_loader->getBitmapData(), 0, chunk.effects);
+        setImageBuffer(chunk, 0);
     }
     else if (isUploading() == false)
     {
         // Progressive upload already completed and no re-upload needed.
         m_progress->hide();
         m_loadProgress.store(-1.0f, std::memory_order_relaxed);
+        m_loader->storePreview();
     }
 
     // Wire LUT for batch ICC formats (generated after decode, not at allocation time)
@@ -952,6 +1334,18 @@ void cViewer::onKeyEvent(int key, int scancode, int action, int mods)
         }
         break;
 
+    case GLFW_KEY_LEFT_BRACKET:
+        setExposure(render::getExposure() - ExposureStep);
+        break;
+
+    case GLFW_KEY_RIGHT_BRACKET:
+        setExposure(render::getExposure() + ExposureStep);
+        break;
+
+    case GLFW_KEY_BACKSLASH:
+        setExposure(0.0f);
+        break;
+
     case GLFW_KEY_PAGE_UP:
         m_anim.autoAdvance = false;
         loadSubImage(-1);
@@ -1065,11 +1459,11 @@ void cViewer::calculateScale()
 {
     if (m_config.fitImage && m_image->getWidth() > 0 && m_image->getHeight() > 0)
     {
-        auto w = (m_vectorBaseSize.x > 0)
-            ? static_cast<float>(m_vectorBaseSize.x)
+        auto w = (m_baseSize.x > 0)
+            ? static_cast<float>(m_baseSize.x)
             : static_cast<float>(m_image->getWidth());
-        auto h = (m_vectorBaseSize.y > 0)
-            ? static_cast<float>(m_vectorBaseSize.y)
+        auto h = (m_baseSize.y > 0)
+            ? static_cast<float>(m_baseSize.y)
             : static_cast<float>(m_image->getHeight());
         if (m_angle == 90 || m_angle == 270)
         {
@@ -1131,11 +1525,16 @@ Vectorf cViewer::getCentralAreaFbCenter() const
     return { pos.x + size.x * 0.5f, pos.y + size.y * 0.5f };
 }
 
+bool cViewer::isRerasterizable() const
+{
+    return m_loader->getImageInfo().isVector || m_levels.empty() == false;
+}
+
 float cViewer::getRenderScale() const
 {
-    if (m_vectorBaseSize.x > 0 && m_image->getWidth() > 0)
+    if (m_baseSize.x > 0 && m_image->getWidth() > 0)
     {
-        return m_scale.getScale() * static_cast<float>(m_vectorBaseSize.x) / m_image->getWidth();
+        return m_scale.getScale() * static_cast<float>(m_baseSize.x) / m_image->getWidth();
     }
     return m_scale.getScale();
 }
@@ -1193,7 +1592,7 @@ void cViewer::updateScale(ScaleDirection direction, const Vectorf* cursorFb)
         clampCamera();
     }
 
-    if (m_loader->getImageInfo().isVector)
+    if (isRerasterizable())
     {
         m_rerasterPending      = true;
         m_rerasterDebounceTime = timing::seconds() + 0.3;
@@ -1205,14 +1604,16 @@ void cViewer::updateScale(ScaleDirection direction, const Vectorf* cursorFb)
 
 void cViewer::updateFiltering()
 {
-    const int scale = m_scale.getScalePercent();
-    if (scale >= 100 && scale % 100 == 0)
-    {
-        m_image->useFilter(false);
-    }
-    else
+    const int scale       = m_scale.getScalePercent();
+    const bool isFiltered = (scale >= 100 && scale % 100 == 0) == false;
+    m_image->useFilter(isFiltered);
+    m_frames->useFilter(isFiltered);
+    for (auto* detail : { m_detail.get(), m_detailNext.get() })
     {
-        m_image->useFilter(true);
+        if (detail != nullptr)
+        {
+            detail->useFilter(isFiltered);
+        }
     }
 }
 
@@ -1317,7 +1718,7 @@ void cViewer::resetViewAndUpdate(int scalePercent)
     m_camera          = Vectorf();
     m_config.fitImage = false;
 
-    if (m_loader->getImageInfo().isVector)
+    if (isRerasterizable())
     {
         m_rerasterPending      = true;
         m_rerasterDebounceTime = timing::seconds() + 0.3;
@@ -1331,18 +1732,58 @@ void cViewer::loadFirstImage()
 {
     auto path = m_filesList->getFirstName();
     loadImage(path);
+    schedulePrefetch(1);
 }
 
 void cViewer::loadLastImage()
 {
     auto path = m_filesList->getLastName();
     loadImage(path);
+    schedulePrefetch(-1);
 }
 
 void cViewer::navigateImage(int step)
 {
     auto path = m_filesList->getName(step);
     loadImage(path);
+    schedulePrefetch(step);
+}
+
+void cViewer::schedulePrefetch(int direction)
+{
+    const auto current = m_filesList->getName();
+    if (current == nullptr)
+    {
+        return;
+    }
+
+    // Interleave neighbours by distance, navigation direction first.
+    const int ahead  = direction < 0 ? -1 : 1;
+    const auto count = std::max(m_config.prefetchAhead, m_config.prefetchBehind);
+
+    std::vector<std::string> paths;
+    auto add = [&](int delta) {
+        auto path = m_filesList->peekName(delta);
+        if (path != nullptr && ::strcmp(path, current) != 0
+            && std::find(paths.begin(), paths.end(), path) == paths.end())
+        {
+            paths.emplace_back(path);
+        }
+    };
+
+    for (uint32_t i = 1; i <= count; i++)
+    {
+        if (i <= m_config.prefetchAhead)
+        {
+            add(ahead * static_cast<int>(i));
+        }
+        if (i <= m_config.prefetchBehind)
+        {
+            add(-ahead * static_cast<int>(i));
+        }
+    }
+
+    m_loader->prefetch(paths);
 }
 
 void cViewer::loadImage(const char* path)
@@ -1355,14 +1796,29 @@ void cViewer::loadImage(const char* path)
     m_config.fitImage = m_config.keepScale == false && m_config.fitImage;
 
     m_anim.reset();
+    m_frames->stop();
     m_rerasterPending = false;
-    m_vectorBaseSize  = {};
+    m_baseSize        = {};
     m_imageInfo       = {};
+    m_levels.clear();
+    resetDetail();
     m_image->reset();
     m_preview.reset();
     m_previewData = {};
 
-    m_loader->loadImage(path);
+    // A JPEG shown fit into the window is decoded just large enough. The
+    // window may grow up to the screen for it.
+    uint32_t fitWidth  = 0;
+    uint32_t fitHeight = 0;
+    if (m_config.fitImage)
+    {
+        const auto centralFb = getCentralAreaFbSize();
+        const auto screen    = m_window.getScreenSize();
+        fitWidth             = static_cast<uint32_t>(std::ceil(std::max(centralFb.x, screen.x * m_ratio.x)));
+        fitHeight            = static_cast<uint32_t>(std::ceil(std::max(centralFb.y, screen.y * m_ratio.y)));
+    }
+
+    m_loader->loadImage(path, fitWidth, fitHeight);
     updateInfobar();
 }
 
@@ -1384,10 +1840,81 @@ void cViewer::loadSubImage(int subStep)
 
     m_anim.timerStarted = false;
     m_imageInfo         = {};
+    m_frames->stop();
+    resetDetail();
 
     m_loader->loadSubImage(next);
 }
 
+std::unique_ptr<cQuadImage> cViewer::createImage() const
+{
+    auto image = std::make_unique<cQuadImage>();
+    image->setUploadBudget(m_config.uploadBudgetMs, static_cast<size_t>(m_config.uploadBudgetMb) * 1024 * 1024);
+    image->setGpuBudget(static_cast<size_t>(m_config.gpuMemoryMb) * 1024 * 1024);
+
+    return image;
+}
+
+void cViewer::startFramesAhead()
+{
+    if (m_anim.autoAdvance == false || m_frames->isActive())
+    {
+        return;
+    }
+
+    const auto& chunk = m_loader->getChunkData();
+    const auto& info  = m_loader->getImageInfo();
+    if (chunk.isCompressedTexture || ycbcr::isPlanar(chunk.format))
+    {
+        return;
+    }
+
+    const size_t budget = static_cast<size_t>(m_config.animationMemoryMb) * 1024 * 1024;
+    const auto depth    = cAnimationFrames::calculateDepth(chunk.width, chunk.height, chunk.bpp, info.images, budget);
+    if (depth != 0 && m_loader->startAnimation(depth))
+    {
+        m_frames->start(depth, info.images, info.current, info.delay);
+        updateFiltering();
+    }
+}
+
+void cViewer::stopFramesAhead()
+{
+    m_frames->stop();
+    m_loader->stopAnimation();
+}
+
+void cViewer::updateFramesAhead()
+{
+    if (m_frames->update(*m_loader, m_loader->getChunkData()) == false)
+    {
+        // Back to decoding frame by frame from the one on screen.
+        stopFramesAhead();
+        return;
+    }
+
+    const double now = timing::seconds();
+    if (now < m_anim.nextFrameTime || m_frames->isNextReady() == false)
+    {
+        return;
+    }
+
+    uint32_t frame = 0;
+    uint32_t delay = 0;
+    m_frames->flip(m_image, frame, delay);
+    m_loader->setCurrentFrame(frame, delay);
+
+    // Count from the deadline so late flips don't add up, resync if far behind.
+    m_anim.nextFrameTime += delay * 0.001;
+    if (m_anim.nextFrameTime < now)
+    {
+        m_anim.nextFrameTime = now + delay * 0.001;
+    }
+
+    updateInfobar();
+    requestRedraw();
+}
+
 void cViewer::updateInfobar()
 {
     const auto path = m_filesList->getName();
@@ -1401,9 +1928,26 @@ void cViewer::updateInfobar()
         const auto& chunk = m_loader->getChunkData();
         const auto& info  = m_loader->getImageInfo();
         m_infoBar->setFormat(m_loader->getImageType());
-        m_infoBar->setDimensions(chunk.width, chunk.height, info.bppImage);
+        // A window read of a pyramid level stands for the whole image.
+        if (info.window.levelWidth != 0)
+        {
+            m_infoBar->setDimensions(info.fullWidth, info.fullHeight, info.bppImage);
+        }
+        else
+        {
+            m_infoBar->setDimensions(chunk.width, chunk.height, info.bppImage);
+        }
         m_infoBar->setSubImage(info.current, info.images);
-        m_infoBar->setMemory(info.fileSize, chunk.bitmap.size() + m_image->getGpuMemory());
+
+        size_t gpuMemory = m_image->getGpuMemory();
+        for (const auto* detail : { m_detail.get(), m_detailNext.get() })
+        {
+            if (detail != nullptr)
+            {
+                gpuMemory += detail->getGpuMemory();
+            }
+        }
+        m_infoBar->setMemory(info.fileSize, chunk.bitmap.size() + gpuMemory);
     }
     else if (m_imageInfo.formatName != nullptr)
     {
@@ -1474,6 +2018,15 @@ void cViewer::updatePixelInfo(const Vectorf& pos)
     m_pixelPopup->setPixelInfo(pixelInfo);
 }
 
+void cViewer::setExposure(float stops)
+{
+    render::setExposure(stops);
+    if (m_config.showPixelInfo)
+    {
+        updatePixelInfo(m_lastMouse);
+    }
+}
+
 void cViewer::updateCursorState(bool show)
 {
     auto cursorPos = m_window.getCursorPos();
@@ -1486,7 +2039,8 @@ void cViewer::updateCursorState(bool show)
 
 void cViewer::startLoading()
 {
-    if (m_anim.isAnimated == false && m_loader->getMode() != cImageLoader::Mode::Rerasterize)
+    const auto mode = m_loader->getMode();
+    if (m_anim.isAnimated == false && mode != cImageLoader::Mode::Rerasterize && mode != cImageLoader::Mode::Window)
     {
         m_progress->show();
     }
@@ -1505,8 +2059,8 @@ void cViewer::startLoading()
 
 void cViewer::onImageInfo(const sChunkData& chunk, const sImageInfo& info)
 {
-    m_imageInfo.width      = chunk.width;
-    m_imageInfo.height     = chunk.height;
+    m_imageInfo.width      = info.fullWidth != 0 ? info.fullWidth : chunk.width;
+    m_imageInfo.height     = info.fullWidth != 0 ? info.fullHeight : chunk.height;
     m_imageInfo.bpp        = info.bppImage;
     m_imageInfo.size       = info.fileSize;
     m_imageInfo.formatName = info.formatName;
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "Common/Callbacks.h"
+#include "Common/ImageInfo.h"
 #include "Common/Scale.h"
 #include "Types/Types.h"
 #include "Types/Vector.h"
@@ -17,7 +18,9 @@
 
 #include <atomic>
 #include <memory>
+#include <vector>
 
+class cAnimationFrames;
 class cCheckerboard;
 class cDeletionMark;
 class cExifPopup;
@@ -46,6 +49,11 @@ public:
     bool isUploading() const;
     void setFps(float fps);
 
+    // The frame is redrawn only when something on screen changed. Between
+    // redraws the main loop sleeps up to getWaitTimeout() seconds.
+    bool needsRender() const;
+    double getWaitTimeout() const;
+
     void onRender();
     void onUpdate();
     void processDeferred();
@@ -68,6 +76,9 @@ private:
     void onMouseScroll(const Vectorf& offset);
     void onFileDrop(const StringsList& paths);
 
+    void requestRedraw();
+    void wakeUp();
+
     // Loader callback handlers
     void startLoading();
     void onImageInfo(const sChunkData& chunk, const sImageInfo& info);
@@ -78,6 +89,8 @@ private:
 
     // Main-thread handlers for async loader events (polled from onUpdate)
     void handlePreviewReady();
+    void setImageBuffer(const sChunkData& chunk, uint32_t bandHeight);
+    void setRasterBuffer(const sChunkData& chunk, uint32_t bandHeight);
     void handleBitmapAllocated();
     void handleImageReady();
     void applyExifOrientation(uint16_t orientation);
@@ -90,8 +103,13 @@ private:
     void loadFirstImage();
     void loadLastImage();
     void navigateImage(int step);
+    void schedulePrefetch(int direction);
     void loadImage(const char* path);
     void loadSubImage(int subStep);
+    std::unique_ptr<cQuadImage> createImage() const;
+    void startFramesAhead();
+    void stopFramesAhead();
+    void updateFramesAhead();
     void calculateScale();
     Vectorf getCentralAreaFbSize() const;
     Vectorf getCentralAreaFbCenter() const;
@@ -102,6 +120,11 @@ private:
         Down,
     };
     void updateScale(ScaleDirection direction, const Vectorf* cursorFb = nullptr);
+    bool isRerasterizable() const;
+    void updateDetail();
+    void uploadDetail();
+    void renderDetail(cQuadImage* detail, const sImageInfo::Window& window);
+    void resetDetail();
     float getRenderScale() const;
     void updateFiltering();
     void updateInfobar();
@@ -119,6 +142,7 @@ private:
     Vectorf calculateMousePosition(const Vectorf& pos) const;
     void updateMousePosition();
     void updateCursorState(bool visible);
+    void setExposure(float stops);
     void enablePixelInfo(bool show);
 
 private:
@@ -127,6 +151,9 @@ private:
     sWindowEvents m_windowEvents;
     sCallbacks m_callbacks;
 
+    std::atomic<bool> m_dirty{ true };
+    uint32_t m_settleFrames = 0;
+
     Vectorf m_ratio;
     std::atomic<bool> m_previewReady{ false };
     sPreviewData m_previewData;
@@ -175,10 +202,20 @@ private:
 
     bool m_rerasterPending        = false;
     double m_rerasterDebounceTime = 0.0;
-    Vectori m_vectorBaseSize;
+    Vectori m_baseSize; // natural size when m_image holds a raster of another size (vector, scaled-down JPEG, pyramid level)
+    std::vector<sImageInfo::Level> m_levels; // pyramid levels of the shown page, copied when its raster is allocated
 
     std::unique_ptr<cQuadImage> m_image;
     std::unique_ptr<cQuadImage> m_preview; // lazy: created on preview ready, destroyed when full-res upload completes
+
+    // Window of a pyramid level finer than m_image, drawn over it. The next
+    // one uploads while the current one stays on screen.
+    std::unique_ptr<cQuadImage> m_detail;
+    std::unique_ptr<cQuadImage> m_detailNext;
+    sImageInfo::Window m_detailWindow;
+    sImageInfo::Window m_detailNextWindow;
+
+    std::unique_ptr<cAnimationFrames> m_frames;
     std::unique_ptr<cFilesList> m_filesList;
     std::unique_ptr<cFileBrowser> m_fileSelector;
     std::unique_ptr<cProgress> m_progress;
@@ -496,6 +496,23 @@ void cWindow::pollEvents()
     glfwPollEvents();
 }
 
+void cWindow::waitEvents(double timeout)
+{
+    if (timeout > 0.0)
+    {
+        glfwWaitEventsTimeout(timeout);
+    }
+    else
+    {
+        glfwPollEvents();
+    }
+}
+
+void cWindow::postEmptyEvent()
+{
+    glfwPostEmptyEvent();
+}
+
 void cWindow::swapBuffers()
 {
     if (m_window != nullptr)
@@ -72,6 +72,10 @@ public:
 
     // Main loop operations
     void pollEvents();
+    // Sleeps until an event arrives or timeout (seconds) passes.
+    void waitEvents(double timeout);
+    // Wakes up waitEvents(), may be called from any thread.
+    void postEmptyEvent();
     void swapBuffers();
 
     // For ImGui and renderer init
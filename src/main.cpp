@@ -9,6 +9,7 @@
 
 #include "Common/Config.h"
 #include "Common/Helpers.h"
+#include "Common/ThreadPool.h"
 #include "Common/Timing.h"
 #include "Log/Log.h"
 #include "Types/Types.h"
@@ -133,6 +134,8 @@ void AddFile(const char* filename)
 
 int main(int argc, char* argv[])
 {
+    const auto startTime = timing::seconds();
+
     ::setlocale(LC_ALL, "");
 
     sConfig config;
@@ -264,6 +267,7 @@ int main(int argc, char* argv[])
     }
 
     cLog::setDebugEnabled(config.debug);
+    cThreadPool::configure(config.workerThreads);
 
     cWindow window;
     if (window.init(config) == false)
@@ -291,15 +295,51 @@ int main(int argc, char* argv[])
     uint32_t frames = 0;
     auto fpsTimer = timing::seconds();
 
+    // Start of the current stretch without redraws, reported in --debug.
+    double idleStart = -1.0;
+    double idleCpu = 0.0;
+    bool isFirstFrame = true;
+
     while (window.shouldClose() == false)
     {
+        window.waitEvents(viewer.getWaitTimeout());
+
         const auto timeStart = timing::seconds();
 
-        window.pollEvents();
         viewer.processDeferred();
         viewer.onUpdate();
+
+        if (viewer.needsRender() == false)
+        {
+            if (idleStart < 0.0)
+            {
+                idleStart = timeStart;
+                idleCpu = timing::cpuSeconds();
+            }
+            continue;
+        }
+
+        if (idleStart >= 0.0)
+        {
+            const auto idleTime = timeStart - idleStart;
+            if (config.debug && idleTime >= 1.0)
+            {
+                cLog::Debug("idle {:.1f} s, cpu {:.2f}%", idleTime,
+                            (timing::cpuSeconds() - idleCpu) * 100.0 / idleTime);
+            }
+            idleStart = -1.0;
+            frames = 0;
+            fpsTimer = timeStart;
+        }
+
         viewer.onRender();
 
+        if (isFirstFrame)
+        {
+            isFirstFrame = false;
+            cLog::Debug("first frame: {:.1f} ms", (timing::seconds() - startTime) * 1000.0);
+        }
+
         frames++;
         const auto now = timing::seconds();
         if (now - fpsTimer >= 1.0)